@@ -0,0 +1,13 @@
+QT       += core gui widgets testlib
+
+# testcase добавляет цель "make check", запускающую бенчмарк
+CONFIG += c++17 console testcase
+CONFIG -= app_bundle
+
+TARGET = mainscene_bench
+
+# Исходники приложения подключаются целиком, кроме main.cpp
+include(../sources.pri)
+
+SOURCES += \
+    tst_mainscenebench.cpp
@@ -0,0 +1,745 @@
+/**
+* @file
+* @brief Бенчмарк путей обновления MainScene
+*
+* Сцена создаётся, но никогда не показывается. По умолчанию используется платформа offscreen,
+* поэтому бенчмарк запускается и на машинах без дисплея.
+*
+* Помимо стандартного вывода QBENCHMARK, для каждой операции замеряется время одного вызова
+* и количество выделений памяти. Эти числа можно сохранить в базовый файл и сравнивать с ним
+* последующие запуски:
+*
+*     mainscene_bench --write-baseline baseline.json
+*     mainscene_bench --baseline baseline.json [--tolerance 20]
+*
+* При сравнении бенчмарк завершается с ненулевым кодом, если время операции выросло больше
+* допуска (в процентах) или выросло количество выделений памяти.
+*
+* Замеры отрисовки выполняются в обоих режимах MainView: paintFull рисует окно в изображение,
+* sliderDrag, idle и swing показывают окно на платформе offscreen. Для отчёта "до и после" оба режима
+* попадают в один базовый файл:
+*
+*     mainscene_bench paintFull sliderDrag idle swing --write-baseline render.json
+*/
+#include <QtTest>
+#include <QApplication>
+#include <QTemporaryDir>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QFile>
+#include <QMap>
+#include <QImage>
+#include <QPainter>
+#include <QPixmapCache>
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include "mainscene.h"
+#include "mainview.h"
+#include "metrics.h"
+#include "devicelink.h"
+#include "modbus.h"
+#include "driverpool.h"
+
+/**
+ * @defgroup allocCounter Счётчик выделений памяти
+ * @brief Подсчёт всех выделений памяти в процессе
+ *
+ * На glibc перехватывается malloc, поэтому учитываются и буферы QString/QVector.
+ * На остальных платформах заменяется глобальный operator new.
+ */
+/// @{
+namespace {
+std::atomic<quint64> allocCount{0};
+}
+
+#if defined(__GLIBC__)
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t n, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size)
+{
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+}
+#else
+void *operator new(std::size_t size)
+{
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    if (void *ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+void *operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { std::free(ptr); }
+#endif
+/// @}
+
+/**
+ * @class BlockingDriver
+ * @brief Драйвер, опрос которого занимает заданное время (медленная шина прибора)
+ */
+class BlockingDriver : public SensorDriver
+{
+public:
+    /**
+     * @param channel Выдаваемая величина
+     * @param period Интервал опроса, мс
+     * @param latency Длительность опроса, мс
+     */
+    BlockingDriver(SensorSample::Channel channel, int period, int latency)
+        : channel(channel), period(period), latency(latency) {}
+    bool open() override { return true; }
+    int poll(SensorSample *out, int) override
+    {
+        QThread::msleep(ulong(latency));
+        out[0] = {channel, 0, 0};
+        return 1;
+    }
+    int interval() const override { return period; }
+    QString description() const override { return "blocking"; }
+
+private:
+    SensorSample::Channel channel;
+    int period;
+    int latency;
+};
+
+/**
+ * @class DropFirstDevice
+ * @brief Имитатор кондиционера, теряющий первую команду
+ */
+class DropFirstDevice : public SimulatedDevice
+{
+public:
+    using SimulatedDevice::SimulatedDevice;
+    void send(const QByteArray &data) override
+    {
+        if (dropped)
+            SimulatedDevice::send(data);
+        dropped = true;
+    }
+
+private:
+    bool dropped = false;
+};
+
+/// @brief Результат замера одной операции
+struct OpStats {
+    /// Среднее время одного вызова, нс
+    double nsPerOp;
+    /// Среднее количество выделений памяти за вызов
+    double allocsPerOp;
+};
+
+/**
+ * @class MainSceneBench
+ * @brief Набор бенчмарков для MainScene
+ */
+class MainSceneBench : public QObject
+{
+    Q_OBJECT
+public:
+    /// Результаты замеров всех операций, заполняются по мере выполнения тестов
+    static QMap<QString, OpStats> results;
+
+private:
+    /// Количество вызовов при собственном замере операции
+    static constexpr int ITERATIONS = 200;
+    /// Длительность имитации перетаскивания слайдера и простоя, мс
+    static constexpr int WINDOW = 1000;
+    /// Интервал событий перемещения при перетаскивании (сенсорная панель, ~120 Гц), мс
+    static constexpr int DRAGSTEP = 8;
+    /// Временный каталог, чтобы не читать и не портить preferences.xml разработчика
+    QTemporaryDir *tmpDir = nullptr;
+    /// Исходный рабочий каталог
+    QString prevDir;
+    /// Тестируемая сцена
+    MainScene *scene = nullptr;
+    /// Счётчик для генерации меняющихся значений
+    int tick = 0;
+
+    /**
+     * @brief Замер времени и выделений памяти для операции
+     * @param name Название операции в базовом файле
+     * @param op Операция
+     */
+    void record(const QString &name, const std::function<void()> &op);
+    /// @brief Имитация нового значения с датчика (одной транзакцией, как в SensorHub)
+    void nextSensorValue();
+    /**
+     * @brief Замер времени отрисовки за окно времени
+     *
+     * Окно показывается в заданном режиме, step вызывается каждые DRAGSTEP мс в течение WINDOW мс.
+     * Замер - время отрисовки за секунду и количество выделений памяти на шаг. Проверки внутри
+     * завершают только этот метод, поэтому вызывающий записывает замер, лишь если
+     * QTest::currentTestFailed() не установлен.
+     * @param name Название операции для вывода
+     * @param mode Режим отрисовки
+     * @param step Действие на каждом шаге, может быть пустым
+     * @param stats Замер
+     */
+    void measurePaint(const QString &name, MainView::RenderMode mode, const std::function<void()> &step, OpStats *stats);
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void sensorUpdate();
+    void updateValues();
+    void updatePos();
+    void placeAllBlocks();
+    void applyTheme();
+    void changeTempUnit();
+    void changePressureUnit();
+    void changeResolution();
+    void liveResize();
+    void deviceBurst();
+    void deviceSuperseded();
+    void modbusParse();
+    void modbusFleet();
+    void driverPool();
+    void staticLayer_data();
+    void staticLayer();
+    void paintFull_data();
+    void paintFull();
+    void sliderDrag_data();
+    void sliderDrag();
+    void idle_data();
+    void idle();
+    void swing_data();
+    void swing();
+};
+
+QMap<QString, OpStats> MainSceneBench::results;
+
+void MainSceneBench::record(const QString &name, const std::function<void()> &op)
+{
+    /// Прогрев: первые вызовы заполняют кэши шрифтов и стилей
+    for (int i = 0; i < 3; ++i)
+        op();
+
+    QElapsedTimer timer;
+    quint64 allocsBefore = allocCount.load(std::memory_order_relaxed);
+    timer.start();
+    for (int i = 0; i < ITERATIONS; ++i)
+        op();
+    qint64 elapsed = timer.nsecsElapsed();
+    quint64 allocsAfter = allocCount.load(std::memory_order_relaxed);
+
+    results[name] = { double(elapsed) / ITERATIONS, double(allocsAfter - allocsBefore) / ITERATIONS };
+}
+
+void MainSceneBench::nextSensorValue()
+{
+    ++tick;
+    Preferences::Transaction transaction(scene->prefs);
+    scene->prefs->setTempVal(20.0 + (tick % 100) * 0.01);
+    scene->prefs->setHumidityVal(40.0 + (tick % 50) * 0.1);
+    scene->prefs->setPressureVal(760.0 + (tick % 20));
+}
+
+void MainSceneBench::measurePaint(const QString &name, MainView::RenderMode mode, const std::function<void()> &step, OpStats *stats)
+{
+    MainView view(scene);
+    view.setRenderMode(mode);
+    view.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&view));
+    QTest::qWait(100);
+
+    Metrics::Summary before = Metrics::summary(Metrics::ScenePaint);
+    quint64 allocsBefore = allocCount.load(std::memory_order_relaxed);
+    int steps = 0;
+    QElapsedTimer window;
+    window.start();
+    while (window.elapsed() < WINDOW) {
+        step();
+        ++steps;
+        QTest::qWait(DRAGSTEP);
+    }
+    /// Последний отложенный кадр режима LowPower тоже учитывается
+    QTest::qWait(100);
+    quint64 allocsAfter = allocCount.load(std::memory_order_relaxed);
+    Metrics::Summary after = Metrics::summary(Metrics::ScenePaint);
+    quint64 frames = after.count - before.count;
+    /// nsPerOp здесь - время отрисовки за секунду окна
+    *stats = { double(after.sum - before.sum) * 1000.0 / WINDOW, double(allocsAfter - allocsBefore) / steps };
+    qInfo("%-24s %6llu frames, %8.2f ms paint per second", qPrintable(name), frames,
+          double(after.sum - before.sum) / 1e6 * 1000.0 / WINDOW);
+    view.setRenderMode(MainView::Default);
+}
+
+void MainSceneBench::initTestCase()
+{
+    tmpDir = new QTemporaryDir;
+    QVERIFY(tmpDir->isValid());
+    prevDir = QDir::currentPath();
+    QDir::setCurrent(tmpDir->path());
+    /// Сцена создаётся с настройками по умолчанию и не показывается
+    scene = new MainScene;
+}
+
+void MainSceneBench::cleanupTestCase()
+{
+    delete scene;
+    QDir::setCurrent(prevDir);
+    delete tmpDir;
+}
+
+void MainSceneBench::sensorUpdate()
+{
+    /// Обычный путь: элементы обновляются по сигналам изменившихся полей
+    record("sensorUpdate", [this] { nextSensorValue(); });
+    QBENCHMARK {
+        nextSensorValue();
+    }
+}
+
+void MainSceneBench::updateValues()
+{
+    record("updateValues", [this] { nextSensorValue(); scene->updateValues(); });
+    QBENCHMARK {
+        nextSensorValue();
+        scene->updateValues();
+    }
+}
+
+void MainSceneBench::updatePos()
+{
+    record("updatePos", [this] { nextSensorValue(); scene->updateValues(); scene->updatePos(); });
+    QBENCHMARK {
+        nextSensorValue();
+        scene->updateValues();
+        scene->updatePos();
+    }
+}
+
+void MainSceneBench::placeAllBlocks()
+{
+    record("placeAllBlocks", [this] { scene->placeAllBlocks(); });
+    QBENCHMARK {
+        scene->placeAllBlocks();
+    }
+}
+
+void MainSceneBench::applyTheme()
+{
+    /// Переключение питания - самое частое действие, поэтому замеряется именно оно
+    record("applyTheme", [this] { scene->togglePower(); });
+    QBENCHMARK {
+        scene->togglePower();
+    }
+}
+
+void MainSceneBench::changeTempUnit()
+{
+    record("changeTempUnit", [this] { scene->changeTempUnit(); });
+    QBENCHMARK {
+        scene->changeTempUnit();
+    }
+}
+
+void MainSceneBench::changePressureUnit()
+{
+    record("changePressureUnit", [this] { scene->changePressureUnit(); });
+    QBENCHMARK {
+        scene->changePressureUnit();
+    }
+}
+
+void MainSceneBench::changeResolution()
+{
+    record("changeResolution", [this] { scene->changeResolution(); });
+    QBENCHMARK {
+        scene->changeResolution();
+    }
+}
+
+void MainSceneBench::liveResize()
+{
+    /// Перетаскивание края окна: ширина меняется с шагом 8 пикселей до +224 и обратно
+    int step = 0;
+    auto resize = [this, &step] {
+        int offset = step++ % 56;
+        int dx = offset < 28 ? offset : 56 - offset;
+        scene->prefs->setResolution(QSize(800 + dx * 8, 600));
+    };
+    record("liveResize", resize);
+    QBENCHMARK {
+        resize();
+    }
+    scene->prefs->setResolution(QSize(800, 600));
+}
+
+void MainSceneBench::deviceBurst()
+{
+    /// Серия из 20 нажатий "+" уходит кондиционеру одной командой
+    SimulatedDevice *sim = new SimulatedDevice(0);
+    DeviceLink link(scene->prefs, sim);
+    QVERIFY(link.open());
+    auto burst = [this] {
+        for (int i = 0; i < 20; ++i)
+            scene->onPlusTargetTemp();
+    };
+    QElapsedTimer timer;
+    timer.start();
+    burst();
+    qint64 elapsed = timer.nsecsElapsed();
+    QTRY_COMPARE_WITH_TIMEOUT(link.stats().acknowledged, quint64(1), DeviceLink::MAXDELAY * 2);
+    QCOMPARE(sim->commandCount(), 1);
+    QCOMPARE(sim->state().targetTemp, Units::convert(scene->prefs->getTargetTemp(), scene->prefs->getTempUnit(), Units::TempUnit::Celsius));
+    /// Время серии в интерфейсе: отправка не должна в него попадать
+    results["deviceBurst"] = { double(elapsed) / 20, 0 };
+    for (int i = 0; i < 20; ++i)
+        scene->onMinusTargetTemp();
+}
+
+void MainSceneBench::deviceSuperseded()
+{
+    /// Первая команда теряется, вторая с тем же полем подтверждается: повтор первой не должен вернуть старое значение
+    DropFirstDevice *sim = new DropFirstDevice(0);
+    DeviceLink link(scene->prefs, sim);
+    QVERIFY(link.open());
+    scene->onPlusTargetTemp();
+    QTRY_COMPARE_WITH_TIMEOUT(link.stats().commands, quint64(1), DeviceLink::MAXDELAY * 2);
+    scene->onPlusTargetTemp();
+    QTRY_COMPARE_WITH_TIMEOUT(link.stats().acknowledged, quint64(1), DeviceLink::MAXDELAY * 2);
+    QTRY_COMPARE_WITH_TIMEOUT(link.inFlightCount(), 0, DeviceLink::TIMEOUT * 2);
+    QCOMPARE(link.stats().retries, quint64(0));
+    QCOMPARE(link.stats().superseded, quint64(1));
+    QCOMPARE(sim->commandCount(), 1);
+    QCOMPARE(sim->state().targetTemp, Units::convert(scene->prefs->getTargetTemp(), scene->prefs->getTempUnit(), Units::TempUnit::Celsius));
+    scene->onMinusTargetTemp();
+    scene->onMinusTargetTemp();
+}
+
+void MainSceneBench::modbusParse()
+{
+    /// Пачка из 1000 ответов по 4 регистра, как после цикла опроса устройств за одним шлюзом
+    const quint16 regs[Modbus::Map::HoldingCount] = { 220, 150, 1, 0 };
+    QByteArray stream;
+    uchar frame[Modbus::MAXFRAME];
+    for (int i = 0; i < 1000; ++i) {
+        int size = Modbus::encodeReadReply(frame, quint16(i + 1), quint8(i % Modbus::MAXUNITS + 1),
+                                           Modbus::ReadHoldingRegisters, regs, Modbus::Map::HoldingCount);
+        stream.append(reinterpret_cast<const char*>(frame), size);
+    }
+    quint64 sum = 0;
+    /// Кадры разбираются на месте, выделений памяти быть не должно
+    auto parse = [&stream, &sum] {
+        const uchar *data = reinterpret_cast<const uchar*>(stream.constData());
+        int offset = 0;
+        int used;
+        Modbus::Frame reply;
+        while ((used = Modbus::parseFrame(data + offset, stream.size() - offset, &reply)) > 0) {
+            for (int r = 0; r < reply.registerCount(); ++r)
+                sum += reply.registerAt(r);
+            offset += used;
+        }
+    };
+    record("modbusParse", parse);
+    QVERIFY(sum > 0);
+    QBENCHMARK {
+        parse();
+    }
+}
+
+void MainSceneBench::modbusFleet()
+{
+    /// 500 кондиционеров за встроенными шлюзами: цикл опроса должен укладываться в интервал 1 с
+    constexpr int UNITS = 500;
+    constexpr int CYCLES = 5;
+    QObject simulators;
+    ModbusPoller poller;
+    int assigned = 0;
+    while (assigned < UNITS) {
+        ModbusServer *server = new ModbusServer(qMin(Modbus::MAXUNITS, UNITS - assigned), &simulators);
+        QVERIFY(server->listen());
+        for (int id = 1; id <= server->unitCount(); ++id, ++assigned)
+            poller.addUnit("127.0.0.1", server->port(), quint8(id));
+    }
+    int finished = 0;
+    connect(&poller, &ModbusPoller::cycleFinished, [&finished] { ++finished; });
+    /// Соединения открываются, а циклы запускаются вручную, без таймера опроса
+    poller.start();
+    poller.stop();
+    QTRY_VERIFY_WITH_TIMEOUT(poller.isConnected(), 5000);
+
+    Metrics::Summary before = Metrics::summary(Metrics::ModbusCycle);
+    quint64 allocsBefore = allocCount.load(std::memory_order_relaxed);
+    for (int c = 0; c < CYCLES; ++c) {
+        poller.poll();
+        QTRY_COMPARE_WITH_TIMEOUT(finished, c + 1, ModbusPoller::INTERVAL);
+    }
+    quint64 allocsAfter = allocCount.load(std::memory_order_relaxed);
+    Metrics::Summary after = Metrics::summary(Metrics::ModbusCycle);
+
+    QCOMPARE(poller.stats().replies, quint64(UNITS * 2 * CYCLES));
+    for (int i = 0; i < UNITS; ++i)
+        QVERIFY(poller.unit(i).online());
+    double nsPerCycle = double(after.sum - before.sum) / CYCLES;
+    QVERIFY(nsPerCycle < ModbusPoller::INTERVAL * 1e6);
+    /// nsPerOp здесь - время одного цикла опроса всего парка
+    results["modbusFleet"] = { nsPerCycle, double(allocsAfter - allocsBefore) / CYCLES };
+    qInfo("%-24s %6d units, %8.2f ms per cycle", "modbusFleet", UNITS, nsPerCycle / 1e6);
+}
+
+void MainSceneBench::driverPool()
+{
+    /// Два потока: медленный драйвер (опрос 80 мс) не должен задерживать два быстрых (каждые 20 мс)
+    constexpr int FAST = 20;
+    DriverPool pool(2);
+    pool.addDriver(new BlockingDriver(SensorSample::Pressure, 100, 80));
+    pool.addDriver(new BlockingDriver(SensorSample::Temperature, FAST, 1));
+    pool.addDriver(new BlockingDriver(SensorSample::Humidity, FAST, 1));
+    int fastSamples = 0;
+    connect(&pool, &SensorSource::sampleReady, [&fastSamples](const SensorSample &sample) {
+        if (sample.channel != SensorSample::Pressure)
+            ++fastSamples;
+    });
+    QVERIFY(pool.start());
+    QTest::qWait(WINDOW);
+    int polls = fastSamples;
+    /// Без перехвата третий драйвер стоял бы за медленным в очереди первого потока
+    QVERIFY(polls >= 2 * WINDOW / FAST * 7 / 10);
+    QVERIFY(pool.stolenPolls() > 0);
+    /// nsPerOp здесь - средний интервал между опросами быстрого драйвера
+    results["driverPool"] = { 2.0 * WINDOW * 1e6 / qMax(1, polls), 0 };
+    qInfo("%-24s %6d fast polls, %6llu stolen", "driverPool", polls, pool.stolenPolls());
+}
+
+void MainSceneBench::staticLayer_data()
+{
+    QTest::addColumn<QString>("cacheDir");
+    QTest::addColumn<bool>("memory");
+    /// render - изображение рисуется заново, disk - читается с диска, memory - берётся из QPixmapCache
+    QTest::newRow("render") << QString() << false;
+    QTest::newRow("disk") << StaticLayer::CACHEDIR << false;
+    QTest::newRow("memory") << StaticLayer::CACHEDIR << true;
+}
+
+void MainSceneBench::staticLayer()
+{
+    /// Выбор изображения слоя неизменяемых элементов, как при запуске или смене темы
+    QFETCH(QString, cacheDir);
+    QFETCH(bool, memory);
+    scene->ui_staticLayer->setCacheDir(cacheDir);
+    /// Размер слоя - текущий, как после окончания изменения размера окна, иначе слой только приостанавливается
+    scene->ui_staticLayer->rebuild(scene->prefs->getResolution(), scene->backgroundBrush());
+    auto op = [&] {
+        if (!memory)
+            QPixmapCache::clear();
+        scene->ui_staticLayer->invalidate();
+        scene->updateStaticLayer();
+    };
+    record(QString("staticLayer_") + QTest::currentDataTag(), op);
+    QBENCHMARK {
+        op();
+    }
+    scene->ui_staticLayer->setCacheDir(StaticLayer::CACHEDIR);
+}
+
+void MainSceneBench::paintFull_data()
+{
+    QTest::addColumn<int>("mode");
+    QTest::newRow("default") << int(MainView::Default);
+    QTest::newRow("lowPower") << int(MainView::LowPower);
+}
+
+void MainSceneBench::paintFull()
+{
+    /// Полная отрисовка окна в изображение, как при открытии окна или смене разрешения
+    QFETCH(int, mode);
+    MainView view(scene);
+    view.setRenderMode(MainView::RenderMode(mode));
+    QImage target(view.size(), QImage::Format_ARGB32_Premultiplied);
+    auto op = [&] {
+        QPainter painter(&target);
+        view.render(&painter);
+    };
+    record(QString("paintFull_") + QTest::currentDataTag(), op);
+    QBENCHMARK {
+        op();
+    }
+    view.setRenderMode(MainView::Default);
+}
+
+void MainSceneBench::sliderDrag_data()
+{
+    paintFull_data();
+}
+
+void MainSceneBench::sliderDrag()
+{
+    /// Угол меняется на каждом событии перемещения, как при перетаскивании слайдера пальцем
+    QFETCH(int, mode);
+    int angle = 0;
+    QString name = QString("sliderDrag_") + QTest::currentDataTag();
+    OpStats stats = {};
+    measurePaint(name, MainView::RenderMode(mode), [&] {
+        angle = angle >= Preferences::ACANGLEMAX ? Preferences::ACANGLEMIN : angle + 1;
+        scene->prefs->setAcAngle(angle);
+    }, &stats);
+    if (QTest::currentTestFailed())
+        return;
+    results[name] = stats;
+}
+
+void MainSceneBench::idle_data()
+{
+    paintFull_data();
+}
+
+void MainSceneBench::idle()
+{
+    /// Простой: пользователь ничего не трогает, меняются только показания датчиков
+    QFETCH(int, mode);
+    QString name = QString("idle_") + QTest::currentDataTag();
+    OpStats stats = {};
+    measurePaint(name, MainView::RenderMode(mode), [this] { nextSensorValue(); }, &stats);
+    if (QTest::currentTestFailed())
+        return;
+    results[name] = stats;
+}
+
+void MainSceneBench::swing_data()
+{
+    paintFull_data();
+}
+
+void MainSceneBench::swing()
+{
+    /// Качание заслонки: каждый кадр перерисовывается только область линии
+    QFETCH(int, mode);
+    QString name = QString("swing_") + QTest::currentDataTag();
+    OpStats stats = {};
+    scene->prefs->setSwing(true);
+    measurePaint(name, MainView::RenderMode(mode), [] {}, &stats);
+    scene->prefs->setSwing(false);
+    if (QTest::currentTestFailed())
+        return;
+    results[name] = stats;
+}
+
+/**
+ * @brief Запись результатов в базовый файл
+ * @param path Путь к файлу
+ * @return true если запись прошла успешно
+ */
+static bool writeBaseline(const QString &path)
+{
+    QJsonObject ops;
+    for (auto it = MainSceneBench::results.cbegin(); it != MainSceneBench::results.cend(); ++it) {
+        QJsonObject op;
+        op["nsPerOp"] = it.value().nsPerOp;
+        op["allocsPerOp"] = it.value().allocsPerOp;
+        ops[it.key()] = op;
+    }
+    QJsonObject root;
+    root["format"] = 1;
+    root["operations"] = ops;
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+    return file.write(QJsonDocument(root).toJson()) != -1;
+}
+
+/**
+ * @brief Сравнение результатов с базовым файлом
+ * @param path Путь к файлу
+ * @param tolerance Допустимый рост времени, в процентах
+ * @return Количество регрессий, -1 если файл не прочитан
+ */
+static int compareBaseline(const QString &path, double tolerance)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return -1;
+    QJsonObject ops = QJsonDocument::fromJson(file.readAll()).object().value("operations").toObject();
+    if (ops.isEmpty())
+        return -1;
+
+    int regressions = 0;
+    for (auto it = MainSceneBench::results.cbegin(); it != MainSceneBench::results.cend(); ++it) {
+        if (!ops.contains(it.key()))
+            continue;
+        QJsonObject base = ops.value(it.key()).toObject();
+        double baseNs = base.value("nsPerOp").toDouble();
+        double baseAllocs = base.value("allocsPerOp").toDouble();
+        /// Время сравнивается с допуском, количество выделений памяти - с запасом в половину выделения
+        bool slower = it.value().nsPerOp > baseNs * (1.0 + tolerance / 100.0);
+        bool moreAllocs = it.value().allocsPerOp > baseAllocs + 0.5;
+        qInfo("%-20s %10.0f ns (base %10.0f)  %7.1f allocs (base %7.1f)%s",
+              qPrintable(it.key()), it.value().nsPerOp, baseNs, it.value().allocsPerOp, baseAllocs,
+              (slower || moreAllocs) ? "  REGRESSION" : "");
+        if (slower || moreAllocs)
+            ++regressions;
+    }
+    return regressions;
+}
+
+int main(int argc, char *argv[])
+{
+    /// Сцена никогда не показывается, дисплей не нужен
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+
+    /// Собственные аргументы вырезаются, остальные передаются QTest
+    QString baselinePath;
+    QString writePath;
+    double tolerance = 20.0;
+    QStringList testArgs;
+    const QStringList args = QCoreApplication::arguments();
+    for (int i = 0; i < args.size(); ++i) {
+        if (args[i] == "--baseline" && i + 1 < args.size())
+            baselinePath = args[++i];
+        else if (args[i] == "--write-baseline" && i + 1 < args.size())
+            writePath = args[++i];
+        else if (args[i] == "--tolerance" && i + 1 < args.size())
+            tolerance = args[++i].toDouble();
+        else
+            testArgs << args[i];
+    }
+
+    MainSceneBench bench;
+    int status = QTest::qExec(&bench, testArgs);
+
+    if (!writePath.isEmpty() && !writeBaseline(writePath)) {
+        qWarning("Cannot write baseline %s", qPrintable(writePath));
+        status = 1;
+    }
+    if (!baselinePath.isEmpty()) {
+        int regressions = compareBaseline(baselinePath, tolerance);
+        if (regressions < 0) {
+            qWarning("Cannot read baseline %s", qPrintable(baselinePath));
+            status = 1;
+        } else if (regressions > 0) {
+            status = 1;
+        }
+    }
+    return status;
+}
+
+#include "tst_mainscenebench.moc"
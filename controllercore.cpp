@@ -0,0 +1,164 @@
+#include "controllercore.h"
+#include <QCommandLineParser>
+#include <QFile>
+
+ControllerCore::ControllerCore(QObject *parent)
+    : QObject(parent),
+    preferences(new Preferences(this))
+{
+    quint64 sequence = loadPrefs(preferences);
+    /// Источники данных работают в отдельном потоке, значения применяются не чаще раза за кадр
+    hub = new SensorHub(preferences, this);
+    /// Настройки сохраняются в рабочем потоке при каждом изменении
+    persistence = new PrefsStore(preferences, SNAPSHOTFILE, JOURNALFILE, sequence, this);
+    lagMonitor = new Metrics::LagMonitor(this);
+    /// Сохраняются изменения пользователя, внешние данные сохраняются при выходе
+    connect(preferences, &Preferences::changed, this, [this](quint32 fields) {
+        if (fields & Preferences::UserFields)
+            persistence->submit();
+    });
+}
+
+ControllerCore::~ControllerCore()
+{
+    stop();
+}
+
+quint64 ControllerCore::loadPrefs(Preferences *prefs)
+{
+    /// Снимок и журнал читаются за постоянное время. XML импортируется, только если их нет или они повреждены
+    quint64 sequence = 0;
+    if (!PrefsStore::recover(prefs, SNAPSHOTFILE, JOURNALFILE, &sequence))
+        prefs->load(XMLFILE);
+    /// Границы значений зависят от загруженных единиц измерения
+    prefs->setLimits();
+    return sequence;
+}
+
+void ControllerCore::addOptions(QCommandLineParser &parser)
+{
+    parser.addOption(QCommandLineOption("udp", "Приём данных датчиков по UDP на 127.0.0.1:<port>.", "port"));
+    parser.addOption(QCommandLineOption("socket", "Приём данных датчиков через локальный сокет <name>.", "name"));
+    parser.addOption(QCommandLineOption("tail", "Чтение данных датчиков из дописываемого файла <file>.", "file"));
+    parser.addOption(QCommandLineOption("driver", "Драйвер датчиков из плагина: <file>[,<config>].", "plugin"));
+    parser.addOption(QCommandLineOption("driver-threads", "Количество потоков опроса драйверов датчиков (по умолчанию 2).", "count"));
+    parser.addOption(QCommandLineOption("import-xml", "Импорт настроек из XML-файла <file> перед запуском.", "file"));
+    parser.addOption(QCommandLineOption("export-xml", "Экспорт текущих настроек в XML-файл <file> и выход.", "file"));
+    parser.addOption(QCommandLineOption("control", "Управление через локальный сокет <name>.", "name"));
+    parser.addOption(QCommandLineOption("metrics-socket", "Выгрузка замеров времени через локальный сокет <name>.", "name"));
+    parser.addOption(QCommandLineOption("metrics-file", "Выгрузка замеров времени в файл <file> при выходе.", "file"));
+    parser.addOption(QCommandLineOption("device", "Отправка команд кондиционеру через <transport>: sim[:latency[:loss]] или socket:<name>.",
+                                        "transport"));
+    parser.addOption(QCommandLineOption("modbus", "Опрос кондиционера по Modbus TCP: host[:port][/unit] или sim (встроенный имитатор).",
+                                        "address"));
+}
+
+bool ControllerCore::importExport(const QCommandLineParser &parser, int *exitCode)
+{
+    /// XML используется только для импорта и экспорта, при работе настройки хранятся в бинарном снимке
+    if (parser.isSet("import-xml")) {
+        Preferences imported;
+        /// Журнал старше импортированного снимка и не должен применяться поверх него
+        if (imported.load(parser.value("import-xml")) && imported.saveSnapshot(SNAPSHOTFILE))
+            QFile::remove(JOURNALFILE);
+        else
+            qWarning("Не удалось импортировать настройки из %s", qPrintable(parser.value("import-xml")));
+    }
+    if (parser.isSet("export-xml")) {
+        Preferences exported;
+        if (!PrefsStore::recover(&exported, SNAPSHOTFILE, JOURNALFILE))
+            exported.load(XMLFILE);
+        *exitCode = exported.save(parser.value("export-xml")) ? 0 : 1;
+        return true;
+    }
+    return false;
+}
+
+void ControllerCore::configure(const QCommandLineParser &parser)
+{
+    for (const QString &port : parser.values("udp"))
+        hub->addSource(new UdpSensorSource(port.toUShort()));
+    for (const QString &name : parser.values("socket"))
+        hub->addSource(new LocalSocketSensorSource(name));
+    for (const QString &file : parser.values("tail"))
+        hub->addSource(new FileSensorSource(file));
+    if (parser.isSet("driver")) {
+        /// Все драйверы опрашиваются одним пулом потоков, отсчёты идут в хаб как от обычного источника
+        DriverPool *pool = new DriverPool(parser.isSet("driver-threads") ? parser.value("driver-threads").toInt()
+                                                                         : DriverPool::DEFAULT_THREADS);
+        for (const QString &spec : parser.values("driver")) {
+            if (SensorDriver *driver = DriverPool::load(spec))
+                pool->addDriver(driver);
+        }
+        if (pool->hasDrivers())
+            hub->addSource(pool);
+        else
+            delete pool;
+    }
+    if (parser.isSet("control")) {
+        control = new ControlServer(preferences, this);
+        control->listen(parser.value("control"));
+    }
+    if (parser.isSet("metrics-socket")) {
+        metricsExporter = new Metrics::Exporter(this);
+        metricsExporter->listen(parser.value("metrics-socket"));
+    }
+    metricsFile = parser.value("metrics-file");
+    if (parser.isSet("modbus")) {
+        QString spec = parser.value("modbus");
+        QString host;
+        quint16 port = Modbus::PORT;
+        quint8 unit = 1;
+        bool ok;
+        if (spec == "sim") {
+            modbusServer = new ModbusServer(1, this);
+            ok = modbusServer->listen();
+            host = "127.0.0.1";
+            port = modbusServer->port();
+        } else {
+            ok = Modbus::parseEndpoint(spec, &host, &port, &unit);
+        }
+        if (ok) {
+            /// Показания идут в настройки через рабочий поток датчиков, команды - тому же кондиционеру
+            hub->addSource(new ModbusSensorSource(host, port, unit));
+            if (!parser.isSet("device"))
+                device = new DeviceLink(preferences, new ModbusDeviceTransport(host, port, unit), this);
+        } else {
+            qWarning("Неверный адрес Modbus: %s", qPrintable(spec));
+        }
+    }
+    if (parser.isSet("device")) {
+        if (DeviceTransport *transport = DeviceTransport::create(parser.value("device"))) {
+            device = new DeviceLink(preferences, transport, this);
+        } else {
+            qWarning("Неизвестный транспорт кондиционера: %s", qPrintable(parser.value("device")));
+        }
+    }
+}
+
+void ControllerCore::start()
+{
+    hub->start();
+    persistence->start();
+    lagMonitor->start();
+    if (device)
+        device->open();
+}
+
+void ControllerCore::stop()
+{
+    /// Вызывается из aboutToQuit и ещё раз из деструктора, замеры выгружаются один раз
+    if (stopped)
+        return;
+    stopped = true;
+    /// Последние изменения уходят кондиционеру без паузы
+    if (device)
+        device->flush();
+    /// Сначала останавливаются датчики, чтобы в снимок попали последние значения
+    hub->stop();
+    persistence->stop();
+    lagMonitor->stop();
+    /// Замеры выгружаются после сохранения, чтобы в них попало и оно
+    if (!metricsFile.isEmpty() && !Metrics::exportToFile(metricsFile))
+        qWarning("Не удалось выгрузить замеры в %s", qPrintable(metricsFile));
+}
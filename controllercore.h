@@ -0,0 +1,106 @@
+/**
+* @file
+* @brief Заголовочный файл ядра контроллера
+*
+* Ядро содержит всё, что не относится к интерфейсу: пользовательские настройки, приём данных датчиков
+* и их сохранение. Используется и графическим приложением, и фоновым сервисом без интерфейса,
+* поэтому не зависит от модулей gui и widgets.
+*/
+#ifndef CONTROLLERCORE_H
+#define CONTROLLERCORE_H
+
+#include <QObject>
+#include <QString>
+#include "preferences.h"
+#include "sensorhub.h"
+#include "prefsstore.h"
+#include "controlserver.h"
+#include "metrics.h"
+#include "devicelink.h"
+#include "modbus.h"
+#include "driverpool.h"
+
+class QCommandLineParser;
+
+/**
+ * @class ControllerCore
+ * @brief Ядро контроллера: настройки, датчики, сохранение
+ */
+class ControllerCore : public QObject
+{
+    Q_OBJECT
+public:
+    /// Файл бинарного снимка настроек
+    inline static const QString SNAPSHOTFILE = "preferences.bin";
+    /// Файл журнала изменений настроек
+    inline static const QString JOURNALFILE = "preferences.journal";
+    /// Файл настроек в XML, используется для импорта и экспорта
+    inline static const QString XMLFILE = "preferences.xml";
+
+    /// Настройки загружаются сразу, источники датчиков и сервер управления создаются в configure()
+    explicit ControllerCore(QObject *parent = nullptr);
+    ~ControllerCore() override;
+
+    /**
+     * @brief Загрузка настроек из снимка и журнала, при их отсутствии - из xml файла
+     * @param prefs Пользовательские настройки
+     * @return Наибольший порядковый номер в снимке и журнале
+     */
+    static quint64 loadPrefs(Preferences *prefs);
+    /**
+     * @brief Добавление общих параметров командной строки
+     *
+     * Источники датчиков (--udp, --socket, --tail, --driver), импорт/экспорт настроек (--import-xml, --export-xml)
+     * сервер управления (--control), выгрузка замеров (--metrics-socket, --metrics-file) и связь с кондиционером (--device, --modbus)
+     */
+    static void addOptions(QCommandLineParser &parser);
+    /**
+     * @brief Импорт и экспорт настроек по параметрам командной строки
+     *
+     * Выполняется до создания ядра: импортированный снимок загрузится уже конструктором
+     * @param parser Разобранные параметры
+     * @param exitCode Код завершения, если программу нужно завершить
+     * @return true если программу нужно завершить (был экспорт)
+     */
+    static bool importExport(const QCommandLineParser &parser, int *exitCode);
+    /// @brief Создание источников датчиков, сервера управления, выгрузки замеров и канала команд по параметрам командной строки
+    void configure(const QCommandLineParser &parser);
+
+    /// @brief Пользовательские настройки
+    Preferences *prefs() const { return preferences; }
+    /// @brief Приём данных датчиков
+    SensorHub *sensors() const { return hub; }
+    /// @brief Сохранение настроек
+    PrefsStore *store() const { return persistence; }
+    /// @brief Канал команд кондиционеру, nullptr если не задан ни --device, ни --modbus
+    DeviceLink *deviceLink() const { return device; }
+
+    /// @brief Запуск потоков датчиков и сохранения, замера задержки цикла событий
+    void start();
+    /// @brief Остановка датчиков, сохранение настроек и выгрузка замеров в файл (только при первом вызове)
+    void stop();
+
+private:
+    /// Пользовательские настройки
+    Preferences *preferences;
+    /// Приём данных датчиков
+    SensorHub *hub;
+    /// Сохранение настроек
+    PrefsStore *persistence;
+    /// Сервер управления (если задан --control)
+    ControlServer *control = nullptr;
+    /// Канал команд кондиционеру (если задан --device или --modbus)
+    DeviceLink *device = nullptr;
+    /// Встроенный имитатор кондиционера (если задан --modbus sim)
+    ModbusServer *modbusServer = nullptr;
+    /// Замер задержки цикла событий
+    Metrics::LagMonitor *lagMonitor;
+    /// Выгрузка замеров в локальный сокет (если задан --metrics-socket)
+    Metrics::Exporter *metricsExporter = nullptr;
+    /// Файл выгрузки замеров при выходе (если задан --metrics-file)
+    QString metricsFile;
+    /// stop() уже выполнен
+    bool stopped = false;
+};
+
+#endif // CONTROLLERCORE_H
@@ -0,0 +1,277 @@
+#include "controlserver.h"
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QtEndian>
+#include <QtAlgorithms>
+#include <QDebug>
+#include <cstring>
+#include <cmath>
+
+using namespace ControlProtocol;
+
+namespace {
+/// @brief Чтение f64 little-endian
+double readDouble(const uchar *src)
+{
+    quint64 bits = qFromLittleEndian<quint64>(src);
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/// @brief Запись f64 little-endian
+void writeDouble(uchar *dst, double value)
+{
+    quint64 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    qToLittleEndian<quint64>(bits, dst);
+}
+
+/**
+ * @brief Добавление кадра в буфер
+ *
+ * Место под весь кадр выделяется сразу, элементы записываются через writeItem()
+ * @return Указатель на первый элемент кадра
+ */
+uchar *appendFrame(QByteArray &out, quint32 seq, int count)
+{
+    int offset = out.size();
+    quint32 length = quint32(HEADERSIZE + count * ITEMSIZE);
+    out.resize(offset + LENGTHSIZE + int(length));
+    uchar *p = reinterpret_cast<uchar*>(out.data()) + offset;
+    qToLittleEndian<quint32>(length, p);
+    qToLittleEndian<quint32>(seq, p + LENGTHSIZE);
+    p[LENGTHSIZE + 4] = quint8(count);
+    return p + LENGTHSIZE + HEADERSIZE;
+}
+
+/// @brief Запись элемента кадра
+uchar *writeItem(uchar *p, quint8 status, quint8 field, double value)
+{
+    p[0] = status;
+    p[1] = field;
+    writeDouble(p + 2, value);
+    return p + ITEMSIZE;
+}
+
+/// @brief Поля, на которые можно подписаться
+constexpr quint32 FIELDMASK = (1u << TempVal) | (1u << HumidityVal) | (1u << PressureVal) | (1u << ControlProtocol::TempUnit)
+                              | (1u << ControlProtocol::PressureUnit) | (1u << TargetTemp) | (1u << AcAngle) | (1u << Theme) | (1u << Power) | (1u << Swing);
+
+static_assert((1u << TempVal) == Preferences::TempValField && (1u << TargetTemp) == Preferences::TargetTempField
+              && (1u << AcAngle) == Preferences::AcAngleField && (1u << Power) == Preferences::PowerField
+              && (1u << Swing) == Preferences::SwingField,
+              "Field ids must match Preferences::Field bits");
+}
+
+ControlServer::ControlServer(Preferences *prefs, QObject *parent)
+    : QObject(parent),
+    prefs(prefs),
+    server(new QLocalServer(this))
+{
+    connect(server, &QLocalServer::newConnection, this, &ControlServer::onNewConnection);
+    connect(prefs, &Preferences::changed, this, &ControlServer::onPrefsChanged);
+}
+
+ControlServer::~ControlServer()
+{
+    server->close();
+}
+
+bool ControlServer::listen(const QString &name)
+{
+    /// Сокет, оставшийся после аварийного завершения, мешает запуску
+    QLocalServer::removeServer(name);
+    if (!server->listen(name)) {
+        qWarning() << "Control server failed to listen on" << name << ":" << server->errorString();
+        return false;
+    }
+    return true;
+}
+
+void ControlServer::onNewConnection()
+{
+    while (QLocalSocket *socket = server->nextPendingConnection()) {
+        clients.insert(socket, Client());
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket]() { onReadyRead(socket); });
+        connect(socket, &QLocalSocket::disconnected, this, [this, socket]() {
+            clients.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void ControlServer::onReadyRead(QLocalSocket *socket)
+{
+    auto it = clients.find(socket);
+    if (it == clients.end())
+        return;
+    Client &client = it.value();
+    client.buffer.append(socket->readAll());
+
+    /// Кадры разбираются прямо в буфере, ответы на все кадры отправляются одной записью.
+    /// Всё прочитанное применяется одной транзакцией: события подписчикам уходят после ответов.
+    Preferences::Transaction transaction(prefs);
+    QByteArray out;
+    const uchar *data = reinterpret_cast<const uchar*>(client.buffer.constData());
+    int size = client.buffer.size();
+    int offset = 0;
+    bool ok = true;
+    while (size - offset >= LENGTHSIZE) {
+        quint32 length = qFromLittleEndian<quint32>(data + offset);
+        if (length > MAXFRAME) {
+            ok = false;
+            break;
+        }
+        if (size - offset - LENGTHSIZE < int(length))
+            break;
+        if (!handleFrame(client, data + offset + LENGTHSIZE, length, out)) {
+            ok = false;
+            break;
+        }
+        offset += LENGTHSIZE + int(length);
+    }
+    if (!out.isEmpty())
+        socket->write(out);
+    if (!ok) {
+        qWarning() << "Control client sent a malformed frame, disconnecting";
+        socket->disconnectFromServer();
+        return;
+    }
+    client.buffer.remove(0, offset);
+}
+
+bool ControlServer::handleFrame(Client &client, const uchar *frame, quint32 length, QByteArray &out)
+{
+    if (length < quint32(HEADERSIZE))
+        return false;
+    quint32 seq = qFromLittleEndian<quint32>(frame);
+    int count = frame[4];
+    if (length != quint32(HEADERSIZE + count * ITEMSIZE))
+        return false;
+
+    uchar *reply = appendFrame(out, seq, count);
+    const uchar *item = frame + HEADERSIZE;
+    for (int i = 0; i < count; ++i, item += ITEMSIZE) {
+        double value = readDouble(item + 2);
+        quint8 status = execute(client, item[0], item[1], value);
+        reply = writeItem(reply, status, item[1], value);
+    }
+    return true;
+}
+
+quint8 ControlServer::execute(Client &client, quint8 op, quint8 field, double &value)
+{
+    switch (op) {
+    case Get:
+        return readField(field, value) ? Ok : UnknownField;
+    case Set: {
+        quint8 status = writeField(field, value);
+        readField(field, value);
+        return status;
+    }
+    case Subscribe: {
+        /// Приведение к quint32 значения вне его диапазона (NaN, отрицательного, 2^32 и больше) не определено
+        bool valid = std::isfinite(value) && value >= 0 && value <= FIELDMASK;
+        if (valid)
+            client.subscription = quint32(value) & FIELDMASK;
+        /// В ответе - действующая подписка, как текущее значение поля в ответе на Set
+        value = client.subscription;
+        return valid ? Ok : OutOfRange;
+    }
+    case Ping:
+        return Ok;
+    default:
+        return UnknownOp;
+    }
+}
+
+bool ControlServer::readField(quint8 field, double &value) const
+{
+    switch (field) {
+    case TempVal: value = prefs->getTempVal(); return true;
+    case HumidityVal: value = prefs->getHumidityVal(); return true;
+    case PressureVal: value = prefs->getPressureVal(); return true;
+    case ControlProtocol::TempUnit: value = int(prefs->getTempUnit()); return true;
+    case ControlProtocol::PressureUnit: value = int(prefs->getPressureUnit()); return true;
+    case TargetTemp: value = prefs->getTargetTemp(); return true;
+    case AcAngle: value = prefs->getAcAngle(); return true;
+    case Theme: value = prefs->getTheme() ? 1 : 0; return true;
+    case Power: value = prefs->getPower() ? 1 : 0; return true;
+    case Swing: value = prefs->getSwing() ? 1 : 0; return true;
+    default: return false;
+    }
+}
+
+quint8 ControlServer::writeField(quint8 field, double value)
+{
+    /// Значение проверяется по тем же границам, что и в интерфейсе
+    auto inRange = [value](double min, double max) { return value >= min && value <= max; };
+    switch (field) {
+    case TempVal:
+        if (!inRange(prefs->getTempMin(), prefs->getTempMax()))
+            return OutOfRange;
+        prefs->setTempVal(value);
+        return Ok;
+    case HumidityVal:
+        if (!inRange(prefs->getHumidityMin(), prefs->getHumidityMax()))
+            return OutOfRange;
+        prefs->setHumidityVal(value);
+        return Ok;
+    case PressureVal:
+        if (!inRange(prefs->getPressureMin(), prefs->getPressureMax()))
+            return OutOfRange;
+        prefs->setPressureVal(value);
+        return Ok;
+    case ControlProtocol::TempUnit:
+        if (!inRange(0, Units::UnitTraits<Units::TempUnit>::COUNT - 1) || value != int(value))
+            return OutOfRange;
+        prefs->changeTempUnit(Units::TempUnit(int(value)));
+        return Ok;
+    case ControlProtocol::PressureUnit:
+        if (!inRange(0, Units::UnitTraits<Units::PressureUnit>::COUNT - 1) || value != int(value))
+            return OutOfRange;
+        prefs->changePressureUnit(Units::PressureUnit(int(value)));
+        return Ok;
+    case TargetTemp:
+        if (!inRange(prefs->getTempMin(), prefs->getTempMax()))
+            return OutOfRange;
+        prefs->setTargetTemp(value);
+        return Ok;
+    case AcAngle:
+        if (!inRange(Preferences::ACANGLEMIN, Preferences::ACANGLEMAX))
+            return OutOfRange;
+        prefs->setAcAngle(qRound(value));
+        return Ok;
+    case Theme:
+        prefs->setTheme(value != 0);
+        return Ok;
+    case Power:
+        prefs->setPower(value != 0);
+        return Ok;
+    case Swing:
+        prefs->setSwing(value != 0);
+        return Ok;
+    default:
+        return UnknownField;
+    }
+}
+
+void ControlServer::onPrefsChanged(quint32 fields)
+{
+    for (auto it = clients.begin(); it != clients.end(); ++it) {
+        quint32 mask = it.value().subscription & fields;
+        if (!mask)
+            continue;
+        QByteArray out;
+        uchar *item = appendFrame(out, EVENTSEQ, qPopulationCount(mask));
+        for (quint8 field = 0; mask; ++field, mask >>= 1) {
+            if (!(mask & 1))
+                continue;
+            double value = 0;
+            readField(field, value);
+            item = writeItem(item, Event, field, value);
+        }
+        it.key()->write(out);
+    }
+}
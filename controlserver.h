@@ -0,0 +1,150 @@
+/**
+* @file
+* @brief Заголовочный файл управления через локальный сокет
+*
+* Протокол двоичный, все числа в порядке байтов little-endian. Каждый кадр начинается с длины:
+*
+*     u32 length | u32 seq | u8 count | count * (u8 op, u8 field, f64 value)
+*
+* length - длина кадра без этого поля. Клиент может отправить несколько кадров подряд, не дожидаясь ответов,
+* и несколько команд в одном кадре. Все кадры, прочитанные за раз, применяются одной транзакцией Preferences.
+* Ответ на кадр - кадр с тем же seq и тем же количеством элементов, op заменяется на код результата:
+*
+*     u32 length | u32 seq | u8 count | count * (u8 status, u8 field, f64 value)
+*
+* Подписчики получают кадры событий с seq = EVENTSEQ и status = Event после каждого пакета изменений.
+*/
+#ifndef CONTROLSERVER_H
+#define CONTROLSERVER_H
+
+#include <QObject>
+#include <QHash>
+#include <QByteArray>
+#include "preferences.h"
+
+class QLocalServer;
+class QLocalSocket;
+
+namespace ControlProtocol {
+/// Максимальная длина кадра (без поля длины)
+constexpr quint32 MAXFRAME = 4096;
+/// Размер поля длины
+constexpr int LENGTHSIZE = 4;
+/// Размер заголовка кадра: seq и count
+constexpr int HEADERSIZE = 5;
+/// Размер одной команды или результата
+constexpr int ITEMSIZE = 10;
+/// seq кадров событий
+constexpr quint32 EVENTSEQ = 0xFFFFFFFFu;
+
+/// Команды
+enum Op : quint8 {
+    /// Чтение поля
+    Get = 1,
+    /// Запись поля
+    Set = 2,
+    /// Подписка на изменения: value - маска полей (1 << field), 0 - отписка; не маска - OutOfRange
+    Subscribe = 3,
+    /// Проверка связи
+    Ping = 4
+};
+
+/// Коды результата
+enum Status : quint8 {
+    Ok = 0,
+    UnknownOp = 1,
+    UnknownField = 2,
+    ReadOnly = 3,
+    OutOfRange = 4,
+    /// Элемент кадра события
+    Event = 0x80
+};
+
+/// Поля. Номер поля совпадает с номером бита в Preferences::Field.
+enum FieldId : quint8 {
+    TempVal = 0,
+    HumidityVal = 1,
+    PressureVal = 2,
+    /// Код Units::TempUnit
+    TempUnit = 3,
+    /// Код Units::PressureUnit
+    PressureUnit = 4,
+    TargetTemp = 5,
+    AcAngle = 6,
+    /// 1 - тёмная тема
+    Theme = 8,
+    /// 1 - кондиционер включен
+    Power = 9,
+    /// 1 - заслонка качается
+    Swing = 11
+};
+}
+
+/**
+ * @class ControlServer
+ * @brief Управление настройками через QLocalServer
+ */
+class ControlServer : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @param prefs Пользовательские настройки
+     * @param parent Родительский объект
+     */
+    explicit ControlServer(Preferences *prefs, QObject *parent = nullptr);
+    ~ControlServer() override;
+    /**
+     * @brief Запуск сервера
+     * @param name Имя локального сокета
+     * @return true если сервер запущен
+     */
+    bool listen(const QString &name);
+
+private:
+    /// Состояние подключения
+    struct Client {
+        /// Непрочитанные данные
+        QByteArray buffer;
+        /// Маска полей подписки
+        quint32 subscription = 0;
+    };
+
+    /// Пользовательские настройки
+    Preferences *prefs;
+    /// Сервер
+    QLocalServer *server;
+    /// Подключения
+    QHash<QLocalSocket*, Client> clients;
+
+    /// @brief Новое подключение
+    void onNewConnection();
+    /// @brief Разбор всех полных кадров подключения
+    void onReadyRead(QLocalSocket *socket);
+    /**
+     * @brief Выполнение команд одного кадра
+     * @param client Подключение
+     * @param frame Начало кадра (после поля длины)
+     * @param length Длина кадра
+     * @param out Буфер ответа
+     * @return false если кадр некорректен и подключение нужно закрыть
+     */
+    bool handleFrame(Client &client, const uchar *frame, quint32 length, QByteArray &out);
+    /**
+     * @brief Выполнение одной команды
+     * @param client Подключение
+     * @param op Команда
+     * @param field Поле
+     * @param value Значение, заменяется результатом
+     * @return Код результата
+     */
+    quint8 execute(Client &client, quint8 op, quint8 field, double &value);
+    /// @brief Значение поля
+    bool readField(quint8 field, double &value) const;
+    /// @brief Запись поля с проверкой границ
+    quint8 writeField(quint8 field, double value);
+    /// @brief Рассылка событий подписчикам
+    void onPrefsChanged(quint32 fields);
+};
+
+#endif // CONTROLSERVER_H
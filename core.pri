@@ -0,0 +1,44 @@
+# Исходники ядра контроллера: настройки, датчики, сохранение.
+# Не зависят от модулей gui и widgets, подключаются приложением, сервисом и бенчмарками.
+
+QT += network
+
+# GetProcessMemoryInfo для замера резидентной памяти
+win32: LIBS += -lpsapi
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/controllercore.cpp \
+    $$PWD/controlserver.cpp \
+    $$PWD/devicelink.cpp \
+    $$PWD/driverpool.cpp \
+    $$PWD/fleetmodel.cpp \
+    $$PWD/measurementhistory.cpp \
+    $$PWD/metrics.cpp \
+    $$PWD/modbus.cpp \
+    $$PWD/preferences.cpp \
+    $$PWD/prefssnapshot.cpp \
+    $$PWD/prefsstore.cpp \
+    $$PWD/sensorhub.cpp \
+    $$PWD/sensorsource.cpp \
+    $$PWD/units.cpp
+
+HEADERS += \
+    $$PWD/controllercore.h \
+    $$PWD/controlserver.h \
+    $$PWD/devicelink.h \
+    $$PWD/driverpool.h \
+    $$PWD/fleetmodel.h \
+    $$PWD/measurementhistory.h \
+    $$PWD/metrics.h \
+    $$PWD/modbus.h \
+    $$PWD/preferences.h \
+    $$PWD/prefssnapshot.h \
+    $$PWD/prefsstore.h \
+    $$PWD/ringbuffer.h \
+    $$PWD/sensordriver.h \
+    $$PWD/sensorhub.h \
+    $$PWD/sensorsource.h \
+    $$PWD/spscqueue.h \
+    $$PWD/units.h
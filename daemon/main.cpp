@@ -0,0 +1,83 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include "controllercore.h"
+
+#ifdef Q_OS_UNIX
+#include <QSocketNotifier>
+#include <csignal>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/// Пара сокетов для передачи сигналов завершения в цикл событий
+static int signalFds[2];
+
+/// @brief Обработчик SIGTERM/SIGINT: только запись в сокет, остальное делается в цикле событий
+static void onTerminate(int)
+{
+    char c = 1;
+    ssize_t written = ::write(signalFds[0], &c, sizeof(c));
+    Q_UNUSED(written);
+}
+
+/// @brief Корректное завершение по SIGTERM/SIGINT: настройки сохраняются, как при обычном выходе
+static void installTerminateHandler(QCoreApplication &app)
+{
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, signalFds) != 0)
+        return;
+    QSocketNotifier *notifier = new QSocketNotifier(signalFds[1], QSocketNotifier::Read, &app);
+    QObject::connect(notifier, &QSocketNotifier::activated, &app, &QCoreApplication::quit);
+    struct sigaction action = {};
+    action.sa_handler = onTerminate;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGTERM, &action, nullptr);
+    sigaction(SIGINT, &action, nullptr);
+}
+#elif defined(Q_OS_WIN)
+#include <windows.h>
+
+/// @brief Обработчик Ctrl+C и закрытия консоли, вызывается в отдельном потоке
+static BOOL WINAPI onConsoleCtrl(DWORD)
+{
+    QMetaObject::invokeMethod(QCoreApplication::instance(), &QCoreApplication::quit, Qt::QueuedConnection);
+    return TRUE;
+}
+
+static void installTerminateHandler(QCoreApplication &)
+{
+    SetConsoleCtrlHandler(onConsoleCtrl, TRUE);
+}
+#else
+static void installTerminateHandler(QCoreApplication &) {}
+#endif
+
+/**
+ * @brief Фоновый сервис контроллера
+ *
+ * Работает на QCoreApplication: настройки, приём данных датчиков и их сохранение без окон,
+ * шрифтов и стилей. Параметры командной строки те же, что у графического приложения.
+ */
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("acdaemon");
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    ControllerCore::addOptions(parser);
+    parser.process(app);
+
+    int exitCode = 0;
+    if (ControllerCore::importExport(parser, &exitCode))
+        return exitCode;
+
+    ControllerCore core;
+    core.configure(parser);
+    core.start();
+
+    installTerminateHandler(app);
+    /// @brief Сохранение параметров при выходе
+    QObject::connect(&app, &QCoreApplication::aboutToQuit, &core, &ControllerCore::stop);
+
+    return app.exec();
+}
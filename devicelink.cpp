@@ -0,0 +1,318 @@
+#include "devicelink.h"
+#include "preferences.h"
+#include "metrics.h"
+#include <QTimer>
+#include <QLocalSocket>
+#include <QRandomGenerator>
+#include <QStringList>
+#include <QVector>
+#include <QtEndian>
+#include <QDebug>
+#include <cstring>
+
+using namespace DeviceProtocol;
+
+namespace {
+/// @brief Чтение f64 little-endian
+double readDouble(const uchar *src)
+{
+    quint64 bits = qFromLittleEndian<quint64>(src);
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/// @brief Запись f64 little-endian
+void writeDouble(uchar *dst, double value)
+{
+    quint64 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    qToLittleEndian<quint64>(bits, dst);
+}
+}
+
+QByteArray DeviceProtocol::encodeAck(quint32 seq, quint8 status)
+{
+    QByteArray out(LENGTHSIZE + ACKSIZE, Qt::Uninitialized);
+    uchar *p = reinterpret_cast<uchar*>(out.data());
+    qToLittleEndian<quint32>(ACKSIZE, p);
+    qToLittleEndian<quint32>(seq, p + LENGTHSIZE);
+    p[LENGTHSIZE + 4] = status;
+    return out;
+}
+
+QByteArray DeviceCommand::encode() const
+{
+    QByteArray out(LENGTHSIZE + COMMANDSIZE, Qt::Uninitialized);
+    uchar *p = reinterpret_cast<uchar*>(out.data());
+    qToLittleEndian<quint32>(COMMANDSIZE, p);
+    p += LENGTHSIZE;
+    qToLittleEndian<quint32>(seq, p);
+    p[4] = fields;
+    writeDouble(p + 5, targetTemp);
+    writeDouble(p + 13, acAngle);
+    p[21] = power ? 1 : 0;
+    p[22] = swing ? 1 : 0;
+    return out;
+}
+
+bool DeviceCommand::decode(const uchar *data, int size, DeviceCommand *command)
+{
+    if (size != COMMANDSIZE)
+        return false;
+    command->seq = qFromLittleEndian<quint32>(data);
+    command->fields = data[4];
+    command->targetTemp = readDouble(data + 5);
+    command->acAngle = readDouble(data + 13);
+    command->power = data[21] != 0;
+    command->swing = data[22] != 0;
+    return true;
+}
+
+DeviceTransport::DeviceTransport(QObject *parent)
+    : QObject(parent)
+{
+}
+
+DeviceTransport *DeviceTransport::create(const QString &spec, QObject *parent)
+{
+    QStringList parts = spec.split(':');
+    if (parts[0] == "sim")
+        return new SimulatedDevice(parts.value(1, "20").toInt(), parts.value(2, "0").toInt(), parent);
+    if (parts[0] == "socket" && parts.size() > 1)
+        return new LocalSocketTransport(spec.section(':', 1), parent);
+    return nullptr;
+}
+
+LocalSocketTransport::LocalSocketTransport(const QString &name, QObject *parent)
+    : DeviceTransport(parent),
+    name(name),
+    socket(new QLocalSocket(this)),
+    reconnect(new QTimer(this))
+{
+    reconnect->setSingleShot(true);
+    reconnect->setInterval(RECONNECT);
+    connect(reconnect, &QTimer::timeout, this, &LocalSocketTransport::open);
+    connect(socket, &QLocalSocket::readyRead, this, [this]() { emit received(socket->readAll()); });
+    connect(socket, &QLocalSocket::disconnected, reconnect, QOverload<>::of(&QTimer::start));
+    connect(socket, &QLocalSocket::errorOccurred, reconnect, QOverload<>::of(&QTimer::start));
+}
+
+bool LocalSocketTransport::open()
+{
+    /// Подключение асинхронное, при неудаче сработает переподключение
+    socket->abort();
+    socket->connectToServer(name);
+    return true;
+}
+
+void LocalSocketTransport::send(const QByteArray &data)
+{
+    if (socket->state() == QLocalSocket::ConnectedState)
+        socket->write(data);
+}
+
+QString LocalSocketTransport::description() const
+{
+    return "socket " + name;
+}
+
+SimulatedDevice::SimulatedDevice(int latency, int lossPercent, QObject *parent)
+    : DeviceTransport(parent),
+    latency(qMax(0, latency)),
+    lossPercent(qBound(0, lossPercent, 100))
+{
+}
+
+void SimulatedDevice::send(const QByteArray &data)
+{
+    pending.append(data);
+    bool synced = takeFrames(pending, COMMANDSIZE, [this](const uchar *frame) {
+        DeviceCommand command;
+        DeviceCommand::decode(frame, COMMANDSIZE, &command);
+        ++commands;
+        /// Потерянная команда не применяется и не подтверждается
+        if (lossPercent > 0 && int(QRandomGenerator::global()->bounded(100)) < lossPercent)
+            return;
+        quint8 status = (command.fields & ~AllFields) ? Rejected : Ok;
+        if (status == Ok) {
+            if (command.fields & TargetTemp)
+                applied.targetTemp = command.targetTemp;
+            if (command.fields & AcAngle)
+                applied.acAngle = command.acAngle;
+            if (command.fields & Power)
+                applied.power = command.power;
+            if (command.fields & Swing)
+                applied.swing = command.swing;
+            applied.fields |= command.fields;
+            applied.seq = command.seq;
+            emit commandApplied(command);
+        }
+        QByteArray ack = encodeAck(command.seq, status);
+        QTimer::singleShot(latency, this, [this, ack]() { emit received(ack); });
+    });
+    if (!synced)
+        qWarning() << "Simulated device: malformed command frame";
+}
+
+QString SimulatedDevice::description() const
+{
+    return QString("simulator (latency %1 ms, loss %2%)").arg(latency).arg(lossPercent);
+}
+
+DeviceLink::DeviceLink(Preferences *prefs, DeviceTransport *transport, QObject *parent)
+    : QObject(parent),
+    prefs(prefs),
+    link(transport),
+    debounce(new QTimer(this)),
+    ackCheck(new QTimer(this))
+{
+    link->setParent(this);
+    debounce->setSingleShot(true);
+    ackCheck->setInterval(TIMEOUT / 5);
+    connect(debounce, &QTimer::timeout, this, &DeviceLink::flush);
+    connect(ackCheck, &QTimer::timeout, this, &DeviceLink::checkTimeouts);
+    connect(link, &DeviceTransport::received, this, &DeviceLink::onReceived);
+    connect(prefs, &Preferences::changed, this, &DeviceLink::onPrefsChanged);
+}
+
+bool DeviceLink::open()
+{
+    if (!link->open()) {
+        qWarning() << "Device transport failed to open:" << link->description();
+        return false;
+    }
+    return true;
+}
+
+void DeviceLink::onPrefsChanged(quint32 fields)
+{
+    quint8 changed = 0;
+    if (fields & Preferences::TargetTempField)
+        changed |= TargetTemp;
+    if (fields & Preferences::AcAngleField)
+        changed |= AcAngle;
+    if (fields & Preferences::PowerField)
+        changed |= Power;
+    if (fields & Preferences::SwingField)
+        changed |= Swing;
+    if (!changed)
+        return;
+    if (!dirtyFields)
+        sinceFirstChange.start();
+    dirtyFields |= changed;
+    ++counters.changes;
+    /// Каждое изменение откладывает отправку, но не дальше MAXDELAY от первого
+    qint64 left = MAXDELAY - sinceFirstChange.elapsed();
+    if (left <= 0)
+        flush();
+    else
+        debounce->start(int(qMin<qint64>(DEBOUNCE, left)));
+}
+
+void DeviceLink::flush()
+{
+    debounce->stop();
+    /// При заполненном окне изменения продолжают сливаться и уйдут после ближайшего подтверждения
+    if (!dirtyFields || inFlight.size() >= WINDOW)
+        return;
+    Pending entry;
+    entry.command = makeCommand(dirtyFields);
+    entry.sent.start();
+    dirtyFields = 0;
+    link->send(entry.command.encode());
+    ++counters.commands;
+    inFlight.insert(entry.command.seq, entry);
+    if (!ackCheck->isActive())
+        ackCheck->start();
+}
+
+DeviceCommand DeviceLink::makeCommand(quint8 fields)
+{
+    DeviceCommand command;
+    command.seq = nextSeq++;
+    command.fields = fields;
+    command.targetTemp = Units::convert(prefs->getTargetTemp(), prefs->getTempUnit(), Units::TempUnit::Celsius);
+    command.acAngle = prefs->getAcAngle();
+    command.power = prefs->getPower();
+    command.swing = prefs->getSwing();
+    return command;
+}
+
+void DeviceLink::onReceived(const QByteArray &data)
+{
+    pending.append(data);
+    bool synced = takeFrames(pending, ACKSIZE, [this](const uchar *frame) {
+        quint32 seq = qFromLittleEndian<quint32>(frame);
+        auto it = inFlight.find(seq);
+        /// Подтверждение повтора, который уже не ждут
+        if (it == inFlight.end())
+            return;
+        Metrics::record(Metrics::DeviceRoundTrip, it->sent.nsecsElapsed());
+        if (frame[4] == Ok) {
+            /// Кондиционер принял значения этой команды: повтор более старой не должен их перезаписать
+            quint8 applied = it->command.fields;
+            for (auto older = inFlight.begin(); older != it;) {
+                older->command.fields &= ~applied;
+                if (older->command.fields) {
+                    ++older;
+                    continue;
+                }
+                ++counters.superseded;
+                older = inFlight.erase(older);
+            }
+            ++counters.acknowledged;
+            emit acknowledged(seq);
+        } else {
+            ++counters.failed;
+            emit failed(seq);
+        }
+        inFlight.erase(it);
+    });
+    if (!synced)
+        qWarning() << "Device link: malformed acknowledgement from" << link->description();
+    if (inFlight.isEmpty())
+        ackCheck->stop();
+    /// Освободилось место в окне
+    if (dirtyFields && !debounce->isActive())
+        flush();
+}
+
+void DeviceLink::checkTimeouts()
+{
+    /// Поля, которые уже будут отправлены более новыми командами или ещё не отправлены
+    quint8 newer = dirtyFields;
+    QVector<quint32> finished;
+    auto it = inFlight.end();
+    while (it != inFlight.begin()) {
+        --it;
+        Pending &entry = it.value();
+        quint8 covered = newer;
+        newer |= entry.command.fields;
+        if (entry.sent.elapsed() - entry.lastAttempt < TIMEOUT)
+            continue;
+        /// В повтор попадают только поля, которые не отправлены позже
+        entry.command.fields &= ~covered;
+        if (!entry.command.fields) {
+            ++counters.superseded;
+            finished.append(it.key());
+        } else if (entry.attempts > MAXRETRIES) {
+            /// Связи нет: команда считается неудачной, а её поля уйдут следующей командой с актуальными значениями
+            ++counters.failed;
+            dirtyFields |= entry.command.fields;
+            finished.append(it.key());
+            emit failed(it.key());
+        } else {
+            ++entry.attempts;
+            ++counters.retries;
+            entry.lastAttempt = entry.sent.elapsed();
+            link->send(entry.command.encode());
+        }
+    }
+    for (quint32 seq : qAsConst(finished))
+        inFlight.remove(seq);
+    if (inFlight.isEmpty())
+        ackCheck->stop();
+    if (dirtyFields && !debounce->isActive())
+        flush();
+}
@@ -0,0 +1,332 @@
+/**
+* @file
+* @brief Заголовочный файл канала команд кондиционера
+*
+* Изменения желаемой температуры, угла заслонки, питания и качания отправляются кондиционеру командами.
+* Частые изменения (серия нажатий "+", перетаскивание слайдера) сливаются в одну команду: она
+* отправляется после паузы DEBOUNCE, но не позже MAXDELAY от первого изменения. В команде только
+* изменившиеся поля и их последние значения.
+*
+* Команды отправляются конвейером: до WINDOW команд ожидают подтверждения одновременно. Команда без
+* подтверждения за TIMEOUT отправляется повторно, но без полей, которые уже есть в более новых командах;
+* если таких полей не осталось, повтор не нужен. Всё происходит в цикле событий без ожиданий,
+* интерфейс никогда не ждёт кондиционер.
+*
+* Формат кадров (little-endian, каждый кадр начинается с длины остатка кадра):
+*
+*     команда:       u32 length | u32 seq | u8 fields | f64 targetTemp | f64 acAngle | u8 power | u8 swing
+*     подтверждение: u32 length | u32 seq | u8 status
+*
+* Желаемая температура передаётся в °C, угол - в градусах. Значения полей, не отмеченных в fields, не используются.
+*/
+#ifndef DEVICELINK_H
+#define DEVICELINK_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QMap>
+#include <QString>
+#include <QtEndian>
+
+class QTimer;
+class QLocalSocket;
+class Preferences;
+
+/// @brief Константы протокола команд
+namespace DeviceProtocol {
+/// Размер поля длины
+constexpr int LENGTHSIZE = 4;
+/// Размер команды без поля длины
+constexpr int COMMANDSIZE = 23;
+/// Размер подтверждения без поля длины
+constexpr int ACKSIZE = 5;
+
+/// Поля команды
+enum Field : quint8 {
+    TargetTemp = 1u << 0,
+    AcAngle = 1u << 1,
+    Power = 1u << 2,
+    Swing = 1u << 3,
+    AllFields = TargetTemp | AcAngle | Power | Swing
+};
+
+/// Результат выполнения команды
+enum Status : quint8 {
+    Ok = 0,
+    /// Кондиционер не может выполнить команду (например значение вне его диапазона)
+    Rejected = 1
+};
+
+/// @brief Кадр подтверждения
+QByteArray encodeAck(quint32 seq, quint8 status);
+
+/**
+ * @brief Выделение кадров из потока байтов
+ *
+ * Разобранные кадры удаляются из буфера одним вызовом
+ * @param buffer Накопленные байты
+ * @param frameSize Ожидаемый размер кадра без поля длины
+ * @param handle Обработчик кадра
+ * @return false если встретился кадр другого размера (поток рассинхронизирован, буфер очищен)
+ */
+template<typename Handler>
+bool takeFrames(QByteArray &buffer, quint32 frameSize, Handler handle)
+{
+    const uchar *data = reinterpret_cast<const uchar*>(buffer.constData());
+    int offset = 0;
+    while (buffer.size() - offset >= LENGTHSIZE) {
+        quint32 length = qFromLittleEndian<quint32>(data + offset);
+        if (length != frameSize) {
+            buffer.clear();
+            return false;
+        }
+        if (buffer.size() - offset < LENGTHSIZE + int(length))
+            break;
+        handle(data + offset + LENGTHSIZE);
+        offset += LENGTHSIZE + int(length);
+    }
+    buffer.remove(0, offset);
+    return true;
+}
+}
+
+/**
+ * @struct DeviceCommand
+ * @brief Команда кондиционеру
+ */
+struct DeviceCommand {
+    /// Номер команды
+    quint32 seq = 0;
+    /// Поля команды (DeviceProtocol::Field)
+    quint8 fields = 0;
+    /// Желаемая температура, °C
+    double targetTemp = 0;
+    /// Угол заслонки, градусы
+    double acAngle = 0;
+    /// Питание
+    bool power = false;
+    /// Качание заслонки
+    bool swing = false;
+
+    /// @brief Кадр команды
+    QByteArray encode() const;
+    /**
+     * @brief Разбор команды
+     * @param data Кадр без поля длины
+     * @param size Размер кадра
+     * @param command Результат
+     * @return false если размер кадра не совпадает с размером команды
+     */
+    static bool decode(const uchar *data, int size, DeviceCommand *command);
+};
+
+/**
+ * @class DeviceTransport
+ * @brief Базовый класс транспорта до кондиционера
+ *
+ * Транспорт передаёт байты как есть, кадры выделяет DeviceLink.
+ */
+class DeviceTransport : public QObject
+{
+    Q_OBJECT
+public:
+    explicit DeviceTransport(QObject *parent = nullptr);
+    /**
+     * @brief Создание транспорта по описанию
+     *
+     * sim[:latency[:loss]] - имитатор с задержкой ответа latency мс и потерей loss % кадров,
+     * socket:<name> - мост к кондиционеру через локальный сокет
+     * @return nullptr если описание не распознано
+     */
+    static DeviceTransport *create(const QString &spec, QObject *parent = nullptr);
+    /// @brief Открытие транспорта
+    virtual bool open() = 0;
+    /// @brief Отправка байтов без ожидания
+    virtual void send(const QByteArray &data) = 0;
+    /// @brief Описание транспорта для сообщений в журнал
+    virtual QString description() const = 0;
+
+signals:
+    /// @brief Получены байты от кондиционера
+    void received(const QByteArray &data);
+};
+
+/**
+ * @class LocalSocketTransport
+ * @brief Мост к кондиционеру через локальный сокет
+ *
+ * При обрыве связи переподключается раз в RECONNECT мс. Команды, отправленные без связи,
+ * теряются и будут повторены DeviceLink.
+ */
+class LocalSocketTransport : public DeviceTransport
+{
+    Q_OBJECT
+public:
+    /// Интервал переподключения, мс
+    static constexpr int RECONNECT = 1000;
+
+    /// @param name Имя сокета
+    explicit LocalSocketTransport(const QString &name, QObject *parent = nullptr);
+    bool open() override;
+    void send(const QByteArray &data) override;
+    QString description() const override;
+
+private:
+    /// Имя сокета
+    QString name;
+    /// Сокет
+    QLocalSocket *socket;
+    /// Таймер переподключения
+    QTimer *reconnect;
+};
+
+/**
+ * @class SimulatedDevice
+ * @brief Имитатор кондиционера
+ *
+ * Разбирает команды, запоминает применённые значения и подтверждает их через заданную задержку.
+ * Часть кадров можно терять, чтобы проверить повторы без настоящего кондиционера.
+ */
+class SimulatedDevice : public DeviceTransport
+{
+    Q_OBJECT
+public:
+    /**
+     * @param latency Задержка подтверждения, мс
+     * @param lossPercent Доля теряемых команд, %
+     * @param parent Родительский объект
+     */
+    explicit SimulatedDevice(int latency = 20, int lossPercent = 0, QObject *parent = nullptr);
+    bool open() override { return true; }
+    void send(const QByteArray &data) override;
+    QString description() const override;
+
+    /// @brief Количество полученных команд (кадров)
+    int commandCount() const { return commands; }
+    /// @brief Последнее применённое состояние, fields - все поля, которые когда-либо приходили
+    const DeviceCommand &state() const { return applied; }
+
+signals:
+    /// @brief Команда применена
+    void commandApplied(const DeviceCommand &command);
+
+private:
+    /// Задержка подтверждения, мс
+    int latency;
+    /// Доля теряемых команд, %
+    int lossPercent;
+    /// Количество полученных команд
+    int commands = 0;
+    /// Применённое состояние
+    DeviceCommand applied;
+    /// Недоразобранный хвост входящих данных
+    QByteArray pending;
+};
+
+/**
+ * @struct DeviceLinkStats
+ * @brief Счётчики канала команд
+ */
+struct DeviceLinkStats {
+    /// Изменения настроек, попавшие в команды
+    quint64 changes = 0;
+    /// Отправленные команды (без повторов)
+    quint64 commands = 0;
+    /// Повторные отправки
+    quint64 retries = 0;
+    /// Подтверждённые команды
+    quint64 acknowledged = 0;
+    /// Команды, отклонённые кондиционером или оставшиеся без подтверждения после всех повторов
+    quint64 failed = 0;
+    /// Повторы, которые не понадобились, так как поля уже отправлены более новыми командами
+    quint64 superseded = 0;
+};
+
+/**
+ * @class DeviceLink
+ * @brief Канал команд кондиционеру
+ */
+class DeviceLink : public QObject
+{
+    Q_OBJECT
+public:
+    /// Пауза после последнего изменения, после которой отправляется команда, мс
+    static constexpr int DEBOUNCE = 100;
+    /// Наибольшая задержка отправки от первого изменения, мс (при непрерывном перетаскивании слайдера)
+    static constexpr int MAXDELAY = 400;
+    /// Время ожидания подтверждения, мс
+    static constexpr int TIMEOUT = 500;
+    /// Количество повторов команды
+    static constexpr int MAXRETRIES = 3;
+    /// Наибольшее количество команд, ожидающих подтверждения
+    static constexpr int WINDOW = 4;
+
+    /**
+     * @param prefs Пользовательские настройки
+     * @param transport Транспорт, DeviceLink становится его владельцем
+     * @param parent Родительский объект
+     */
+    DeviceLink(Preferences *prefs, DeviceTransport *transport, QObject *parent = nullptr);
+    /// @brief Открытие транспорта
+    bool open();
+    /// @brief Немедленная отправка накопленных изменений (например перед выходом)
+    void flush();
+    /// @brief Транспорт
+    DeviceTransport *transport() const { return link; }
+    /// @brief Счётчики
+    const DeviceLinkStats &stats() const { return counters; }
+    /// @brief Количество команд, ожидающих подтверждения
+    int inFlightCount() const { return inFlight.size(); }
+
+signals:
+    /// @brief Кондиционер подтвердил команду
+    void acknowledged(quint32 seq);
+    /// @brief Команда отклонена или осталась без подтверждения
+    void failed(quint32 seq);
+
+private:
+    /// @brief Команда, ожидающая подтверждения
+    struct Pending {
+        /// Команда
+        DeviceCommand command;
+        /// Время первой отправки
+        QElapsedTimer sent;
+        /// Время последней отправки, мс от первой
+        qint64 lastAttempt = 0;
+        /// Количество отправок
+        int attempts = 1;
+    };
+
+    /// Пользовательские настройки
+    Preferences *prefs;
+    /// Транспорт
+    DeviceTransport *link;
+    /// Таймер паузы после изменения
+    QTimer *debounce;
+    /// Таймер проверки подтверждений
+    QTimer *ackCheck;
+    /// Время с первого неотправленного изменения
+    QElapsedTimer sinceFirstChange;
+    /// Изменившиеся поля, ещё не отправленные
+    quint8 dirtyFields = 0;
+    /// Номер следующей команды
+    quint32 nextSeq = 1;
+    /// Команды, ожидающие подтверждения, по номеру
+    QMap<quint32, Pending> inFlight;
+    /// Недоразобранный хвост входящих данных
+    QByteArray pending;
+    /// Счётчики
+    DeviceLinkStats counters;
+
+    /// @brief Изменение настроек
+    void onPrefsChanged(quint32 fields);
+    /// @brief Получены данные от транспорта
+    void onReceived(const QByteArray &data);
+    /// @brief Проверка команд без подтверждения
+    void checkTimeouts();
+    /// @brief Команда с текущими значениями полей
+    DeviceCommand makeCommand(quint8 fields);
+};
+
+#endif // DEVICELINK_H
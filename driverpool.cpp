@@ -0,0 +1,199 @@
+#include "driverpool.h"
+#include "metrics.h"
+#include <QThread>
+#include <QMutexLocker>
+#include <QPluginLoader>
+#include <QDateTime>
+#include <QDebug>
+#include <algorithm>
+
+DriverPool::DriverPool(int threads)
+    : threadCount(qMax(1, threads))
+{
+}
+
+DriverPool::~DriverPool()
+{
+    stop();
+    qDeleteAll(drivers);
+}
+
+SensorDriver *DriverPool::load(const QString &spec)
+{
+    QString file = spec.section(',', 0, 0);
+    QString config = spec.section(',', 1);
+    /// Загрузчик не выгружает библиотеку при удалении, код драйвера остаётся доступен
+    QPluginLoader loader(file);
+    SensorDriverFactory *factory = qobject_cast<SensorDriverFactory*>(loader.instance());
+    if (!factory) {
+        qWarning() << "Sensor driver plugin failed to load:" << file << loader.errorString();
+        return nullptr;
+    }
+    SensorDriver *driver = factory->create(config);
+    if (!driver)
+        qWarning() << "Sensor driver" << factory->vendor() << "rejected configuration:" << config;
+    return driver;
+}
+
+bool DriverPool::start()
+{
+    if (drivers.isEmpty() || running.load())
+        return false;
+    clock.start();
+    workerCount = qMin(threadCount, drivers.size());
+    workers.reset(new Worker[workerCount]);
+    /// Драйверы распределяются по потокам по кругу, первый опрос - сразу
+    for (int i = 0; i < drivers.size(); ++i)
+        schedule(i % workerCount, Task{0, i, false});
+    running.store(true, std::memory_order_release);
+    for (int w = 0; w < workerCount; ++w) {
+        workers[w].thread = QThread::create([this, w]() { work(w); });
+        workers[w].thread->setObjectName(QString("DriverPool-%1").arg(w));
+        workers[w].thread->start();
+    }
+    return true;
+}
+
+void DriverPool::stop()
+{
+    if (!running.exchange(false))
+        return;
+    /// Флаг проверяется под мьютексом потока перед сном, поэтому пробуждение не теряется
+    for (int w = 0; w < workerCount; ++w) {
+        QMutexLocker lock(&workers[w].mutex);
+        workers[w].wake.wakeAll();
+    }
+    /// Поток, занятый опросом, завершится после его окончания
+    for (int w = 0; w < workerCount; ++w) {
+        workers[w].thread->wait();
+        delete workers[w].thread;
+    }
+    workers.reset();
+    workerCount = 0;
+}
+
+QString DriverPool::description() const
+{
+    return QString("driver pool (%1 drivers, %2 threads)").arg(drivers.size()).arg(qMin(threadCount, drivers.size()));
+}
+
+void DriverPool::work(int w)
+{
+    Worker &worker = workers[w];
+    while (running.load(std::memory_order_acquire)) {
+        Task task;
+        if (takeDue(w, &task) || steal(w, &task)) {
+            run(w, task);
+            continue;
+        }
+        /// Сон до ближайшего опроса любого потока: если его владелец будет занят, опрос заберёт этот поток
+        qint64 wait = qBound<qint64>(1, nextDue() - clock.elapsed(), MAXSLEEP);
+        QMutexLocker lock(&worker.mutex);
+        if (running.load(std::memory_order_acquire))
+            worker.wake.wait(&worker.mutex, ulong(wait));
+    }
+}
+
+bool DriverPool::takeDue(int w, Task *task)
+{
+    Worker &worker = workers[w];
+    QMutexLocker lock(&worker.mutex);
+    if (worker.tasks.isEmpty() || worker.tasks.first().due > clock.elapsed())
+        return false;
+    std::pop_heap(worker.tasks.begin(), worker.tasks.end(), &Task::later);
+    *task = worker.tasks.takeLast();
+    return true;
+}
+
+bool DriverPool::steal(int w, Task *task)
+{
+    for (int i = 1; i < workerCount; ++i) {
+        Worker &victim = workers[(w + i) % workerCount];
+        /// Занятую очередь соседа не ждём, проверим её в следующий раз
+        if (!victim.mutex.tryLock())
+            continue;
+        bool found = !victim.tasks.isEmpty() && victim.tasks.first().due <= clock.elapsed();
+        if (found) {
+            std::pop_heap(victim.tasks.begin(), victim.tasks.end(), &Task::later);
+            *task = victim.tasks.takeLast();
+        }
+        victim.mutex.unlock();
+        if (found) {
+            stolen.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void DriverPool::run(int w, Task &task)
+{
+    SensorDriver *driver = drivers.at(task.driver);
+    if (!task.opened) {
+        /// Драйвер, который не открылся, больше не планируется
+        if (!driver->open()) {
+            qWarning() << "Sensor driver failed to open:" << driver->description();
+            return;
+        }
+        task.opened = true;
+    }
+
+    SensorSample samples[MAXSAMPLES] = {};
+    QElapsedTimer timer;
+    timer.start();
+    int count = qBound(0, driver->poll(samples, MAXSAMPLES), MAXSAMPLES);
+    Metrics::record(Metrics::DriverPoll, timer.nsecsElapsed());
+
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    Worker &worker = workers[w];
+    for (int i = 0; i < count; ++i) {
+        if (samples[i].channel >= SensorSample::ChannelCount)
+            continue;
+        if (!samples[i].timestamp)
+            samples[i].timestamp = now;
+        if (!worker.queue.push(samples[i]))
+            dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+    /// Разбор планируется один раз, пока поток хаба его не выполнил
+    if (count && !drainPending.exchange(true, std::memory_order_acq_rel))
+        QMetaObject::invokeMethod(this, &DriverPool::drain, Qt::QueuedConnection);
+
+    /// Опросы идут с постоянным шагом; пропущенные из-за долгого опроса не наверстываются
+    int interval = qMax(1, driver->interval());
+    qint64 elapsed = clock.elapsed();
+    task.due += interval;
+    if (task.due <= elapsed)
+        task.due = elapsed + interval;
+    /// Драйвер остаётся у потока, который его опросил
+    schedule(w, task);
+}
+
+void DriverPool::schedule(int w, const Task &task)
+{
+    Worker &worker = workers[w];
+    QMutexLocker lock(&worker.mutex);
+    worker.tasks.append(task);
+    std::push_heap(worker.tasks.begin(), worker.tasks.end(), &Task::later);
+}
+
+qint64 DriverPool::nextDue()
+{
+    qint64 due = clock.elapsed() + MAXSLEEP;
+    for (int w = 0; w < workerCount; ++w) {
+        QMutexLocker lock(&workers[w].mutex);
+        if (!workers[w].tasks.isEmpty())
+            due = qMin(due, workers[w].tasks.first().due);
+    }
+    return due;
+}
+
+void DriverPool::drain()
+{
+    /// Флаг сбрасывается до разбора, чтобы отсчёт, пришедший во время разбора, запланировал новый
+    drainPending.exchange(false, std::memory_order_acq_rel);
+    SensorSample sample;
+    for (int w = 0; w < workerCount; ++w) {
+        while (workers[w].queue.pop(sample))
+            emit sampleReady(sample);
+    }
+}
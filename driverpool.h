@@ -0,0 +1,137 @@
+/**
+* @file
+* @brief Заголовочный файл пула опроса драйверов датчиков
+*
+* Драйверы опрашиваются небольшим пулом потоков, а не отдельным потоком или таймером на каждый датчик.
+* У каждого потока своя очередь драйверов, упорядоченная по времени следующего опроса. Поток опрашивает
+* свои драйверы, а если своих к опросу нет, забирает просроченный драйвер у соседа, занятого долгим
+* опросом (work stealing). Так медленный драйвер одного производителя не задерживает остальные.
+*
+* Отсчёты каждый поток складывает в свою очередь без блокировок. Пул - обычный источник SensorHub:
+* очереди разбираются в рабочем потоке хаба, дальше отсчёты идут тем же путём, что и от других
+* источников, и попадают в Preferences одной транзакцией не чаще раза за кадр.
+*/
+#ifndef DRIVERPOOL_H
+#define DRIVERPOOL_H
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVector>
+#include <atomic>
+#include <memory>
+#include "sensorsource.h"
+#include "sensordriver.h"
+#include "spscqueue.h"
+
+class QThread;
+
+/**
+ * @class DriverPool
+ * @brief Опрос драйверов датчиков в общем пуле потоков
+ */
+class DriverPool : public SensorSource
+{
+    Q_OBJECT
+public:
+    /// Количество потоков по умолчанию
+    static constexpr int DEFAULT_THREADS = 2;
+    /// Наибольший сон свободного потока, мс: не реже он проверяет просроченные опросы соседей
+    static constexpr int MAXSLEEP = 50;
+    /// Наибольшее количество отсчётов за один опрос
+    static constexpr int MAXSAMPLES = 16;
+    /// Ёмкость очереди отсчётов каждого потока
+    static constexpr std::size_t QUEUESIZE = 256;
+
+    /// @param threads Количество потоков, не больше количества драйверов
+    explicit DriverPool(int threads = DEFAULT_THREADS);
+    ~DriverPool() override;
+    /**
+     * @brief Загрузка драйвера из плагина
+     *
+     * Библиотека остаётся загруженной до выхода из программы
+     * @param spec <file>[,<config>]: путь к плагину и параметры драйвера
+     * @return nullptr если плагин не загружен или не принял параметры
+     */
+    static SensorDriver *load(const QString &spec);
+    /**
+     * @brief Добавление драйвера
+     *
+     * Вызывается до start(). Пул становится владельцем драйвера.
+     */
+    void addDriver(SensorDriver *driver) { drivers.append(driver); }
+    /// @brief Есть ли хотя бы один драйвер
+    bool hasDrivers() const { return !drivers.isEmpty(); }
+    /// @brief Запуск потоков пула
+    bool start() override;
+    QString description() const override;
+    /// @brief Опросы, выполненные не своим потоком
+    quint64 stolenPolls() const { return stolen.load(std::memory_order_relaxed); }
+    /// @brief Количество отсчётов, отброшенных из-за переполнения очереди
+    quint64 droppedSamples() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    /// @brief Запланированный опрос драйвера
+    struct Task {
+        /// Время опроса, мс по clock
+        qint64 due;
+        /// Индекс драйвера
+        int driver;
+        /// Драйвер уже открыт
+        bool opened;
+
+        /// @brief Порядок кучи: сверху ближайший опрос
+        static bool later(const Task &a, const Task &b) { return a.due > b.due; }
+    };
+    /// @brief Поток пула
+    struct Worker {
+        /// Поток
+        QThread *thread = nullptr;
+        /// Защищает tasks
+        QMutex mutex;
+        /// Пробуждение при остановке
+        QWaitCondition wake;
+        /// Опросы потока, куча по времени
+        QVector<Task> tasks;
+        /// Отсчёты потока: пишет поток, читает поток хаба
+        SpscQueue<SensorSample, QUEUESIZE> queue;
+    };
+
+    /// Драйверы
+    QVector<SensorDriver*> drivers;
+    /// Запрошенное количество потоков
+    int threadCount;
+    /// Потоки
+    std::unique_ptr<Worker[]> workers;
+    /// Количество запущенных потоков
+    int workerCount = 0;
+    /// Часы планирования
+    QElapsedTimer clock;
+    /// Потоки работают
+    std::atomic<bool> running{false};
+    /// Разбор очередей уже запланирован
+    std::atomic<bool> drainPending{false};
+    /// Опросы, выполненные не своим потоком
+    std::atomic<quint64> stolen{0};
+    /// Количество отброшенных отсчётов
+    std::atomic<quint64> dropped{0};
+
+    /// @brief Цикл потока пула
+    void work(int w);
+    /// @brief Свой опрос, время которого пришло
+    bool takeDue(int w, Task *task);
+    /// @brief Просроченный опрос другого потока
+    bool steal(int w, Task *task);
+    /// @brief Опрос драйвера и планирование следующего
+    void run(int w, Task &task);
+    /// @brief Постановка опроса в очередь потока
+    void schedule(int w, const Task &task);
+    /// @brief Время ближайшего опроса по всем потокам
+    qint64 nextDue();
+    /// @brief Разбор очередей отсчётов (поток хаба)
+    void drain();
+    /// @brief Остановка потоков
+    void stop();
+};
+
+#endif // DRIVERPOOL_H
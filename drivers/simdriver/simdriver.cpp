@@ -0,0 +1,61 @@
+#include "simdriver.h"
+#include <QThread>
+#include <QRandomGenerator>
+#include <QStringList>
+
+SimDriver::SimDriver(const QString &config)
+{
+    const QStringList pairs = config.split(';', Qt::SkipEmptyParts);
+    for (const QString &pair : pairs) {
+        QString key = pair.section('=', 0, 0).trimmed();
+        QString value = pair.section('=', 1).trimmed();
+        bool ok = true;
+        if (key == "interval") {
+            period = value.toInt(&ok);
+            ok = ok && period > 0;
+        } else if (key == "latency") {
+            latency = value.toInt(&ok);
+            ok = ok && latency >= 0;
+        } else if (key == "channels") {
+            enabled[SensorSample::Temperature] = value.contains('t');
+            enabled[SensorSample::Humidity] = value.contains('h');
+            enabled[SensorSample::Pressure] = value.contains('p');
+        } else {
+            ok = false;
+        }
+        valid = valid && ok;
+    }
+}
+
+int SimDriver::poll(SensorSample *out, int capacity)
+{
+    /// Опрос блокирует поток пула, как ожидание ответа прибора
+    if (latency > 0)
+        QThread::msleep(ulong(latency));
+    QRandomGenerator *rnd = QRandomGenerator::global();
+    static constexpr qreal STEP[SensorSample::ChannelCount] = {0.1, 0.5, 0.2};
+    int count = 0;
+    for (int c = 0; c < SensorSample::ChannelCount && count < capacity; ++c) {
+        if (!enabled[c])
+            continue;
+        values[c] += (int(rnd->bounded(3)) - 1) * STEP[c];
+        /// Время отсчёта проставит пул
+        out[count++] = {SensorSample::Channel(c), values[c], 0};
+    }
+    return count;
+}
+
+QString SimDriver::description() const
+{
+    return QString("simulator (interval %1 ms, latency %2 ms)").arg(period).arg(latency);
+}
+
+SensorDriver *SimDriverFactory::create(const QString &config)
+{
+    SimDriver *driver = new SimDriver(config);
+    if (!driver->isValid()) {
+        delete driver;
+        return nullptr;
+    }
+    return driver;
+}
@@ -0,0 +1,63 @@
+/**
+* @file
+* @brief Заголовочный файл драйвера-имитатора датчиков
+*
+* Параметры драйвера - пары "ключ=значение" через ';':
+*
+*     interval=500;latency=30;channels=thp
+*
+* interval - интервал опроса, мс; latency - длительность одного опроса, мс (имитация ответа прибора
+* по медленной шине); channels - выдаваемые величины: t (температура), h (влажность), p (давление).
+*/
+#ifndef SIMDRIVER_H
+#define SIMDRIVER_H
+
+#include <QObject>
+#include "sensordriver.h"
+
+/**
+ * @class SimDriver
+ * @brief Имитатор датчиков
+ *
+ * Значения медленно меняются около 21.5 °C, 45 % и 760 мм рт.ст.
+ */
+class SimDriver : public SensorDriver
+{
+public:
+    /// @param config Параметры драйвера
+    explicit SimDriver(const QString &config);
+    bool open() override { return true; }
+    int poll(SensorSample *out, int capacity) override;
+    int interval() const override { return period; }
+    QString description() const override;
+    /// @brief Параметры разобраны без ошибок
+    bool isValid() const { return valid; }
+
+private:
+    /// Интервал опроса, мс
+    int period = 1000;
+    /// Длительность опроса, мс
+    int latency = 0;
+    /// Выдаваемые величины
+    bool enabled[SensorSample::ChannelCount] = {true, true, true};
+    /// Текущие значения
+    qreal values[SensorSample::ChannelCount] = {21.5, 45, 760};
+    /// Параметры разобраны без ошибок
+    bool valid = true;
+};
+
+/**
+ * @class SimDriverFactory
+ * @brief Плагин драйвера-имитатора
+ */
+class SimDriverFactory : public QObject, public SensorDriverFactory
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID SensorDriverFactory_iid)
+    Q_INTERFACES(SensorDriverFactory)
+public:
+    QString vendor() const override { return "Simulator"; }
+    SensorDriver *create(const QString &config) override;
+};
+
+#endif // SIMDRIVER_H
@@ -0,0 +1,16 @@
+# Пример драйвера датчиков: имитатор с настраиваемым интервалом и задержкой опроса.
+# Собирается в плагин, который загружает приложение или acdaemon: --driver <путь к библиотеке>[,<параметры>]
+TEMPLATE = lib
+CONFIG += plugin c++17
+QT = core
+
+TARGET = simdriver
+
+INCLUDEPATH += ../..
+
+HEADERS += \
+    ../../sensordriver.h \
+    simdriver.h
+
+SOURCES += \
+    simdriver.cpp
@@ -0,0 +1,70 @@
+#include "fleetmodel.h"
+#include <cstring>
+
+FleetModel::FleetModel(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void FleetModel::resize(int count)
+{
+    int old = ids.size();
+    ids.resize(count);
+    temperatures.resize(count);
+    targetTemps.resize(count);
+    states.resize(count);
+    /// Новые кондиционеры нумеруются по порядку и считаются включенными, температура по умолчанию 20 °C
+    float defaultTemp = float(Units::fromBase(unit).apply(20.0));
+    for (int i = old; i < count; ++i) {
+        ids[i] = quint32(i + 1);
+        temperatures[i] = defaultTemp;
+        targetTemps[i] = defaultTemp;
+        states[i] = PowerOn;
+    }
+    emit countChanged(count);
+}
+
+bool FleetModel::clampRange(int first, int &n) const
+{
+    if (first < 0 || first >= ids.size() || n <= 0)
+        return false;
+    n = qMin(n, ids.size() - first);
+    return true;
+}
+
+void FleetModel::setTemperatures(int first, const float *values, int n)
+{
+    if (!clampRange(first, n))
+        return;
+    std::memcpy(temperatures.data() + first, values, sizeof(float) * size_t(n));
+    emit rangeChanged(first, first + n - 1);
+}
+
+void FleetModel::setTargetTemps(int first, const float *values, int n)
+{
+    if (!clampRange(first, n))
+        return;
+    std::memcpy(targetTemps.data() + first, values, sizeof(float) * size_t(n));
+    emit rangeChanged(first, first + n - 1);
+}
+
+void FleetModel::setFlags(int first, const quint8 *values, int n)
+{
+    if (!clampRange(first, n))
+        return;
+    std::memcpy(states.data() + first, values, size_t(n));
+    emit rangeChanged(first, first + n - 1);
+}
+
+void FleetModel::setTempUnit(Units::TempUnit to)
+{
+    if (to == unit || ids.isEmpty()) {
+        unit = to;
+        return;
+    }
+    Units::Affine conv = Units::conversion(unit, to);
+    Units::convert(temperatures.constData(), temperatures.data(), size_t(temperatures.size()), conv);
+    Units::convert(targetTemps.constData(), targetTemps.data(), size_t(targetTemps.size()), conv);
+    unit = to;
+    emit rangeChanged(0, ids.size() - 1);
+}
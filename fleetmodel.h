@@ -0,0 +1,115 @@
+/**
+* @file
+* @brief Заголовочный файл модели парка кондиционеров
+*
+* Данные тысяч кондиционеров хранятся по столбцам (structure of arrays): отдельный массив на каждое поле.
+* Массовое обновление одного поля проходит по непрерывной памяти и не трогает остальные поля.
+*/
+#ifndef FLEETMODEL_H
+#define FLEETMODEL_H
+
+#include <QObject>
+#include <QVector>
+#include "units.h"
+
+/**
+ * @class FleetModel
+ * @brief Модель парка кондиционеров
+ */
+class FleetModel : public QObject
+{
+    Q_OBJECT
+public:
+    /// Флаги состояния кондиционера
+    enum Flag : quint8 {
+        /// Кондиционер включен
+        PowerOn = 0x01,
+        /// Нет связи с кондиционером
+        Offline = 0x02,
+        /// Авария
+        Alarm = 0x04
+    };
+
+    explicit FleetModel(QObject *parent = nullptr);
+    /**
+     * @brief Установка количества кондиционеров
+     *
+     * Новые кондиционеры получают значения по умолчанию
+     * @param count Количество
+     */
+    void resize(int count);
+    /// @brief Количество кондиционеров
+    int count() const { return ids.size(); }
+
+    /// @brief Номер кондиционера
+    quint32 id(int i) const { return ids[i]; }
+    /// @brief Температура в помещении
+    float temperature(int i) const { return temperatures[i]; }
+    /// @brief Желаемая температура
+    float targetTemp(int i) const { return targetTemps[i]; }
+    /// @brief Флаги состояния
+    quint8 flags(int i) const { return states[i]; }
+    /// @brief Единица измерения температур модели
+    Units::TempUnit tempUnit() const { return unit; }
+    /**
+     * @brief Смена единицы измерения температур
+     *
+     * Массивы температур переводятся целиком пакетным преобразованием
+     * @param to Новая единица измерения
+     */
+    void setTempUnit(Units::TempUnit to);
+
+    /**
+     * @brief Массовое обновление температуры
+     * @param first Индекс первого кондиционера
+     * @param values Значения в единицах tempUnit()
+     * @param n Количество значений
+     */
+    void setTemperatures(int first, const float *values, int n);
+    /**
+     * @brief Массовое обновление желаемой температуры
+     * @param first Индекс первого кондиционера
+     * @param values Значения в единицах tempUnit()
+     * @param n Количество значений
+     */
+    void setTargetTemps(int first, const float *values, int n);
+    /**
+     * @brief Массовое обновление флагов состояния
+     * @param first Индекс первого кондиционера
+     * @param values Значения
+     * @param n Количество значений
+     */
+    void setFlags(int first, const quint8 *values, int n);
+
+signals:
+    /**
+     * @brief Данные кондиционеров изменились
+     * @param first Индекс первого изменившегося кондиционера
+     * @param last Индекс последнего изменившегося кондиционера
+     */
+    void rangeChanged(int first, int last);
+    /// @brief Изменилось количество кондиционеров
+    void countChanged(int count);
+
+private:
+    /// Номера кондиционеров
+    QVector<quint32> ids;
+    /// Температура в помещении
+    QVector<float> temperatures;
+    /// Желаемая температура
+    QVector<float> targetTemps;
+    /// Флаги состояния
+    QVector<quint8> states;
+    /// Единица измерения температур
+    Units::TempUnit unit = Units::TempUnit::Celsius;
+
+    /**
+     * @brief Проверка и обрезка диапазона обновления
+     * @param first Индекс первого кондиционера
+     * @param n Количество, уменьшается до границы модели
+     * @return false если диапазон пуст
+     */
+    bool clampRange(int first, int &n) const;
+};
+
+#endif // FLEETMODEL_H
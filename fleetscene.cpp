@@ -0,0 +1,188 @@
+#include "fleetscene.h"
+#include <QPainter>
+#include <QScrollBar>
+#include <QResizeEvent>
+#include <QKeyEvent>
+
+FleetTile::FleetTile(const FleetModel *model, const ThemeEngine *themes)
+    : model(model),
+    themes(themes)
+{
+}
+
+void FleetTile::setIndex(int index)
+{
+    if (unitIndex == index)
+        return;
+    unitIndex = index;
+    update();
+}
+
+QRectF FleetTile::boundingRect() const
+{
+    return QRectF(0, 0, FleetScene::TILEWIDTH, FleetScene::TILEHEIGHT);
+}
+
+void FleetTile::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(option);
+    Q_UNUSED(widget);
+    if (unitIndex < 0 || unitIndex >= model->count())
+        return;
+    quint8 flags = model->flags(unitIndex);
+    bool active = (flags & FleetModel::PowerOn) && !(flags & FleetModel::Offline);
+    /// Плитка рисуется стилем кнопки тёмной темы: выключенный или недоступный кондиционер - "выключенной" палитрой
+    const ButtonStyle &style = themes->palette(true, active).button;
+
+    QRectF rect = boundingRect();
+    painter->fillRect(rect, style.background);
+    painter->setPen((flags & FleetModel::Alarm) ? QPen(Qt::red, 2) : style.border);
+    painter->drawRect(rect.adjusted(1, 1, -1, -1));
+
+    QRectF text = rect.adjusted(8, 4, -8, -4);
+    painter->setPen(style.text);
+    painter->drawText(text, Qt::AlignLeft | Qt::AlignTop, QString("AC-%1").arg(model->id(unitIndex)));
+    if (flags & FleetModel::Offline) {
+        painter->drawText(text, Qt::AlignLeft | Qt::AlignVCenter, "нет связи");
+        return;
+    }
+    const QString &unit = Units::symbol(model->tempUnit());
+    painter->drawText(text, Qt::AlignLeft | Qt::AlignVCenter,
+                      QString("%1 %2").arg(double(model->temperature(unitIndex)), 0, 'f', 1).arg(unit));
+    painter->drawText(text, Qt::AlignLeft | Qt::AlignBottom,
+                      QString("цель %1 %2").arg(double(model->targetTemp(unitIndex)), 0, 'f', 1).arg(unit));
+}
+
+FleetScene::FleetScene(FleetModel *model, QObject *parent)
+    : QGraphicsScene(parent),
+    model(model)
+{
+    /// Плитки постоянно переиспользуются, индекс сцены только замедлял бы их перемещение
+    setItemIndexMethod(QGraphicsScene::NoIndex);
+    setBackgroundBrush(themes.palette(true, true).background);
+    connect(model, &FleetModel::rangeChanged, this, &FleetScene::onRangeChanged);
+    connect(model, &FleetModel::countChanged, this, &FleetScene::relayout);
+    relayout();
+}
+
+void FleetScene::setWidth(qreal width)
+{
+    int cols = qMax(1, int(width - TILESPACING) / (TILEWIDTH + TILESPACING));
+    if (cols == columns)
+        return;
+    columns = cols;
+    relayout();
+}
+
+QPointF FleetScene::tilePos(int index) const
+{
+    int row = index / columns;
+    int col = index % columns;
+    return QPointF(TILESPACING + col * (TILEWIDTH + TILESPACING), TILESPACING + row * (TILEHEIGHT + TILESPACING));
+}
+
+void FleetScene::relayout()
+{
+    int rows = (model->count() + columns - 1) / columns;
+    setSceneRect(0, 0, TILESPACING + columns * (TILEWIDTH + TILESPACING), TILESPACING + rows * (TILEHEIGHT + TILESPACING));
+    /// Все плитки возвращаются в пул и раздаются заново
+    for (FleetTile *tile : qAsConst(active)) {
+        tile->hide();
+        pool.append(tile);
+    }
+    active.clear();
+    setVisibleRect(visible);
+}
+
+void FleetScene::setVisibleRect(const QRectF &rect)
+{
+    visible = rect;
+    int count = model->count();
+    if (count == 0 || rect.isEmpty())
+        return;
+
+    /// Диапазон видимых кондиционеров определяется по строкам сетки
+    int stepY = TILEHEIGHT + TILESPACING;
+    int firstRow = qMax(0, int(rect.top()) / stepY);
+    int lastRow = qMax(0, int(rect.bottom()) / stepY);
+    int first = firstRow * columns;
+    int last = qMin(count - 1, (lastRow + 1) * columns - 1);
+
+    /// Плитки, ушедшие из видимой области, возвращаются в пул
+    for (auto it = active.begin(); it != active.end();) {
+        if (it.key() < first || it.key() > last) {
+            it.value()->hide();
+            pool.append(it.value());
+            it = active.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    /// Новые видимые кондиционеры получают плитки из пула, новые плитки создаются только если пул пуст
+    for (int i = first; i <= last; ++i) {
+        if (active.contains(i))
+            continue;
+        FleetTile *tile;
+        if (!pool.isEmpty()) {
+            tile = pool.takeLast();
+        } else {
+            tile = new FleetTile(model, &themes);
+            addItem(tile);
+        }
+        tile->setIndex(i);
+        tile->setPos(tilePos(i));
+        tile->show();
+        active.insert(i, tile);
+    }
+}
+
+void FleetScene::onRangeChanged(int first, int last)
+{
+    /// Перерисовываются только видимые плитки: обходится меньшее из диапазона и списка видимых
+    if (last - first + 1 > active.size()) {
+        for (auto it = active.cbegin(); it != active.cend(); ++it)
+            if (it.key() >= first && it.key() <= last)
+                it.value()->update();
+    } else {
+        for (int i = first; i <= last; ++i)
+            if (FleetTile *tile = active.value(i, nullptr))
+                tile->update();
+    }
+}
+
+FleetView::FleetView(FleetScene *scene, QWidget *parent)
+    : QGraphicsView(scene, parent),
+    fleet(scene)
+{
+    setAlignment(Qt::AlignLeft | Qt::AlignTop);
+    setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+}
+
+void FleetView::scrollContentsBy(int dx, int dy)
+{
+    QGraphicsView::scrollContentsBy(dx, dy);
+    updateVisibleRect();
+}
+
+void FleetView::resizeEvent(QResizeEvent *event)
+{
+    QGraphicsView::resizeEvent(event);
+    fleet->setWidth(viewport()->width());
+    updateVisibleRect();
+}
+
+void FleetView::keyPressEvent(QKeyEvent *event)
+{
+    /// Клавиша U переключает единицы измерения температуры всего парка
+    if (event->key() == Qt::Key_U) {
+        FleetModel *model = fleet->fleetModel();
+        model->setTempUnit(Units::next(model->tempUnit()));
+        return;
+    }
+    QGraphicsView::keyPressEvent(event);
+}
+
+void FleetView::updateVisibleRect()
+{
+    fleet->setVisibleRect(mapToScene(viewport()->rect()).boundingRect());
+}
@@ -0,0 +1,134 @@
+/**
+* @file
+* @brief Заголовочный файл обзора парка кондиционеров
+*
+* Кондиционеры показываются плитками в сетке. Элементы сцены создаются только для видимых плиток:
+* при прокрутке плитки, ушедшие за край окна, возвращаются в пул и используются для новых кондиционеров.
+* Плитки рисуются сами, без прокси-виджетов.
+*/
+#ifndef FLEETSCENE_H
+#define FLEETSCENE_H
+
+#include <QGraphicsScene>
+#include <QGraphicsView>
+#include <QGraphicsItem>
+#include <QHash>
+#include <QVector>
+#include "fleetmodel.h"
+#include "themeengine.h"
+
+/**
+ * @class FleetTile
+ * @brief Плитка одного кондиционера
+ */
+class FleetTile : public QGraphicsItem
+{
+public:
+    /// Тип элемента для qgraphicsitem_cast
+    enum { Type = UserType + 3 };
+
+    /**
+     * @param model Модель парка
+     * @param themes Палитры темы
+     */
+    FleetTile(const FleetModel *model, const ThemeEngine *themes);
+    /// @brief Привязка плитки к кондиционеру
+    void setIndex(int index);
+    /// @brief Индекс кондиционера
+    int index() const { return unitIndex; }
+
+    QRectF boundingRect() const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+    int type() const override { return Type; }
+
+private:
+    /// Модель парка
+    const FleetModel *model;
+    /// Палитры темы
+    const ThemeEngine *themes;
+    /// Индекс кондиционера
+    int unitIndex = -1;
+};
+
+/**
+ * @class FleetScene
+ * @brief Сцена с плитками парка кондиционеров
+ */
+class FleetScene : public QGraphicsScene
+{
+    Q_OBJECT
+public:
+    /// Ширина плитки
+    static constexpr int TILEWIDTH = 160;
+    /// Высота плитки
+    static constexpr int TILEHEIGHT = 90;
+    /// Отступ между плитками
+    static constexpr int TILESPACING = 6;
+
+    /**
+     * @param model Модель парка
+     * @param parent Родительский объект
+     */
+    explicit FleetScene(FleetModel *model, QObject *parent = nullptr);
+    /**
+     * @brief Установка видимой области
+     *
+     * Плитки создаются для видимых кондиционеров, остальные возвращаются в пул
+     * @param rect Видимая область в координатах сцены
+     */
+    void setVisibleRect(const QRectF &rect);
+    /// @brief Установка ширины сцены, от неё зависит количество колонок
+    void setWidth(qreal width);
+    /// @brief Модель парка
+    FleetModel *fleetModel() const { return model; }
+    /// @brief Количество созданных плиток (видимых и в пуле)
+    int tileCount() const { return active.size() + pool.size(); }
+
+private:
+    /// Модель парка
+    FleetModel *model;
+    /// Палитры темы
+    ThemeEngine themes;
+    /// Количество колонок
+    int columns = 1;
+    /// Видимая область
+    QRectF visible;
+    /// Видимые плитки по индексу кондиционера
+    QHash<int, FleetTile*> active;
+    /// Свободные плитки
+    QVector<FleetTile*> pool;
+
+    /// @brief Пересчёт размера сцены и положения всех видимых плиток
+    void relayout();
+    /// @brief Положение плитки кондиционера
+    QPointF tilePos(int index) const;
+    /// @brief Перерисовка видимых плиток из диапазона
+    void onRangeChanged(int first, int last);
+};
+
+/**
+ * @class FleetView
+ * @brief Окно обзора парка
+ *
+ * Сообщает сцене видимую область при прокрутке и изменении размера
+ */
+class FleetView : public QGraphicsView
+{
+    Q_OBJECT
+public:
+    explicit FleetView(FleetScene *scene, QWidget *parent = nullptr);
+
+protected:
+    void scrollContentsBy(int dx, int dy) override;
+    void resizeEvent(QResizeEvent *event) override;
+    /// @brief Клавиша U переключает единицы измерения температуры
+    void keyPressEvent(QKeyEvent *event) override;
+
+private:
+    /// Сцена парка
+    FleetScene *fleet;
+    /// @brief Передача видимой области сцене
+    void updateVisibleRect();
+};
+
+#endif // FLEETSCENE_H
@@ -0,0 +1,82 @@
+#include "huditem.h"
+#include "metrics.h"
+#include <QPainter>
+#include <QFontMetricsF>
+#include <QTimer>
+
+namespace {
+/// @brief Наносекунды в миллисекундах для показа
+QString ms(qint64 ns)
+{
+    return QString::number(double(ns) / 1e6, 'f', 2) + " мс";
+}
+}
+
+HudItem::HudItem(const SceneTimings *timings, QGraphicsItem *parent)
+    : QGraphicsObject(parent),
+    timings(timings),
+    timer(new QTimer(this)),
+    font("Monospace", 9)
+{
+    font.setStyleHint(QFont::TypeWriter);
+    /// Панель поверх всех элементов и не перехватывает нажатия
+    setZValue(1000);
+    setAcceptedMouseButtons(Qt::NoButton);
+    /// Между обновлениями текста панель рисуется из кэша
+    setCacheMode(DeviceCoordinateCache);
+    timer->setInterval(INTERVAL);
+    connect(timer, &QTimer::timeout, this, &HudItem::refresh);
+    timer->start();
+    refresh();
+}
+
+QRectF HudItem::boundingRect() const
+{
+    return rect;
+}
+
+void HudItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(option);
+    Q_UNUSED(widget);
+    painter->fillRect(rect, QColor(0, 0, 0, 170));
+    painter->setPen(Qt::white);
+    painter->setFont(font);
+    painter->drawText(rect.adjusted(PADDING, PADDING, -PADDING, -PADDING), Qt::AlignLeft | Qt::AlignTop, text);
+}
+
+QVariant HudItem::itemChange(GraphicsItemChange change, const QVariant &value)
+{
+    if (change == ItemVisibleHasChanged) {
+        if (value.toBool()) {
+            refresh();
+            timer->start();
+        } else {
+            timer->stop();
+        }
+    }
+    return QGraphicsObject::itemChange(change, value);
+}
+
+void HudItem::refresh()
+{
+    qint64 rss = Metrics::residentMemory();
+    qint64 perItem = frame.paintedItems ? frame.paintTime / frame.paintedItems : 0;
+    QString lines = QString("кадр: %1\nотрисовка: %2, на элемент %3 (%4)\nобласти: %5\napplyTheme: %6\nplaceAllBlocks: %7\nRSS: %8")
+            .arg(ms(frame.frameInterval), ms(frame.paintTime), ms(perItem))
+            .arg(frame.paintedItems)
+            .arg(frame.dirtyRects)
+            .arg(ms(timings->applyTheme), ms(timings->placeAllBlocks),
+                 rss >= 0 ? QString::number(double(rss) / (1024 * 1024), 'f', 1) + " МБ" : QString("н/д"));
+    /// Пока ничего не изменилось, кэш не сбрасывается и панель не перерисовывается
+    if (lines == text)
+        return;
+    text = lines;
+    QRectF textRect = QFontMetricsF(font).boundingRect(QRectF(0, 0, 10000, 10000), Qt::AlignLeft | Qt::AlignTop, text);
+    QRectF newRect(0, 0, textRect.width() + 2 * PADDING, textRect.height() + 2 * PADDING);
+    if (newRect != rect) {
+        prepareGeometryChange();
+        rect = newRect;
+    }
+    update();
+}
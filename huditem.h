@@ -0,0 +1,97 @@
+/**
+* @file
+* @brief Заголовочный файл панели производительности
+*
+* Панель поверх интерфейса для наладчиков: время кадра и отрисовки, количество перерисованных областей,
+* длительность последних применения темы и размещения элементов, резидентная память процесса.
+* Текст собирается не чаще двух раз в секунду, между обновлениями панель рисуется из кэша.
+*/
+#ifndef HUDITEM_H
+#define HUDITEM_H
+
+#include <QGraphicsObject>
+#include <QFont>
+
+class QTimer;
+
+/**
+ * @struct SceneTimings
+ * @brief Длительность последних тяжёлых операций сцены, нс
+ */
+struct SceneTimings {
+    /// Последнее применение темы
+    qint64 applyTheme = 0;
+    /// Последнее полное размещение элементов
+    qint64 placeAllBlocks = 0;
+};
+
+/**
+ * @struct FrameStats
+ * @brief Замеры последнего кадра окна
+ */
+struct FrameStats {
+    /// Время с предыдущего кадра, нс
+    qint64 frameInterval = 0;
+    /// Время отрисовки, нс
+    qint64 paintTime = 0;
+    /// Количество перерисованных прямоугольников
+    int dirtyRects = 0;
+    /// Количество элементов в перерисованной области
+    int paintedItems = 0;
+};
+
+/**
+ * @class HudItem
+ * @brief Панель производительности
+ */
+class HudItem : public QGraphicsObject
+{
+    Q_OBJECT
+public:
+    /// Тип элемента для qgraphicsitem_cast
+    enum { Type = UserType + 4 };
+    /// Интервал обновления текста, мс
+    static constexpr int INTERVAL = 500;
+
+    /**
+     * @param timings Длительность операций сцены
+     * @param parent Родительский элемент
+     */
+    explicit HudItem(const SceneTimings *timings, QGraphicsItem *parent = nullptr);
+    /**
+     * @brief Замеры последнего кадра
+     *
+     * Вызывается окном после каждой отрисовки, только запоминает значения
+     */
+    void setFrameStats(const FrameStats &stats) { frame = stats; }
+
+    QRectF boundingRect() const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+    int type() const override { return Type; }
+
+protected:
+    /// @brief Обновление останавливается, пока панель скрыта
+    QVariant itemChange(GraphicsItemChange change, const QVariant &value) override;
+
+private:
+    /// Отступ текста от края панели
+    static constexpr qreal PADDING = 6;
+
+    /// Длительность операций сцены
+    const SceneTimings *timings;
+    /// Замеры последнего кадра
+    FrameStats frame;
+    /// Таймер обновления текста
+    QTimer *timer;
+    /// Шрифт панели
+    QFont font;
+    /// Отображаемый текст
+    QString text;
+    /// Размер панели
+    QRectF rect;
+
+    /// @brief Сборка текста, перерисовка только если текст изменился
+    void refresh();
+};
+
+#endif // HUDITEM_H
@@ -97,7 +97,7 @@ void InputDialog::setValues(Preferences* prefs)
     setMinMaxVals(prefs);
 
     /// Лейбл "Температура" с текущей ЕИ
-    tempLabel->setText(QString("Температура (%1)").arg(prefs->getTempUnit()));
+    tempLabel->setText(QString("Температура (%1)").arg(Units::symbol(prefs->getTempUnit())));
     /// Задаётся текущее значение внешней температуры
     tempEdit->setValue(prefs->getTempVal());
 
@@ -106,7 +106,7 @@ void InputDialog::setValues(Preferences* prefs)
     humidityEdit->setValue(prefs->getHumidityVal());
 
     /// Лейбл "Давление" с текущей ЕИ
-    pressureLabel->setText(QString("Давление (%1)").arg(prefs->getPressureUnit()));
+    pressureLabel->setText(QString("Давление (%1)").arg(Units::symbol(prefs->getPressureUnit())));
     /// Задаётся текущее значение внешнего давления
     pressureEdit->setValue(prefs->getPressureVal());
 }
@@ -1,50 +1,176 @@
 #include <QApplication>
-#include <QGraphicsView>
+#include <QCommandLineParser>
 #include "mainscene.h"
+#include "mainview.h"
 #include "inputdialog.h"
+#include "controllercore.h"
+#include "fleetscene.h"
+#include "modbus.h"
+#include <QRandomGenerator>
+#include <QTimer>
+
+/**
+ * @brief Опрос парка по Modbus TCP
+ *
+ * Кондиционеры распределяются по адресам по порядку, за одним шлюзом - не больше Modbus::MAXUNITS.
+ * Адрес sim запускает встроенные имитаторы на все оставшиеся кондиционеры.
+ * @param poller Опрос
+ * @param simulators Родитель встроенных имитаторов
+ * @param count Количество кондиционеров
+ * @param addresses Адреса --modbus
+ * @return Количество опрашиваемых кондиционеров
+ */
+static int addFleetUnits(ModbusPoller &poller, QObject *simulators, int count, const QStringList &addresses)
+{
+    int assigned = 0;
+    for (const QString &spec : addresses) {
+        if (spec == "sim") {
+            while (assigned < count) {
+                ModbusServer *server = new ModbusServer(qMin(Modbus::MAXUNITS, count - assigned), simulators);
+                if (!server->listen())
+                    break;
+                for (int id = 1; id <= server->unitCount(); ++id, ++assigned)
+                    poller.addUnit("127.0.0.1", server->port(), quint8(id));
+            }
+            continue;
+        }
+        QString host;
+        quint16 port;
+        quint8 first;
+        if (!Modbus::parseEndpoint(spec, &host, &port, &first)) {
+            qWarning("Неверный адрес Modbus: %s", qPrintable(spec));
+            continue;
+        }
+        for (int id = first; id <= Modbus::MAXUNITS && assigned < count; ++id, ++assigned)
+            poller.addUnit(host, port, quint8(id));
+    }
+    if (assigned < count)
+        qWarning("Адресов Modbus хватает на %d кондиционеров из %d", assigned, count);
+    return assigned;
+}
+
+/**
+ * @brief Режим обзора парка кондиционеров
+ *
+ * С адресами --modbus температуры, желаемые температуры и состояние читаются с кондиционеров раз в секунду,
+ * без них раз в секунду имитируется массовое обновление всех температур.
+ * @param app Приложение
+ * @param count Количество кондиционеров
+ * @param modbus Адреса --modbus
+ * @return Код завершения приложения
+ */
+static int runFleet(QApplication &app, int count, const QStringList &modbus)
+{
+    FleetModel model;
+    model.resize(count);
+    FleetScene scene(&model);
+    FleetView view(&scene);
+    view.resize(1024, 768);
+    view.show();
+
+    if (!modbus.isEmpty()) {
+        /// Опрос идёт в цикле событий без ожиданий: сотни кондиционеров не задерживают отрисовку
+        QObject simulators;
+        ModbusPoller poller;
+        int n = addFleetUnits(poller, &simulators, count, modbus);
+        QVector<float> temps(n);
+        QVector<float> targets(n);
+        QVector<quint8> flags(n);
+        QObject::connect(&poller, &ModbusPoller::cycleFinished, [&]() {
+            for (int i = 0; i < n; ++i) {
+                const ModbusPoller::Unit &unit = poller.unit(i);
+                temps[i] = float(Modbus::Map::decode(unit.input[Modbus::Map::Temperature]));
+                targets[i] = float(Modbus::Map::decode(unit.holding[Modbus::Map::TargetTemp]));
+                flags[i] = !unit.online() ? quint8(FleetModel::Offline)
+                                          : unit.holding[Modbus::Map::Power] ? quint8(FleetModel::PowerOn) : quint8(0);
+            }
+            /// Регистры хранят °C, модель - в выбранной единице
+            Units::Affine conv = Units::conversion(Units::TempUnit::Celsius, model.tempUnit());
+            Units::convert(temps.constData(), temps.data(), std::size_t(n), conv);
+            Units::convert(targets.constData(), targets.data(), std::size_t(n), conv);
+            model.setTemperatures(0, temps.constData(), n);
+            model.setTargetTemps(0, targets.constData(), n);
+            model.setFlags(0, flags.constData(), n);
+        });
+        poller.start();
+        return app.exec();
+    }
+
+    QVector<float> temps(count);
+    QTimer simulation;
+    QObject::connect(&simulation, &QTimer::timeout, [&]() {
+        QRandomGenerator *rnd = QRandomGenerator::global();
+        for (int i = 0; i < count; ++i)
+            temps[i] = model.temperature(i) + float(rnd->bounded(21) - 10) / 20.0f;
+        model.setTemperatures(0, temps.constData(), count);
+    });
+    simulation.start(1000);
+    return app.exec();
+}
 
 int main(int argc, char *argv[])
 {
     QApplication app(argc, argv);
     app.setApplicationDisplayName("Система управление кондиционером");
+
+    /// Параметры командной строки: источники данных датчиков, импорт и экспорт настроек
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    ControllerCore::addOptions(parser);
+    QCommandLineOption fleetOption("fleet", "Обзор парка из <count> кондиционеров вместо одного.", "count");
+    parser.addOption(fleetOption);
+    QCommandLineOption hudOption("hud", "Панель производительности поверх интерфейса (также Ctrl+Shift+H).");
+    parser.addOption(hudOption);
+    QCommandLineOption lowPowerOption("low-power", "Режим отрисовки для панелей без GPU: кэширование и ограничение частоты кадров.");
+    parser.addOption(lowPowerOption);
+    QCommandLineOption maxFpsOption("max-fps", "Наибольшая частота кадров в режиме --low-power (по умолчанию 25).", "fps");
+    parser.addOption(maxFpsOption);
+    parser.process(app);
+
+    int exitCode = 0;
+    if (ControllerCore::importExport(parser, &exitCode))
+        return exitCode;
+
+    if (parser.isSet(fleetOption))
+        return runFleet(app, qMax(1, parser.value(fleetOption).toInt()), parser.values("modbus"));
+
+    /// Ядро: настройки, датчики и их сохранение. То же ядро работает в acdaemon без интерфейса.
+    ControllerCore core;
+    core.configure(parser);
+
     /// Класс MainScene инициализируется, как QGraphicsScene
-    MainScene *scene = new MainScene();
-    QSize res = scene->prefs->getResolution();
-    /// Создаётся QGraphicsView для показа MainScene
-    QGraphicsView *view = new QGraphicsView(scene);
-
-    view->setSceneRect(0,0,res.width(),res.height());
-    view->setFixedSize(res);
-
-    /// Отключение горизонтальных скроллбаров
-    view->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-    /// Отключение вертикальных скроллбаров
-    view->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    MainScene *scene = new MainScene(core.prefs());
+    /// Окно показа MainScene, размер окна следует разрешению из настроек
+    MainView *view = new MainView(scene);
+    scene->setHudVisible(parser.isSet(hudOption));
+    if (parser.isSet(lowPowerOption))
+        view->setRenderMode(MainView::LowPower, parser.isSet(maxFpsOption) ? parser.value(maxFpsOption).toInt()
+                                                                          : MainView::DEFAULT_MAXFPS);
     view->show();
 
+    SensorHub *sensors = core.sensors();
+    if (sensors->hasSources())
+        scene->attachHistory(&sensors->history(SensorSample::Temperature),
+                             &sensors->history(SensorSample::Humidity),
+                             &sensors->history(SensorSample::Pressure));
+    /// Значения обновляются по сигналам Preferences, здесь остаётся дорисовать графики истории
+    QObject::connect(sensors, &SensorHub::applied, scene, &MainScene::refreshHistory);
+    core.start();
+
     /// @brief Сохранение параметров при выходе
-    QObject::connect(&app, &QApplication::aboutToQuit, [scene]() {
-        scene->savePrefs();
-    });
+    QObject::connect(&app, &QApplication::aboutToQuit, &core, &ControllerCore::stop);
 
-    /// @brief Открытие окна для ввода параметров, и их сохранение
+    /// @brief Открытие окна для ручного ввода параметров, и их сохранение
     QObject::connect(scene,&MainScene::openInputDialog, [&]() {
         InputDialog dialog;
         dialog.setValues(scene->prefs);
         if (dialog.exec() == QDialog::Accepted) {
+            Preferences::Transaction transaction(scene->prefs);
             scene->prefs->setTempVal(dialog.getTemp());
             scene->prefs->setHumidityVal(dialog.getHumidity());
             scene->prefs->setPressureVal(dialog.getPressure());
-            scene->updateValues();
-            scene->updatePos();
         }
     });
 
-    /// @brief Изменение разрешения
-    QObject::connect(scene,&MainScene::resolutionChanged, [&](const QSize &res) {
-        view->setSceneRect(0, 0, res.width(), res.height());
-        view->setFixedSize(res);
-    });
-
     return app.exec();    
 }
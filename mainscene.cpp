@@ -1,46 +1,31 @@
 #include "mainscene.h"
 #include "preferences.h"
+#include "controllercore.h"
 #include "inputdialog.h"
+#include "metrics.h"
 #include <QFont>
 #include <QBrush>
 #include <QColor>
+#include <QPainter>
+#include <QTimer>
 #include <math.h>
 
-CustomButton::CustomButton(const QString &text)
-    : QPushButton(text)
-{
-    bName = text;
-    style = styleSheet();
-    connect(this, &QPushButton::pressed, this, &CustomButton::onPressed);
-    connect(this, &QPushButton::released, this, &CustomButton::onReleased);
-}
-
-void CustomButton::applyButtonTheme(bool dark, bool power) {
-    /// Стиль кнопки определяются двумя факторами: включен ли кондиционер и какая тема активна.
-    /// Доступ к приватным константам MainScene осуществляется, потому что CustomButton - друг
-    this->setStyleSheet(power ?
-        (dark ? MainScene::ItemColor::CLR_buttonDark_ON : MainScene::ItemColor::CLR_buttonLight_ON) :
-        (dark ? MainScene::ItemColor::CLR_buttonDark_OFF : MainScene::ItemColor::CLR_buttonLight_OFF)
-    );
-}
-
-void CustomButton::onPressed() {
-    /// Текущий стиль кнопки сохраняется
-    style = styleSheet();
-    setStyleSheet(MainScene::ItemColor::CLR_buttonPressed);
-}
-
-void CustomButton::onReleased() {
-    /// Стиль кнопки откатывается к сохранённому
-    setStyleSheet(style);
-}
-
-MainScene::MainScene(QObject *parent)
+MainScene::MainScene(Preferences *prefs, QObject *parent)
     : QGraphicsScene(parent),
-    prefs(new Preferences)
+    prefs(prefs)
 {
-    /// Загрузка свойств из xml файла
-    loadPrefs();
+    /// Без ядра свойства загружаются из бинарного снимка и журнала (или xml файла)
+    if (!this->prefs) {
+        this->prefs = new Preferences(this);
+        ControllerCore::loadPrefs(this->prefs);
+    }
+    staticSettle = new QTimer(this);
+    staticSettle->setSingleShot(true);
+    staticSettle->setInterval(STATICSETTLE);
+    connect(staticSettle, &QTimer::timeout, this, [this]() {
+        if (ui_staticLayer->isDirty())
+            ui_staticLayer->rebuild(this->prefs->getResolution(), backgroundBrush());
+    });
     /// Построение графического интерфейса
     setUpUi();
     /// Применение темы
@@ -49,11 +34,48 @@ MainScene::MainScene(QObject *parent)
     updateValues();
     /// Обновление позиций
     updatePos();
+    /// Дальше элементы обновляются по сигналам изменившихся полей
+    bindPrefs();
+}
+
+void MainScene::bindPrefs() {
+    /// Каждое поле обновляет только те элементы, которые его показывают
+    connect(prefs, &Preferences::tempValChanged, this, [this](qreal value) { setItemValue(ui_tempVal, value); });
+    connect(prefs, &Preferences::humidityValChanged, this, [this](qreal value) { setItemValue(ui_humidityVal, value); });
+    connect(prefs, &Preferences::pressureValChanged, this, [this](qreal value) { setItemValue(ui_pressureVal, value); });
+    connect(prefs, &Preferences::targetTempChanged, this, [this](qreal value) { setItemValue(ui_targetTempVal, value); });
+    connect(prefs, &Preferences::tempUnitChanged, this, [this](Units::TempUnit unit) {
+        setItemText(ui_tempUnitLabel, Units::symbol(unit));
+        setItemText(ui_targetTempUnitLabel, Units::symbol(unit));
+    });
+    connect(prefs, &Preferences::pressureUnitChanged, this, [this](Units::PressureUnit unit) {
+        setItemText(ui_pressureUnitLabel, Units::symbol(unit));
+    });
+    connect(prefs, &Preferences::acAngleChanged, this, [this](qreal angle) {
+        /// Линия догонит новый угол в ближайших кадрах, события слайдера между кадрами сливаются
+        vaneAnimator->setTarget(angle);
+        if (ui_acAngleSlider->value() != qRound(angle))
+            ui_acAngleSlider->setValue(qRound(angle));
+    });
+    /// После пакета изменений тема применяется один раз, а переразмещаются только изменившиеся элементы
+    connect(prefs, &Preferences::changed, this, [this](quint32 fields) {
+        if (fields & (Preferences::ThemeField | Preferences::PowerField))
+            applyTheme();
+        /// Выключенный кондиционер не качает заслонку
+        if (fields & (Preferences::SwingField | Preferences::PowerField))
+            vaneAnimator->setSwing(prefs->getSwing() && prefs->getPower());
+        updatePos();
+        /// Активация сигнала, по которой сработает обработчик в main.cpp
+        if (fields & Preferences::ResolutionField)
+            emit resolutionChanged(prefs->getResolution());
+    });
 }
 
 void MainScene::setUpUi(){
     /// Инициализация блоков с данными
     initAllBlocks();
+    /// Добавление элементов в раскладку
+    initLayout();
     /// Размещение кнопок
     placeAllBlocks();
 
@@ -67,19 +89,47 @@ void MainScene::setUpUi(){
     buttons.append(ui_resolutionButton);
     buttons.append(ui_themeButton);
     buttons.append(ui_powerButton);
+    buttons.append(ui_swingButton);
+    /// @}
+
+    /// Добавление в лист всех текстовых элементов, кроме подписи кнопки питания (она всегда "включена")
+    /// @{
+    texts.append(ui_tempLabel);
+    texts.append(ui_humidityLabel);
+    texts.append(ui_pressureLabel);
+    texts.append(ui_targetTempLabel);
+    texts.append(ui_acAngleLabel);
+    readouts.append(ui_tempVal);
+    readouts.append(ui_tempUnitLabel);
+    readouts.append(ui_humidityVal);
+    readouts.append(ui_humidityUnitLabel);
+    readouts.append(ui_pressureVal);
+    readouts.append(ui_pressureUnitLabel);
+    readouts.append(ui_targetTempVal);
+    readouts.append(ui_targetTempUnitLabel);
     /// @}
 
+    /// Заголовки, подпись кнопки питания и корпус кондиционера рисуются одним растровым слоем
+    ui_staticLayer = new StaticLayer;
+    QList<QGraphicsItem*> staticItems;
+    for (auto text : qAsConst(texts))
+        staticItems.append(text);
+    staticItems << ui_powerButtonLabel << ui_acBody;
+    ui_staticLayer->setItems(staticItems);
+    addItem(ui_staticLayer);
+
     /// Привязка сигналов и слотов
     /// @{
-    connect(ui_changeTempUnit, &QPushButton::clicked, this, &MainScene::changeTempUnit);
-    connect(ui_changePressureUnit, &QPushButton::clicked, this, &MainScene::changePressureUnit);
-    connect(ui_tempMinusButton, &QPushButton::clicked, this, &MainScene::onMinusTargetTemp);
-    connect(ui_tempPlusButton, &QPushButton::clicked, this, &MainScene::onPlusTargetTemp);
-    connect(ui_acAngleSlider, &QSlider::valueChanged, this, &MainScene::onSliderChanged);
-    connect(ui_powerButton, &QPushButton::clicked, this, &MainScene::togglePower);
-    connect(ui_resolutionButton, &QPushButton::clicked, this, &MainScene::changeResolution);
-    connect(ui_themeButton, &QPushButton::clicked, this, &MainScene::changeTheme);
-    connect(ui_inputButton, &QPushButton::clicked, this, &MainScene::openInputDialog);
+    connect(ui_changeTempUnit, &CustomButton::clicked, this, &MainScene::changeTempUnit);
+    connect(ui_changePressureUnit, &CustomButton::clicked, this, &MainScene::changePressureUnit);
+    connect(ui_tempMinusButton, &CustomButton::clicked, this, &MainScene::onMinusTargetTemp);
+    connect(ui_tempPlusButton, &CustomButton::clicked, this, &MainScene::onPlusTargetTemp);
+    connect(ui_acAngleSlider, &CustomSlider::valueChanged, this, &MainScene::onSliderChanged);
+    connect(ui_swingButton, &CustomButton::clicked, this, &MainScene::toggleSwing);
+    connect(ui_powerButton, &CustomButton::clicked, this, &MainScene::togglePower);
+    connect(ui_resolutionButton, &CustomButton::clicked, this, &MainScene::changeResolution);
+    connect(ui_themeButton, &CustomButton::clicked, this, &MainScene::changeTheme);
+    connect(ui_inputButton, &CustomButton::clicked, this, &MainScene::openInputDialog);
     /// @}
 }
 
@@ -112,18 +162,16 @@ void MainScene::initTemperatureBlock() {
     ui_tempLabel->setFont(labelFont);
     addItem(ui_tempLabel);
 
-    ui_tempVal = new QGraphicsTextItem(QString::number(prefs->getTempVal(), 'f', 2));
-    ui_tempVal->setFont(valFont);
+    ui_tempVal = new ReadoutItem(valFont);
+    ui_tempVal->setValue(prefs->getTempVal());
     addItem(ui_tempVal);
 
-    ui_tempUnitLabel = new QGraphicsTextItem(prefs->getTempUnit());
-    ui_tempUnitLabel->setFont(labelFont);
+    ui_tempUnitLabel = new ReadoutItem(labelFont);
+    ui_tempUnitLabel->setText(Units::symbol(prefs->getTempUnit()));
     addItem(ui_tempUnitLabel);
 
-    ui_changeTempUnit = new CustomButton("РЕЖИМ");
-    ui_changeTempUnit->setFont(labelFont);
-    ui_tempChangeUnitProxy = new QGraphicsProxyWidget;
-    ui_tempChangeUnitProxy = addWidget(ui_changeTempUnit);
+    ui_changeTempUnit = new CustomButton("РЕЖИМ", labelFont);
+    addItem(ui_changeTempUnit);
 }
 
 void MainScene::initHumidityBlock() {
@@ -131,12 +179,12 @@ void MainScene::initHumidityBlock() {
     ui_humidityLabel->setFont(labelFont);
     addItem(ui_humidityLabel);
 
-    ui_humidityVal = new QGraphicsTextItem(QString::number(prefs->getHumidityVal(), 'f', 2));
-    ui_humidityVal->setFont(valFont);
+    ui_humidityVal = new ReadoutItem(valFont);
+    ui_humidityVal->setValue(prefs->getHumidityVal());
     addItem(ui_humidityVal);
 
-    ui_humidityUnitLabel = new QGraphicsTextItem("%");
-    ui_humidityUnitLabel->setFont(labelFont);
+    ui_humidityUnitLabel = new ReadoutItem(labelFont);
+    ui_humidityUnitLabel->setText("%");
     addItem(ui_humidityUnitLabel);
 }
 
@@ -145,18 +193,16 @@ void MainScene::initPressureBlock() {
     ui_pressureLabel->setFont(labelFont);
     addItem(ui_pressureLabel);
 
-    ui_pressureVal = new QGraphicsTextItem(QString::number(prefs->getPressureVal(), 'f', 2));
-    ui_pressureVal->setFont(valFont);
+    ui_pressureVal = new ReadoutItem(valFont);
+    ui_pressureVal->setValue(prefs->getPressureVal());
     addItem(ui_pressureVal);
 
-    ui_pressureUnitLabel = new QGraphicsTextItem(prefs->getPressureUnit());
-    ui_pressureUnitLabel->setFont(labelFont);
+    ui_pressureUnitLabel = new ReadoutItem(labelFont);
+    ui_pressureUnitLabel->setText(Units::symbol(prefs->getPressureUnit()));
     addItem(ui_pressureUnitLabel);
 
-    ui_changePressureUnit = new CustomButton("РЕЖИМ");
-    ui_changePressureUnit->setFont(labelFont);
-    ui_pressureChangeUnitProxy = new QGraphicsProxyWidget;
-    ui_pressureChangeUnitProxy = addWidget(ui_changePressureUnit);
+    ui_changePressureUnit = new CustomButton("РЕЖИМ", labelFont);
+    addItem(ui_changePressureUnit);
 }
 
 void MainScene::initTargetTempBlock() {
@@ -164,22 +210,18 @@ void MainScene::initTargetTempBlock() {
     ui_targetTempLabel->setFont(labelFont);
     addItem(ui_targetTempLabel);
 
-    ui_targetTempVal = new QGraphicsTextItem(QString::number(prefs->getTargetTemp(), 'f', 2));
-    ui_targetTempVal->setFont(valFont);
+    ui_targetTempVal = new ReadoutItem(valFont);
+    ui_targetTempVal->setValue(prefs->getTargetTemp());
     addItem(ui_targetTempVal);
 
-    ui_targetTempUnitLabel = new QGraphicsTextItem(prefs->getTempUnit());
-    ui_targetTempUnitLabel->setFont(labelFont);
+    ui_targetTempUnitLabel = new ReadoutItem(labelFont);
+    ui_targetTempUnitLabel->setText(Units::symbol(prefs->getTempUnit()));
     addItem(ui_targetTempUnitLabel);
 
-    ui_tempMinusButton = new CustomButton("-");
-    ui_tempMinusButton->setFont(labelFont);
-    ui_tempMinusButtonProxy = new QGraphicsProxyWidget;
-    ui_tempMinusButtonProxy = addWidget(ui_tempMinusButton);
-    ui_tempPlusButton = new CustomButton("+");
-    ui_tempPlusButton->setFont(labelFont);
-    ui_tempPlusButtonProxy = new QGraphicsProxyWidget;
-    ui_tempPlusButtonProxy = addWidget(ui_tempPlusButton);
+    ui_tempMinusButton = new CustomButton("-", labelFont);
+    addItem(ui_tempMinusButton);
+    ui_tempPlusButton = new CustomButton("+", labelFont);
+    addItem(ui_tempPlusButton);
 }
 
 void MainScene::initAirDirectionBlock() {
@@ -188,14 +230,11 @@ void MainScene::initAirDirectionBlock() {
     addItem(ui_acAngleLabel);
 
     /// Вид слайдера - Горизонтальный
-    ui_acAngleSlider = new QSlider(Qt::Horizontal);
+    ui_acAngleSlider = new CustomSlider;
     /// Диапазон значений слайдера
-    /// @todo Убрать "магические" числа, если потребуется отображать значение угла
-    ui_acAngleSlider->setRange(-15, 15);
+    ui_acAngleSlider->setRange(int(Preferences::ACANGLEMIN), int(Preferences::ACANGLEMAX));
     ui_acAngleSlider->setValue(prefs->getAcAngle());
-
-    ui_acAngleSliderProxy = new QGraphicsProxyWidget;
-    ui_acAngleSliderProxy = addWidget(ui_acAngleSlider);
+    addItem(ui_acAngleSlider);
 
     ui_acAngleDirection = new QGraphicsLineItem();
     /// Создаётся QPen для линии направления воздуха
@@ -205,13 +244,14 @@ void MainScene::initAirDirectionBlock() {
     ui_acAngleDirection->setPen(pen);
     /// Линия располагается диагонально
     ui_acAngleDirection->setLine(50,50,150,150);
-    /// Создаётся объект QTransform для вращения линии
-    QTransform transform;
-    /// Вращение линии при изменении положения слайдера
-    transform.rotate(prefs->getAcAngle() * -1);
-    /// Применение QTransform к линии
-    ui_acAngleDirection->setTransform(transform);
     addItem(ui_acAngleDirection);
+    /// Линия поворачивается покадрово, начальный угол - без анимации
+    vaneAnimator = new VaneAnimator(ui_acAngleDirection, Preferences::ACANGLEMIN, Preferences::ACANGLEMAX, this);
+    vaneAnimator->jumpTo(prefs->getAcAngle());
+    vaneAnimator->setSwing(prefs->getSwing() && prefs->getPower());
+
+    ui_swingButton = new CustomButton("КАЧАНИЕ", labelFont);
+    addItem(ui_swingButton);
 
     acPolygon = new QPolygonF();
     ui_acBody = new QGraphicsPolygonItem(*acPolygon);
@@ -222,86 +262,106 @@ void MainScene::initAirDirectionBlock() {
 }
 
 void MainScene::initMiscButtons() {
-    ui_inputButton = new CustomButton("Ввод значений");
-    ui_inputButton->setFont(labelFont);
-    ui_inputButtonProxy = new QGraphicsProxyWidget;
-    ui_inputButtonProxy = addWidget(ui_inputButton);
+    ui_inputButton = new CustomButton("Ввод значений", labelFont);
+    addItem(ui_inputButton);
 
-    ui_resolutionButton = new CustomButton("Размер окна");
-    ui_resolutionButton->setFont(labelFont);
-    ui_resolutionButtonProxy = new QGraphicsProxyWidget;
-    ui_resolutionButtonProxy = addWidget(ui_resolutionButton);
+    ui_resolutionButton = new CustomButton("Размер окна", labelFont);
+    addItem(ui_resolutionButton);
 
-    ui_themeButton = new CustomButton("ТЕМА");
-    ui_themeButton->setFont(labelFont);
-    ui_themeButtonProxy = new QGraphicsProxyWidget;
-    ui_themeButtonProxy = addWidget(ui_themeButton);
+    ui_themeButton = new CustomButton("ТЕМА", labelFont);
+    addItem(ui_themeButton);
 
     /// Лейбл к кнопке питания, чтобы она стала более интуитивно понятной
     ui_powerButtonLabel = new QGraphicsTextItem("Кондиционер\n   Вкл/Выкл");
     ui_powerButtonLabel->setFont(labelFont);
     addItem(ui_powerButtonLabel);
 
-    ui_powerButton = new CustomButton("I/O");
-    ui_powerButton->setFont(valFont);
-    ui_powerButtonProxy = new QGraphicsProxyWidget;
-    ui_powerButtonProxy = addWidget(ui_powerButton);
+    ui_powerButton = new CustomButton("I/O", valFont);
+    addItem(ui_powerButton);
+}
+
+void MainScene::initLayout() {
+    /// Добавление блока внешней температуры
+    layoutTemperatureBlock();
+    /// Добавление блока внешней влажности
+    layoutHumidityBlock();
+    /// Добавление блока внешнего давления
+    layoutPressureBlock();
+    /// Добавление блока регулировки температуры
+    layoutTargetTempBlock();
+    /// Добавление блока регулировки направления потока воздуха
+    layoutAirDirectionBlock();
+    /// Добавление блока прочих функций
+    layoutMiscButtons();
 }
 
-/// @bug при установки разрешения 1024х768, элементы располагаются неровно, это видно по верхним трём блокам
 void MainScene::placeAllBlocks() {
-    QSize res = prefs->getResolution();
-    /// Размер одной колонки определяется делением ширины окна на количество колонок
-    oneColSize = res.width()/ItemPos::totalCols;
-    /// Размер одной строки определяется делением высоты окна на количество строк
-    oneRowSize = res.height()/ItemPos::totalRows;
-    /// Размещение блока внешней температуры
-    placeTemperatureBlock(res);
-    /// Размещение блока внешней влажности
-    placeHumidityBlock(res);
-    /// Размещение блока внешнего давления
-    placePressureBlock(res);
-    /// Размещение блока регулировки температуры
-    placeTargetTempBlock(res);
-    /// Размещение блока регулировки направления потока воздуха
-    placeAirDirectionBlock(res);
-    /// Размещение блока прочих функций
-    placeMiscButtons(res);
-}
-
-void MainScene::placeTemperatureBlock(const QSize &res) {
-    placeItem(ui_tempLabel, ItemPos::COL_tempLabel, ItemPos::ROW_tempLabel, QSize(0,0), res);
-    placeItem(ui_tempVal, ItemPos::COL_tempVal, ItemPos::ROW_tempVal, QSize(0,0), res);
-    placeItem(ui_tempUnitLabel, ItemPos::COL_tempUnit, ItemPos::ROW_tempUnit, QSize(0,0), res);
-    placeItem(ui_tempChangeUnitProxy, ItemPos::COL_tempChangeUnit, ItemPos::ROW_tempChangeUnit, QSize(oneColSize*16,oneRowSize*5), res);
-}
-
-void MainScene::placeHumidityBlock(const QSize &res) {
-    placeItem(ui_humidityLabel, ItemPos::COL_humidityLabel, ItemPos::ROW_humidityLabel, QSize(0,0), res);
-    placeItem(ui_humidityVal, ItemPos::COL_humidityVal, ItemPos::ROW_humidityVal, QSize(0,0), res);
-    placeItem(ui_humidityUnitLabel, ItemPos::COL_humidityUnit, ItemPos::ROW_humidityUnit, QSize(0,0), res);
-}
-
-void MainScene::placePressureBlock(const QSize &res) {
-    placeItem(ui_pressureLabel, ItemPos::COL_pressureLabel, ItemPos::ROW_pressureLabel, QSize(0,0), res);
-    placeItem(ui_pressureVal, ItemPos::COL_pressureVal, ItemPos::ROW_pressureVal, QSize(0,0), res);
-    placeItem(ui_pressureUnitLabel, ItemPos::COL_pressureUnit, ItemPos::ROW_pressureUnit, QSize(0,0), res);
-    placeItem(ui_pressureChangeUnitProxy, ItemPos::COL_pressureChangeUnit, ItemPos::ROW_pressureChangeUnit, QSize(oneColSize*16,oneRowSize*5), res);
-}
-
-void MainScene::placeTargetTempBlock(const QSize &res) {
-    placeItem(ui_targetTempLabel, ItemPos::COL_targetTempLabel, ItemPos::ROW_targetTempLabel, QSize(0,0), res);
-    placeItem(ui_targetTempVal, ItemPos::COL_targetTempVal, ItemPos::ROW_targetTempVal, QSize(0,0), res);
-    placeItem(ui_targetTempUnitLabel,ItemPos::COL_targetTempUnit, ItemPos::ROW_targetTempUnit, QSize(0,0), res);
-    placeItem(ui_tempMinusButtonProxy, ItemPos::COL_targetTempMinusButton, ItemPos::ROW_targetTempMinusButton, QSize(oneColSize*5,oneRowSize*5), res);
-    placeItem(ui_tempPlusButtonProxy, ItemPos::COL_targetTempPlusButton, ItemPos::ROW_targetTempPlusButton, QSize(oneColSize*5,oneRowSize*5), res);
-}
-
-void MainScene::placeAirDirectionBlock(const QSize &res) {
-    placeItem(ui_acAngleLabel, ItemPos::COL_acAngleLabel, ItemPos::ROW_acAngleLabel, QSize(0,0), res);
-    placeItem(ui_acAngleSliderProxy, ItemPos::COL_acAngleSlider, ItemPos::ROW_acAngleSlider, QSize(oneColSize*24,oneRowSize*5), res);
-    placeItem(ui_acAngleDirection, ItemPos::COL_acAngleLine, ItemPos::ROW_acAngleLine, QSize(0,0), res);
+    Metrics::ScopedTimer timer(Metrics::PlaceAllBlocks, &timings.placeAllBlocks);
+    if (layout.setGrid(prefs->getResolution(), ItemPos::totalCols, ItemPos::totalRows))
+        onGridChanged();
+    /// Все элементы размещаются заново, независимо от того, менялись ли они
+    layout.invalidateAll();
+    layout.apply();
+    updateStaticLayer();
+}
+
+void MainScene::layoutTemperatureBlock() {
+    layout.addItem(ui_tempLabel, ItemPos::COL_tempLabel, ItemPos::ROW_tempLabel);
+    layout.addItem(ui_tempVal, ItemPos::COL_tempVal, ItemPos::ROW_tempVal);
+    layout.addItem(ui_tempUnitLabel, ItemPos::COL_tempUnit, ItemPos::ROW_tempUnit);
+    layout.addItem(ui_changeTempUnit, ItemPos::COL_tempChangeUnit, ItemPos::ROW_tempChangeUnit, 16, 5);
+}
+
+void MainScene::layoutHumidityBlock() {
+    layout.addItem(ui_humidityLabel, ItemPos::COL_humidityLabel, ItemPos::ROW_humidityLabel);
+    layout.addItem(ui_humidityVal, ItemPos::COL_humidityVal, ItemPos::ROW_humidityVal);
+    layout.addItem(ui_humidityUnitLabel, ItemPos::COL_humidityUnit, ItemPos::ROW_humidityUnit);
+}
+
+void MainScene::layoutPressureBlock() {
+    layout.addItem(ui_pressureLabel, ItemPos::COL_pressureLabel, ItemPos::ROW_pressureLabel);
+    layout.addItem(ui_pressureVal, ItemPos::COL_pressureVal, ItemPos::ROW_pressureVal);
+    layout.addItem(ui_pressureUnitLabel, ItemPos::COL_pressureUnit, ItemPos::ROW_pressureUnit);
+    layout.addItem(ui_changePressureUnit, ItemPos::COL_pressureChangeUnit, ItemPos::ROW_pressureChangeUnit, 16, 5);
+}
+
+void MainScene::layoutTargetTempBlock() {
+    layout.addItem(ui_targetTempLabel, ItemPos::COL_targetTempLabel, ItemPos::ROW_targetTempLabel);
+    layout.addItem(ui_targetTempVal, ItemPos::COL_targetTempVal, ItemPos::ROW_targetTempVal);
+    layout.addItem(ui_targetTempUnitLabel,ItemPos::COL_targetTempUnit, ItemPos::ROW_targetTempUnit);
+    layout.addItem(ui_tempMinusButton, ItemPos::COL_targetTempMinusButton, ItemPos::ROW_targetTempMinusButton, 5, 5);
+    layout.addItem(ui_tempPlusButton, ItemPos::COL_targetTempPlusButton, ItemPos::ROW_targetTempPlusButton, 5, 5);
+}
+
+void MainScene::layoutAirDirectionBlock() {
+    layout.addItem(ui_acAngleLabel, ItemPos::COL_acAngleLabel, ItemPos::ROW_acAngleLabel);
+    layout.addItem(ui_acAngleSlider, ItemPos::COL_acAngleSlider, ItemPos::ROW_acAngleSlider, 24, 5);
+    layout.addItem(ui_acAngleDirection, ItemPos::COL_acAngleLine, ItemPos::ROW_acAngleLine);
+    layout.addItem(ui_acBody, ItemPos::COL_acBody, ItemPos::ROW_acBody);
+    layout.addItem(ui_swingButton, ItemPos::COL_swingButton, ItemPos::ROW_swingButton, 19, 5);
+}
+
+void MainScene::layoutMiscButtons() {
+    layout.addItem(ui_inputButton, ItemPos::COL_inputButton, ItemPos::ROW_inputButton, 19, 5);
+    layout.addItem(ui_resolutionButton, ItemPos::COL_resolutionButton, ItemPos::ROW_resolutionButton, 19, 5);
+    layout.addItem(ui_themeButton, ItemPos::COL_themeButton, ItemPos::ROW_themeButton, 19, 5);
+    layout.addItem(ui_powerButtonLabel, ItemPos::COL_powerButtonLabel, ItemPos::ROW_powerButtonLabel);
+    layout.addItem(ui_powerButton, ItemPos::COL_powerButton, ItemPos::ROW_powerButton, 10, 10);
+}
+
+void MainScene::onGridChanged() {
+    rebuildAcBody();
+    /// Новое разрешение - новое изображение слоя, позиции заголовков изменились
+    if (ui_staticLayer)
+        ui_staticLayer->invalidate();
+    for (auto sparkline : qAsConst(sparklines))
+        sparkline->setSize(QSizeF(layout.colSize() * ItemPos::COLS_sparkline, layout.rowSize() * ItemPos::ROWS_sparkline));
+}
 
+void MainScene::rebuildAcBody() {
+    qreal oneColSize = layout.colSize();
+    qreal oneRowSize = layout.rowSize();
+    /// Полигон зависит только от размера сетки, поэтому перестраивается только при смене разрешения
     acPolygon->clear();
     acPolygon->append(QPointF(0, 0));
     acPolygon->append(QPointF(oneColSize*12, 0));
@@ -309,180 +369,182 @@ void MainScene::placeAirDirectionBlock(const QSize &res) {
     acPolygon->append(QPointF(oneColSize*6, oneRowSize*12));
     acPolygon->append(QPointF(0, oneRowSize*12));
     ui_acBody->setPolygon(*acPolygon);
-
-    placeItem(ui_acBody, ItemPos::COL_acBody, ItemPos::ROW_acBody, QSize(0,0), res);
 }
 
-void MainScene::placeMiscButtons(const QSize &res) {
-    placeItem(ui_inputButtonProxy, ItemPos::COL_inputButton, ItemPos::ROW_inputButton, QSize(oneColSize*19,oneRowSize*5), res);
-    placeItem(ui_resolutionButtonProxy, ItemPos::COL_resolutionButton, ItemPos::ROW_resolutionButton, QSize(oneColSize*19,oneRowSize*5), res);
-    placeItem(ui_themeButtonProxy, ItemPos::COL_themeButton, ItemPos::ROW_themeButton, QSize(oneColSize*19,oneRowSize*5), res);
-    placeItem(ui_powerButtonLabel, ItemPos::COL_powerButtonLabel, ItemPos::ROW_powerButtonLabel, QSize(0,0), res);
-    placeItem(ui_powerButtonProxy, ItemPos::COL_powerButton, ItemPos::ROW_powerButton, QSize(oneColSize*10,oneRowSize*10), res);
+void MainScene::updateStaticLayer() {
+    if (!ui_staticLayer || !ui_staticLayer->isDirty())
+        return;
+    QSize size = prefs->getResolution();
+    /// При перетаскивании края окна каждый шаг - новый размер: пока он меняется, видны исходные элементы.
+    /// Первое изображение и изображение для прежнего размера выбираются сразу
+    if (ui_staticLayer->size().isValid() && ui_staticLayer->size() != size) {
+        ui_staticLayer->suspend();
+        staticSettle->start();
+        return;
+    }
+    staticSettle->stop();
+    ui_staticLayer->rebuild(size, backgroundBrush());
 }
 
-void MainScene::placeItem(QGraphicsItem *item, qint16 col, qint16 row, QSize size, QSize res)
+void MainScene::setHudVisible(bool visible)
 {
-    /// Если размещается кнопка, то у неё устанавливается размер
-    if (auto btn = dynamic_cast<QGraphicsProxyWidget*>(item))
-    {
-        btn->setMinimumSize(size);
-        btn->setMaximumSize(size);
-        btn->resize(size);
+    if (!ui_hud) {
+        if (!visible)
+            return;
+        ui_hud = new HudItem(&timings);
+        addItem(ui_hud);
     }
+    ui_hud->setVisible(visible);
+}
 
-    /// Область, занимаемая кнопкой
-    QRectF rect = item->boundingRect();
-    /// Инициализация "координат"
-    qint16 x{0}, y{0};
-    x = oneColSize * col - (rect.width() / 2);
-    y = oneRowSize * row - (rect.height() / 2);
-    item->setPos(x, y);
+void MainScene::setLowPower(bool lowPower)
+{
+    QGraphicsItem::CacheMode mode = lowPower ? QGraphicsItem::DeviceCoordinateCache : QGraphicsItem::NoCache;
+    /// Кнопки меняются только при нажатии и смене темы, а текст на них - самая дорогая часть отрисовки
+    for (auto button : qAsConst(buttons))
+        button->setCacheMode(mode);
+    /// Подписи и корпус кондиционера рисуются из ui_staticLayer, отдельный кэш им не нужен
 }
 
 void MainScene::togglePower()
 {
-    /// Переключение питания
+    METRICS_SCOPE(TogglePower);
+    /// Переключение питания, тема применится по сигналу
     prefs->setPower();
-    /// Применение темы
-    applyTheme();
 }
 
 void MainScene::updatePos() {
-    placeAllBlocks();
+    /// При смене разрешения все элементы помечаются как изменённые
+    if (layout.setGrid(prefs->getResolution(), ItemPos::totalCols, ItemPos::totalRows))
+        onGridChanged();
+    /// Размещаются только изменённые элементы
+    layout.apply();
+    updateStaticLayer();
 }
 
 
 void MainScene::changeTempUnit()
 {
-    qreal targetT = prefs->getTargetTemp();
-    qreal temp = prefs->getTempVal();
-
-    /// Из Кельвинов в Цельсии
-    if (prefs->getTempUnit() == "°K") {
-        temp -= 273.15;
-        targetT -= 273.15;
-        prefs->setTempUnit("°C");        
-    } /// Из Цельсиев в Фаренгейты
-    else if (prefs->getTempUnit() == "°C") {
-        temp = (temp * 9 / 5) + 32;
-        targetT = (targetT * 9 / 5) + 32;
-        prefs->setTempUnit("°F");
-    } /// Из Фаренгейтов в Кельвины
-    else {
-        temp = (temp - 32) * 5 / 9 + 273.15;
-        targetT = (targetT  - 32) * 5 / 9 + 273.15;
-        prefs->setTempUnit("°K");
-    }
-    prefs->setTempVal(temp);
-    prefs->setTargetTemp(targetT);
-    prefs->setLimits();
-    updateValues();
-    updatePos();
+    METRICS_SCOPE(ChangeTempUnit);
+    /// Единицы переключаются по кругу: °C -> °F -> °K -> °C, элементы обновятся по сигналам
+    prefs->changeTempUnit(Units::next(prefs->getTempUnit()));
 }
 
 void MainScene::changePressureUnit()
 {
-    qreal pressure = prefs->getPressureVal();
-    /// Из Миллиметров в Паскали
-    if (prefs->getPressureUnit() == "мм") {
-        pressure *= 133.322;
-        prefs->setPressureUnit("Pa");
-    } /// Из Паскалей в Миллиметры
-    else {
-        pressure /= 133.322;
-        prefs->setPressureUnit("мм");
-    }
-
-    prefs->setPressureVal(pressure);
-    prefs->setLimits();
-    updateValues();
-    updatePos();
+    METRICS_SCOPE(ChangePressureUnit);
+    /// Переключение между Паскалями и Миллиметрами
+    prefs->changePressureUnit(Units::next(prefs->getPressureUnit()));
 }
 
 void MainScene::changeResolution()
 {
+    METRICS_SCOPE(ChangeResolution);
+    /// Элементы переразмещаются по сигналу изменения разрешения
     prefs->setResolution();
-    QSize res = prefs->getResolution();
-    updatePos();
-    /// Активация сигнала, по которой сработает обработчик в main.cpp
-    emit resolutionChanged(res);
 }
 
 void MainScene::changeTheme()
 {
+    METRICS_SCOPE(ChangeTheme);
     prefs->setTheme();
-    applyTheme();
 }
 
 void MainScene::applyTheme()
 {
-    bool dark = prefs->getTheme();
+    Metrics::ScopedTimer timer(Metrics::ApplyTheme, &timings.applyTheme);
     bool power = prefs->getPower();
+    /// Палитра уже собрана, остаётся раздать её элементам
+    const ThemePalette &pal = themes.palette(prefs->getTheme(), power);
     /// Установка цвета фона
-    setBackgroundBrush(QBrush(dark ? ItemColor::CLR_bgDark : ItemColor::CLR_bgLight));
+    setBackgroundBrush(pal.background);
 
     /// Установка цвета текста
-    for (QGraphicsItem* item : items()) {
-        if (auto text = dynamic_cast<QGraphicsTextItem*>(item))
-            text->setDefaultTextColor(power ?
-                (dark ? ItemColor::CLR_textDark_ON :ItemColor::CLR_textLight_ON) :
-                (dark ? ItemColor::CLR_textDark_OFF :ItemColor::CLR_textLight_OFF)
-            );
-    }
+    for (auto text : qAsConst(texts))
+        text->setDefaultTextColor(pal.text);
+    for (auto readout : qAsConst(readouts))
+        readout->setColor(pal.text);
+    for (auto sparkline : qAsConst(sparklines))
+        sparkline->setPen(pal.sparkline);
+    /// Цвет текста на кнопке питания должет быть "включенным"
+    ui_powerButtonLabel->setDefaultTextColor(pal.textActive);
 
     /// Установка цвета кнопок
-    for (auto x : buttons) {
+    for (auto x : qAsConst(buttons)) {
         /// Кнопка питания всегда доступна
-        if (x->bName != "I/O") {
+        if (x != ui_powerButton) {
             x->setEnabled(power);
-            x->applyButtonTheme(dark, power);
+            x->applyButtonTheme(&pal.button);
         } else {
-            x->applyButtonTheme(dark, true);
+            x->applyButtonTheme(&pal.powerButton);
         }
     }
-    /// Цвет текста на кнопке питания должет быть "включенным"
-    ui_powerButtonLabel->setDefaultTextColor((dark ? ItemColor::CLR_textDark_ON :ItemColor::CLR_textLight_ON));
 
     ui_acAngleSlider->setEnabled(power);
     /// Установка цвета слайдера
-    ui_acAngleSlider->setStyleSheet(power ?
-        (dark ? ItemColor::CLR_sliderDark_ON : ItemColor::CLR_sliderLight_ON) :
-        (dark ? ItemColor::CLR_sliderDark_OFF : ItemColor::CLR_sliderLight_OFF)
-    );
-    /// Установка цвета полигона
-    ui_acBody->setBrush(power ?
-        (dark ? ItemColor::CLR_acBodyDark_ON : ItemColor::CLR_acBodyLight_ON) :
-        (dark ? ItemColor::CLR_acBodyDark_OFF : ItemColor::CLR_acBodyLight_OFF)
-    );
-    /// Установка цвета рамки полигона
-    QPen penBody(power ?
-        (dark ? ItemColor::CLR_borderDark_ON : ItemColor::CLR_borderLight_ON) :
-        (dark ? ItemColor::CLR_borderDark_OFF : ItemColor::CLR_borderLight_OFF)
-    );
-    penBody.setWidth(2);
-    ui_acBody->setPen(penBody);
+    ui_acAngleSlider->applySliderTheme(&pal.slider);
+    /// Установка цвета полигона и его рамки
+    ui_acBody->setBrush(pal.acBody);
+    ui_acBody->setPen(pal.acBodyPen);
     /// Установка цвета линии направления воздуха
-    QPen penLine(power ?
-        (dark ? ItemColor::CLR_acLineDark_ON : ItemColor::CLR_acLineLight_ON) :
-        (dark ? ItemColor::CLR_acLineDark_OFF : ItemColor::CLR_acLineLight_OFF)
-    );
-    penLine.setWidth(8);
-    ui_acAngleDirection->setPen(penLine);
+    ui_acAngleDirection->setPen(pal.acLine);
+    /// Слой перерисуется при следующем размещении, один раз за пакет изменений
+    if (ui_staticLayer)
+        ui_staticLayer->invalidate();
 }
 
 void MainScene::updateValues() {
-    ui_tempVal->setPlainText(QString::number(prefs->getTempVal(), 'f', 2));
-    ui_humidityVal->setPlainText(QString::number(prefs->getHumidityVal(), 'f', 2));
-    ui_pressureVal->setPlainText(QString::number(prefs->getPressureVal(), 'f', 2));
-    ui_tempUnitLabel->setPlainText(prefs->getTempUnit());
-    ui_pressureUnitLabel->setPlainText(prefs->getPressureUnit());
-    ui_targetTempVal->setPlainText(QString::number(prefs->getTargetTemp(), 'f', 2));
-    ui_targetTempUnitLabel->setPlainText(prefs->getTempUnit());
+    setItemValue(ui_tempVal, prefs->getTempVal());
+    setItemValue(ui_humidityVal, prefs->getHumidityVal());
+    setItemValue(ui_pressureVal, prefs->getPressureVal());
+    setItemText(ui_tempUnitLabel, Units::symbol(prefs->getTempUnit()));
+    setItemText(ui_pressureUnitLabel, Units::symbol(prefs->getPressureUnit()));
+    setItemValue(ui_targetTempVal, prefs->getTargetTemp());
+    setItemText(ui_targetTempUnitLabel, Units::symbol(prefs->getTempUnit()));
+    refreshHistory();
+}
+
+void MainScene::refreshHistory() {
+    /// Графики дорисовывают только новые интервалы истории
+    for (auto sparkline : qAsConst(sparklines))
+        sparkline->refresh();
+}
+
+void MainScene::attachHistory(const MeasurementHistory *temp, const MeasurementHistory *humidity, const MeasurementHistory *pressure) {
+    if (!sparklines.isEmpty())
+        return;
+    /// Графики строятся в базовых единицах, в границах допустимых значений
+    ui_tempSparkline = new SparklineItem(temp, Preferences::TEMPMIN_C, Preferences::TEMPMAX_C);
+    ui_humiditySparkline = new SparklineItem(humidity, Preferences::HUMIDITYMIN, Preferences::HUMIDITYMAX);
+    ui_pressureSparkline = new SparklineItem(pressure, Preferences::PRESSUREMIN_MM, Preferences::PRESSUREMAX_MM);
+    sparklines << ui_tempSparkline << ui_humiditySparkline << ui_pressureSparkline;
+
+    const ThemePalette &pal = themes.palette(prefs->getTheme(), prefs->getPower());
+    for (auto sparkline : qAsConst(sparklines)) {
+        sparkline->setSize(QSizeF(layout.colSize() * ItemPos::COLS_sparkline, layout.rowSize() * ItemPos::ROWS_sparkline));
+        sparkline->setPen(pal.sparkline);
+        addItem(sparkline);
+    }
+    layout.addItem(ui_tempSparkline, ItemPos::COL_tempSparkline, ItemPos::ROW_tempSparkline);
+    layout.addItem(ui_humiditySparkline, ItemPos::COL_humiditySparkline, ItemPos::ROW_humiditySparkline);
+    layout.addItem(ui_pressureSparkline, ItemPos::COL_pressureSparkline, ItemPos::ROW_pressureSparkline);
+    updatePos();
+}
+
+void MainScene::setItemValue(ReadoutItem *item, qreal value) {
+    /// Одинаковое значение не перерисовывает и не сдвигает элемент
+    if (item->setValue(value))
+        layout.invalidate(item);
+}
+
+void MainScene::setItemText(ReadoutItem *item, const QString &text) {
+    if (item->setText(text))
+        layout.invalidate(item);
 }
 
 void MainScene::onMinusTargetTemp()
 {
+    METRICS_SCOPE(MinusTargetTemp);
     qreal temp = prefs->getTargetTemp();
     qreal stepVal = roundTargetTemp();
     qreal tempMin = prefs->getTempMin();
@@ -498,13 +560,11 @@ void MainScene::onMinusTargetTemp()
         prefs->setTargetTemp(tempMin);
     else
         prefs->setTargetTemp(temp - stepVal);
-
-    updateValues();
-    updatePos();
 }
 
 void MainScene::onPlusTargetTemp()
 {
+    METRICS_SCOPE(PlusTargetTemp);
     qreal temp = prefs->getTargetTemp();
     qreal stepVal = roundTargetTemp();
     qreal tempMax = prefs->getTempMax();
@@ -520,9 +580,6 @@ void MainScene::onPlusTargetTemp()
         prefs->setTargetTemp(tempMax);
     else
         prefs->setTargetTemp(temp + stepVal);
-
-    updateValues();
-    updatePos();
 }
 
 qreal MainScene::roundTargetTemp()
@@ -546,21 +603,14 @@ qreal MainScene::roundTargetTemp()
 
 void MainScene::onSliderChanged(int value)
 {
-    /// Создаётся объект QTransform для вращения линии
-    QTransform transform;
-    /// Вращение линии при изменении положения слайдера
-    transform.rotate(value * -1);
+    METRICS_SCOPE(SliderChanged);
+    /// Линия поворачивается по сигналу изменения угла
     prefs->setAcAngle(value);
-    /// Применение QTransform к линии
-    ui_acAngleDirection->setTransform(transform);
 }
 
-void MainScene::loadPrefs()
+void MainScene::toggleSwing()
 {
-    prefs->load("preferences.xml");
-}
-
-void MainScene::savePrefs()
-{    
-    prefs->save("preferences.xml");    
+    METRICS_SCOPE(ToggleSwing);
+    /// Анимация включится по сигналу изменения настроек
+    prefs->setSwing();
 }
@@ -10,39 +10,19 @@
 
 #include <QGraphicsScene>
 #include <QGraphicsTextItem>
-#include <QPushButton>
-#include <QSlider>
-#include <QGraphicsProxyWidget>
 #include <QGraphicsRectItem>
 #include "preferences.h"
-/**
- * @class CustomButton
- * @brief Класс для кнопок
- *
- * Класс, наследованный от QPushButton, добавляющий функции для смены темы.
- */
-class CustomButton : public QPushButton
-{
-    Q_OBJECT
-public:
-    explicit CustomButton(const QString &text);
-    /// Наименование кнопки, содержит в себе текст, отображаемный на кнопке
-    QString bName;
-    /// Текущий стиль (используется для setStyleSheet)
-    QString style;
-    /**
-     * @brief Применение цвета текущей темы
-     * @param dark тёмная тема
-     * @param power питание
-     */
-    void applyButtonTheme(bool dark, bool power);
-
-private slots:
-    /// @brief Обработчик при нажатии на кнопку
-    void onPressed();
-    /// @brief Обработчик при отпускании кнопки
-    void onReleased();
-};
+#include "scenelayout.h"
+#include "themeengine.h"
+#include "readoutitem.h"
+#include "sparklineitem.h"
+#include "huditem.h"
+#include "scenecontrols.h"
+#include "staticlayer.h"
+#include "vaneanimator.h"
+
+class MainSceneBench;
+class QTimer;
 
 /**
  * @class MainScene
@@ -54,7 +34,11 @@ class MainScene : public QGraphicsScene
 {
     Q_OBJECT
 public:
-    explicit MainScene(QObject *parent = nullptr);
+    /**
+     * @param prefs Пользовательские настройки ядра. Если не заданы, сцена создаёт и загружает свои.
+     * @param parent Родительский объект
+     */
+    explicit MainScene(Preferences *prefs = nullptr, QObject *parent = nullptr);
     /// Объект с пользовательскими настройками
     Preferences *prefs;
     /**
@@ -63,19 +47,50 @@ public:
      * Инициализирует и размещает все элементы интерфейса
      */
     void setUpUi();    
-    /// @brief Обновление отображаемых данных
+    /// @brief Обновление всех отображаемых данных. При изменении настроек элементы обновляются по сигналам сами.
     void updateValues();
-    /// @brief Обновление позиции элементов интерфейса
+    /// @brief Дорисовка графиков истории измерений
+    void refreshHistory();
+    /// @brief Обновление позиции элементов интерфейса. Переразмещаются только изменившиеся элементы.
     void updatePos();
-    /// @brief Вызов загрузки xml файла
-    void loadPrefs();
-    /// @brief Вызов сохранения xml файла
-    void savePrefs();
-    /// Класс CustomButton - друг. Нужно для использования значений цветов.
-    friend class CustomButton;
+    /**
+     * @brief Подключение истории измерений
+     *
+     * В блоках внешних данных появляются графики истории, которые дорисовываются при каждом updateValues()
+     * @param temp История температуры
+     * @param humidity История влажности
+     * @param pressure История давления
+     */
+    void attachHistory(const MeasurementHistory *temp, const MeasurementHistory *humidity, const MeasurementHistory *pressure);
+    /**
+     * @brief Показ или скрытие панели производительности
+     *
+     * Панель создаётся при первом показе
+     */
+    void setHudVisible(bool visible);
+    /// @brief Панель производительности показана
+    bool isHudVisible() const { return ui_hud && ui_hud->isVisible(); }
+    /// @brief Панель производительности, nullptr если ещё не показывалась
+    HudItem *hud() const { return ui_hud; }
+    /**
+     * @brief Режим для панелей без GPU
+     *
+     * Кнопки кэшируются в растровом виде и рисуются копированием. Заголовки блоков, подпись кнопки
+     * питания и корпус кондиционера не кэшируются отдельно: их рисует слой неизменяемых элементов.
+     * Пока слой приостановлен на время изменения размера окна, они рисуются напрямую - растровый
+     * кэш всё равно перерисовывался бы на каждом шаге, так как размещение и шрифты меняются.
+     * @param lowPower true - включить кэширование
+     */
+    void setLowPower(bool lowPower);
+    /// Класс ThemeEngine - друг. Нужно для сборки палитр из значений цветов.
+    friend class ThemeEngine;
+    /// Бенчмарк вызывает приватные методы размещения и смены темы напрямую
+    friend class MainSceneBench;
 private:
     /// Значение шага изменения желаемой температуры
     static constexpr qreal TEMPSTEP = 0.5;
+    /// Пауза в изменении размера окна, после которой слой неизменяемых элементов рисуется для нового размера, мс
+    static constexpr int STATICSETTLE = 300;
     /// Шрифт для лейблов и кнопок
     QFont labelFont;
     /// Шрифт для значений
@@ -83,16 +98,30 @@ private:
 
     // Лист кнопок, используется при применении темы к кнопкам
     QList<CustomButton*> buttons;
+    /// Лист текстовых элементов, используется при применении темы к тексту
+    QList<QGraphicsTextItem*> texts;
+    /// Лист показаний и единиц измерения, используется при применении темы к тексту
+    QList<ReadoutItem*> readouts;
+    /// Лист графиков истории
+    QList<SparklineItem*> sparklines;
+    /// Готовые палитры всех состояний темы
+    ThemeEngine themes;
+    /// Длительность последних применения темы и размещения элементов
+    SceneTimings timings;
+    /// Панель производительности (создаётся при первом показе)
+    HudItem *ui_hud = nullptr;
+    /// Растровый слой заголовков, подписи кнопки питания, корпуса кондиционера и фона
+    StaticLayer *ui_staticLayer = nullptr;
+    /// Таймер выбора изображения слоя после того, как размер сцены перестал меняться
+    QTimer *staticSettle;
 
     /**
      * @defgroup uiPlace Размещение элементов интерфейса
      * @brief Окно делится на условные колонки и строки, элементы размещаются по координатам (колонка,строка)
      */
     /// @{
-    /// Ширина одной колонки
-    qint16 oneColSize;
-    /// Ширина одной строки
-    qint16 oneRowSize;
+    /// Раскладка элементов. Переразмещает только изменившиеся элементы.
+    SceneLayout layout;
     /// @}
 
     /**
@@ -103,13 +132,13 @@ private:
     /// Лейбл "Температура"
     QGraphicsTextItem *ui_tempLabel;
     /// Значение температуры
-    QGraphicsTextItem *ui_tempVal;
+    ReadoutItem *ui_tempVal;
     /// Единица измерения температуры
-    QGraphicsTextItem *ui_tempUnitLabel;
+    ReadoutItem *ui_tempUnitLabel;
     /// Кнопка смены единиц измерения температуры (действует и для желаемой температуры)
     CustomButton *ui_changeTempUnit;
-    /// Прокси-виджет для кнопки смены ЕИ температуры, чтобы её можно было разместить на QGraphicsScene
-    QGraphicsProxyWidget *ui_tempChangeUnitProxy;
+    /// График истории температуры (только при подключенной истории)
+    SparklineItem *ui_tempSparkline = nullptr;
     /// @}
 
     /**
@@ -120,9 +149,11 @@ private:
     /// Лейбл "Влажность"
     QGraphicsTextItem *ui_humidityLabel;
     /// Значение влажности
-    QGraphicsTextItem *ui_humidityVal;
+    ReadoutItem *ui_humidityVal;
     /// Единица измерения влажности
-    QGraphicsTextItem *ui_humidityUnitLabel;
+    ReadoutItem *ui_humidityUnitLabel;
+    /// График истории влажности (только при подключенной истории)
+    SparklineItem *ui_humiditySparkline = nullptr;
     /// @}
 
     /**
@@ -133,13 +164,13 @@ private:
     /// Лейбл "Давление"
     QGraphicsTextItem *ui_pressureLabel;
     /// Значение давления
-    QGraphicsTextItem *ui_pressureVal;
+    ReadoutItem *ui_pressureVal;
     /// Единица измерения давления
-    QGraphicsTextItem *ui_pressureUnitLabel;
+    ReadoutItem *ui_pressureUnitLabel;
     /// Кнопка смены единиц измерения давления
     CustomButton *ui_changePressureUnit;
-    /// Прокси-виджет для кнопки смены ЕИ давления, чтобы её можно было разместить на QGraphicsScene
-    QGraphicsProxyWidget *ui_pressureChangeUnitProxy;
+    /// График истории давления (только при подключенной истории)
+    SparklineItem *ui_pressureSparkline = nullptr;
     /// @}
 
     /**
@@ -150,17 +181,13 @@ private:
     /// Лейбл "Желаемая температура"
     QGraphicsTextItem *ui_targetTempLabel;
     /// Значение желаемой температуры
-    QGraphicsTextItem *ui_targetTempVal;
+    ReadoutItem *ui_targetTempVal;
     /// Единица измерения желаемой температуры (синхронизирована с ЕИ внешней температуры)
-    QGraphicsTextItem *ui_targetTempUnitLabel;
+    ReadoutItem *ui_targetTempUnitLabel;
     /// Кнопка "-" для уменьшения желаемой температуры
     CustomButton *ui_tempMinusButton;
-    /// Прокси-виджет для кнопки "-", чтобы её можно было разместить на QGraphicsScene
-    QGraphicsProxyWidget *ui_tempMinusButtonProxy;
     /// Кнопка "+" для увеличения желаемой температуры
     CustomButton *ui_tempPlusButton;
-    /// Прокси-виджет для кнопки "+", чтобы её можно было разместить на QGraphicsScene
-    QGraphicsProxyWidget *ui_tempPlusButtonProxy;
     /**
      * @brief Округление значения желаемой температуры
      * @return Разница с ближайшим значением, которое кратно шагу изменения температуры
@@ -174,17 +201,19 @@ private:
 
     /**
      * @defgroup acBlock Блок управления направлением потока воздуха
-     * @brief Состоит из слайдера и визуализации направления воздуха
+     * @brief Состоит из слайдера, визуализации направления воздуха и кнопки качания заслонки
      */
     /// @{
     /// Лейбл "Направление воздуха"
     QGraphicsTextItem *ui_acAngleLabel;
     /// Слайдер для регулировки направления воздуха
-    QSlider *ui_acAngleSlider;
-    /// Прокси-виджет для расположения слайдера на QGraphicsScene
-    QGraphicsProxyWidget *ui_acAngleSliderProxy;
+    CustomSlider *ui_acAngleSlider;
     /// Линия, показывающая направление воздуха
     QGraphicsLineItem *ui_acAngleDirection;
+    /// Покадровый поворот линии и качание
+    VaneAnimator *vaneAnimator;
+    /// Кнопка "Качание"
+    CustomButton *ui_swingButton;
     /// Объект на основе полигона, показывающий корпус кондиционера, из которого выходит линия направления воздуха
     QGraphicsPolygonItem *ui_acBody;
     /// Полигон, на основе которого строится визуализация корпуса кондиционера
@@ -198,25 +227,17 @@ private:
     /// @{
     /// Кнопка "Ввод внешних данных"
     CustomButton *ui_inputButton;
-    /// Прокси-виджет для кнопки ввода внешних данных, чтобы её можно было разместить на QGraphicsScene
-    QGraphicsProxyWidget *ui_inputButtonProxy;
 
     /// Кнопка "Смена разрешения"
     CustomButton *ui_resolutionButton;
-    /// Прокси-виджет для кнопки смены разрешения, чтобы её можно было разместить на QGraphicsScene
-    QGraphicsProxyWidget *ui_resolutionButtonProxy;
 
     /// Кнопка "Смена темы"
     CustomButton *ui_themeButton;
-    /// Прокси-виджет для кнопки смены темы, чтобы её можно было разместить на QGraphicsScene
-    QGraphicsProxyWidget *ui_themeButtonProxy;
 
     /// Лейбл кнопки питания
     QGraphicsTextItem *ui_powerButtonLabel;
     /// Кнопка "Вкл/выкл"
     CustomButton *ui_powerButton;
-    /// Прокси-виджет для кнопки питания кондиционера, чтобы её можно было разместить на QGraphicsScene
-    QGraphicsProxyWidget *ui_powerButtonProxy;
     /// @}
 
     /**
@@ -245,34 +266,55 @@ private:
      * @brief Методы размещения элементов интерфейса
      */
     /// @{
+    /// @brief Добавление всех элементов в раскладку
+    void initLayout();
+    /// @brief Полное размещение всех элементов
+    void placeAllBlocks();
+    /// @brief Добавление в раскладку блока внешней температуры
+    void layoutTemperatureBlock();
+    /// @brief Добавление в раскладку блока внешней влажности
+    void layoutHumidityBlock();
+    /// @brief Добавление в раскладку блока внешнего давления
+    void layoutPressureBlock();
+    /// @brief Добавление в раскладку блока регулировки температуры
+    void layoutTargetTempBlock();
+    /// @brief Добавление в раскладку блока регулировки направления воздуха
+    void layoutAirDirectionBlock();
+    /// @brief Добавление в раскладку блока прочих функций
+    void layoutMiscButtons();
+    /// @brief Перестроение полигона корпуса кондиционера под текущий размер сетки
+    void rebuildAcBody();
     /**
-     * @brief Размещение одного элемента
-     * @param item Размещаемый элемент
-     * @param col Условная колонка
-     * @param row Условная строка
-     * @param size Размер элемента (Для текста указывается QSize(0,0))
-     * @param res Разрешение окна
+     * @brief Выбор изображения слоя неизменяемых элементов, если слой устарел
      *
-     * Размещение конкретного элемента в конкретном месте экрана, определяемом по координатам (колонка,строка).
+     * При новом размере сцены слой приостанавливается до паузы STATICSETTLE в изменении размера
      */
-    void placeItem(QGraphicsItem *item, qint16 col, qint16 row, QSize size, QSize res);
-    /// @brief Размещение элементов
-    void placeAllBlocks();
-    /// @brief Размещение блока внешней температуры
-    void placeTemperatureBlock(const QSize &res);
-    /// @brief Размещение блока внешней влажности
-    void placeHumidityBlock(const QSize &res);
-    /// @brief Размещение блока внешнего давления
-    void placePressureBlock(const QSize &res);
-    /// @brief Размещение блока регулировки температуры
-    void placeTargetTempBlock(const QSize &res);
-    /// @brief Размещение блока регулировки направления воздуха
-    void placeAirDirectionBlock(const QSize &res);
-    /// @brief Размещение кнопок для регулировки температуры
-    void placeMiscButtons(const QSize &res);
+    void updateStaticLayer();
+    /// @brief Подписка элементов на сигналы изменения настроек
+    void bindPrefs();
+    /// @brief Обновление элементов, размер которых задаётся в ячейках сетки, но которые не являются элементами управления (их размер задаёт раскладка)
+    void onGridChanged();
+    /**
+     * @brief Смена значения показания
+     *
+     * Элемент помечается для переразмещения, только если отображаемый текст изменился.
+     * @param item Показание
+     * @param value Новое значение
+     */
+    void setItemValue(ReadoutItem *item, qreal value);
+    /**
+     * @brief Смена текста показания (единицы измерения)
+     * @param item Показание
+     * @param text Новый текст
+     */
+    void setItemText(ReadoutItem *item, const QString &text);
     /// @}
 
-    /// @brief Применение темы
+    /**
+     * @brief Применение темы
+     *
+     * Выбирается готовая палитра текущего состояния (тема, питание) и раздаётся элементам.
+     */
     void applyTheme();
 
     /// @defgroup itemPos Константы с координатами и размеров элементов интерфейса
@@ -282,6 +324,8 @@ private:
         static const int totalCols = 80;
         /// Общее количество строк
         static const int totalRows = 60;
+        /// Размер графика истории в колонках и строках
+        static const int COLS_sparkline = 16;      static const int ROWS_sparkline = 3;
 
         /// Расположение элементов блока внешней температуры
         /// @ingroup tempBlock
@@ -290,6 +334,7 @@ private:
         static const int COL_tempVal = 14;         static const int ROW_tempVal = 9;
         static const int COL_tempUnit = 14;        static const int ROW_tempUnit = 13;
         static const int COL_tempChangeUnit = 14;  static const int ROW_tempChangeUnit = 18;
+        static const int COL_tempSparkline = 14;   static const int ROW_tempSparkline = 23;
         /// @}
 
         /// Расположение элементов блока внешней влажности
@@ -298,6 +343,7 @@ private:
         static const int COL_humidityLabel = 40; static const int ROW_humidityLabel = 4;
         static const int COL_humidityVal = 40;   static const int ROW_humidityVal = 9;
         static const int COL_humidityUnit = 40;  static const int ROW_humidityUnit = 13;
+        static const int COL_humiditySparkline = 40; static const int ROW_humiditySparkline = 23;
         /// @}
 
         /// Расположение элементов блока внешнего давления
@@ -307,6 +353,7 @@ private:
         static const int COL_pressureVal = 66;         static const int ROW_pressureVal = 9;
         static const int COL_pressureUnit = 66;        static const int ROW_pressureUnit = 13;
         static const int COL_pressureChangeUnit = 66;  static const int ROW_pressureChangeUnit = 18;
+        static const int COL_pressureSparkline = 66;   static const int ROW_pressureSparkline = 23;
         /// @}
 
         /// Расположение элементов блока регулировки температуры
@@ -326,6 +373,7 @@ private:
         static const int COL_acAngleSlider = 62; static const int ROW_acAngleSlider = 31;
         static const int COL_acAngleLine = 62;   static const int ROW_acAngleLine = 46;
         static const int COL_acBody = 62;        static const int ROW_acBody = 46;
+        static const int COL_swingButton = 62;   static const int ROW_swingButton = 56;
         /// @}
 
         /// Расположение элементов блока прочих функций
@@ -367,57 +415,55 @@ private:
         static constexpr QColor CLR_borderDark_OFF = CLR_borderDark_ON;
 
         /// Цвет кнопки - ВКЛ - светлая тема
-        inline static const QString CLR_buttonLight_ON = R"(
-            background-color: rgb(150,150,150);
-            color: rgb(10,10,10);
-            border: 2px solid;
-            border-color: rgb(60,60,60);
-        )";
+        /// @{
+        static constexpr QColor CLR_buttonBgLight_ON = QColor(150,150,150);
+        static constexpr QColor CLR_buttonTextLight_ON = QColor(10,10,10);
+        static constexpr QColor CLR_buttonBorderLight_ON = QColor(60,60,60);
+        /// @}
         /// Цвет кнопки - ВКЛ - темная тема
-        inline static const QString CLR_buttonDark_ON = R"(
-            background-color: rgb(60,60,60);
-            color: rgb(245,245,245);
-            border: 2px solid;
-            border-color: rgb(180,180,180);
-        )";
+        /// @{
+        static constexpr QColor CLR_buttonBgDark_ON = QColor(60,60,60);
+        static constexpr QColor CLR_buttonTextDark_ON = QColor(245,245,245);
+        static constexpr QColor CLR_buttonBorderDark_ON = QColor(180,180,180);
+        /// @}
         /// Цвет кнопки - ВЫКЛ - светлая тема
-        inline static const QString CLR_buttonLight_OFF = R"(
-            background-color: rgb(210,210,210);
-            color: rgb(180,180,180);
-            border: 2px solid;
-            border-color: rgb(210,210,210);
-        )";
+        /// @{
+        static constexpr QColor CLR_buttonBgLight_OFF = QColor(210,210,210);
+        static constexpr QColor CLR_buttonTextLight_OFF = QColor(180,180,180);
+        static constexpr QColor CLR_buttonBorderLight_OFF = CLR_buttonBgLight_OFF;
+        /// @}
         /// Цвет кнопки - ВЫКЛ - темная тема
-        inline static const QString CLR_buttonDark_OFF = R"(
-            background-color: rgb(30,30,30);
-            color: rgb(60,60,60);
-            border: 2px solid;
-            border-color: rgb(30,30,30);
-        )";
+        /// @{
+        static constexpr QColor CLR_buttonBgDark_OFF = QColor(30,30,30);
+        static constexpr QColor CLR_buttonTextDark_OFF = QColor(60,60,60);
+        static constexpr QColor CLR_buttonBorderDark_OFF = CLR_buttonBgDark_OFF;
+        /// @}
 
         /// Цвет кнопки - при нажатии
-        inline static const QString CLR_buttonPressed = "background-color: rgb(180,180,180);";
+        static constexpr QColor CLR_buttonPressed = QColor(180,180,180);
 
         /// Цвет слайдера - ВКЛ - светлая тема
-        inline static const QString CLR_sliderLight_ON = R"(
-            QSlider::groove:horizontal { background: rgb(150,150,150); border: 2px solid; border-color: rgb(10,10,10);}
-            QSlider::handle:horizontal { background: rgb(80,80,80); width: 50px;}
-        )";
+        /// @{
+        static constexpr QColor CLR_sliderGrooveLight_ON = QColor(150,150,150);
+        static constexpr QColor CLR_sliderBorderLight_ON = QColor(10,10,10);
+        static constexpr QColor CLR_sliderHandleLight_ON = QColor(80,80,80);
+        /// @}
         /// Цвет слайдера - ВКЛ - темная тема
-        inline static const QString CLR_sliderDark_ON = R"(
-            QSlider::groove:horizontal { background: rgb(100,100,100); border: 2px solid; border-color: rgb(180,180,180);}
-            QSlider::handle:horizontal { background: rgb(200,200,200); width: 50px; }
-        )";
-        /// Цвет слайдера - ВЫКЛ - светлая тема
-        inline static const QString CLR_sliderLight_OFF = R"(
-            QSlider::groove:horizontal { background: rgb(200,200,200); }
-            QSlider::handle:horizontal { background: rgb(150,150,150); width: 50px; }
-        )";
-        /// Цвет слайдера - ВЫКЛ - темная тема
-        inline static const QString CLR_sliderDark_OFF = R"(
-            QSlider::groove:horizontal { background: rgb(50,50,50); }
-            QSlider::handle:horizontal { background: rgb(100,100,100); width: 50px; }
-        )";
+        /// @{
+        static constexpr QColor CLR_sliderGrooveDark_ON = QColor(100,100,100);
+        static constexpr QColor CLR_sliderBorderDark_ON = QColor(180,180,180);
+        static constexpr QColor CLR_sliderHandleDark_ON = QColor(200,200,200);
+        /// @}
+        /// Цвет слайдера - ВЫКЛ - светлая тема (без рамки)
+        /// @{
+        static constexpr QColor CLR_sliderGrooveLight_OFF = QColor(200,200,200);
+        static constexpr QColor CLR_sliderHandleLight_OFF = QColor(150,150,150);
+        /// @}
+        /// Цвет слайдера - ВЫКЛ - темная тема (без рамки)
+        /// @{
+        static constexpr QColor CLR_sliderGrooveDark_OFF = QColor(50,50,50);
+        static constexpr QColor CLR_sliderHandleDark_OFF = QColor(100,100,100);
+        /// @}
 
         /// Цвет полигона - ВКЛ - светлая тема
         static constexpr QColor CLR_acBodyLight_ON = QColor(150,150,150);
@@ -457,6 +503,8 @@ private slots:
     void togglePower();
     /// @brief Обработчик смены значения слайдера (угла потока воздуха)
     void onSliderChanged(int value);
+    /// @brief Включение и выключение качания заслонки
+    void toggleSwing();
     /// @brief Смена единицы измерения температуры
     void changeTempUnit();
     /// @brief Смена единицы измерения давления
@@ -0,0 +1,110 @@
+#include "mainview.h"
+#include "metrics.h"
+#include <QPaintEvent>
+#include <QKeyEvent>
+#include <QResizeEvent>
+#include <QTimer>
+
+MainView::MainView(MainScene *scene, QWidget *parent)
+    : QGraphicsView(scene, parent),
+    mainScene(scene),
+    frameCap(new QTimer(this))
+{
+    frameCap->setSingleShot(true);
+    connect(frameCap, &QTimer::timeout, this, &MainView::flushUpdate);
+    /// Отключение горизонтальных скроллбаров
+    setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    /// Отключение вертикальных скроллбаров
+    setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    setMinimumSize(Preferences::MIN_RESOLUTION);
+    applyResolution(scene->prefs->getResolution());
+    connect(scene, &MainScene::resolutionChanged, this, &MainView::applyResolution);
+}
+
+void MainView::applyResolution(const QSize &res)
+{
+    setSceneRect(0, 0, res.width(), res.height());
+    if (size() != res)
+        resize(res);
+}
+
+void MainView::resizeEvent(QResizeEvent *event)
+{
+    QGraphicsView::resizeEvent(event);
+    /// Настройки испускают resolutionChanged только при действительном изменении, сцена переразмещается по нему
+    mainScene->prefs->setResolution(event->size());
+}
+
+void MainView::setRenderMode(RenderMode newMode, int maxFps)
+{
+    frameInterval = 1000 / qBound(1, maxFps, 1000);
+    if (newMode == mode)
+        return;
+    mode = newMode;
+    bool lowPower = mode == LowPower;
+    mainScene->setLowPower(lowPower);
+    /// Элементы сцены не рисуются сглаженными, запас в 2 пикселя под сглаживание не нужен
+    setOptimizationFlag(DontAdjustForAntialiasing, lowPower);
+    if (lowPower) {
+        /// Области перерисовки собирает само окно, см. onSceneChanged()
+        setViewportUpdateMode(NoViewportUpdate);
+        connect(mainScene, &QGraphicsScene::changed, this, &MainView::onSceneChanged);
+        sinceFlush.start();
+    } else {
+        disconnect(mainScene, &QGraphicsScene::changed, this, &MainView::onSceneChanged);
+        frameCap->stop();
+        pendingUpdate = QRect();
+        setViewportUpdateMode(MinimalViewportUpdate);
+        viewport()->update();
+    }
+}
+
+void MainView::onSceneChanged(const QList<QRectF> &rects)
+{
+    for (const QRectF &rect : rects)
+        pendingUpdate |= mapFromScene(rect).boundingRect().adjusted(-1, -1, 1, 1);
+    if (pendingUpdate.isEmpty() || frameCap->isActive())
+        return;
+    /// Если с прошлого кадра прошло больше интервала, область перерисуется в этой же итерации цикла событий.
+    /// start(msec) меняет интервал таймера, поэтому ограничение берётся из frameInterval
+    frameCap->start(int(qMax<qint64>(0, frameInterval - sinceFlush.elapsed())));
+}
+
+void MainView::flushUpdate()
+{
+    sinceFlush.restart();
+    /// Одна прямоугольная область: на программной отрисовке один большой прямоугольник дешевле многих мелких
+    viewport()->update(pendingUpdate);
+    pendingUpdate = QRect();
+}
+
+void MainView::paintEvent(QPaintEvent *event)
+{
+    HudItem *hud = mainScene->isHudVisible() ? mainScene->hud() : nullptr;
+    if (!hud) {
+        METRICS_SCOPE(ScenePaint);
+        QGraphicsView::paintEvent(event);
+        return;
+    }
+    /// Подробные замеры кадра собираются, только пока панель показана
+    FrameStats stats;
+    if (frameTimer.isValid())
+        stats.frameInterval = frameTimer.nsecsElapsed();
+    frameTimer.start();
+    {
+        Metrics::ScopedTimer timer(Metrics::ScenePaint, &stats.paintTime);
+        QGraphicsView::paintEvent(event);
+    }
+    stats.dirtyRects = event->region().rectCount();
+    stats.paintedItems = items(event->region().boundingRect()).size();
+    hud->setFrameStats(stats);
+}
+
+void MainView::keyPressEvent(QKeyEvent *event)
+{
+    if (event->key() == Qt::Key_H && event->modifiers() == (Qt::ControlModifier | Qt::ShiftModifier)) {
+        mainScene->setHudVisible(!mainScene->isHudVisible());
+        return;
+    }
+    QGraphicsView::keyPressEvent(event);
+}
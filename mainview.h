@@ -0,0 +1,90 @@
+/**
+* @file
+* @brief Заголовочный файл окна основного интерфейса
+*/
+#ifndef MAINVIEW_H
+#define MAINVIEW_H
+
+#include <QGraphicsView>
+#include <QElapsedTimer>
+#include <QRect>
+#include "mainscene.h"
+
+class QTimer;
+
+/**
+ * @class MainView
+ * @brief Окно основного интерфейса
+ *
+ * Показывает MainScene без полос прокрутки, размер окна следует разрешению из настроек.
+ * Окно можно растягивать: новый размер записывается в настройки как разрешение, и сцена переразмещается.
+ * Время каждой отрисовки записывается в замеры (Metrics::ScenePaint) и, если показана, в панель производительности.
+ * Ctrl+Shift+H показывает и скрывает панель производительности.
+ *
+ * В режиме LowPower окно само собирает изменения сцены в один прямоугольник и перерисовывает его
+ * не чаще заданной частоты кадров: при перетаскивании слайдера десятки изменений за кадр
+ * превращаются в одну перерисовку.
+ */
+class MainView : public QGraphicsView
+{
+    Q_OBJECT
+public:
+    /// Режим отрисовки
+    enum RenderMode {
+        /// Обычная отрисовка Qt: каждое изменение сцены перерисовывается сразу
+        Default,
+        /// Для панелей без GPU: кэширование неизменяемых элементов и ограничение частоты кадров
+        LowPower
+    };
+    /// Частота кадров в режиме LowPower по умолчанию
+    static constexpr int DEFAULT_MAXFPS = 25;
+
+    explicit MainView(MainScene *scene, QWidget *parent = nullptr);
+    /**
+     * @brief Смена режима отрисовки
+     * @param mode Режим
+     * @param maxFps Наибольшая частота кадров в режиме LowPower
+     */
+    void setRenderMode(RenderMode mode, int maxFps = DEFAULT_MAXFPS);
+    /// @brief Текущий режим отрисовки
+    RenderMode renderMode() const { return mode; }
+    /**
+     * @brief Смена размера окна и области сцены
+     *
+     * Окно меняет размер, только если он отличается от разрешения: разрешение, пришедшее
+     * из resizeEvent(), не вызывает повторного изменения размера.
+     * @param res разрешение окна
+     */
+    void applyResolution(const QSize &res);
+
+protected:
+    /// @brief Размер окна становится разрешением в настройках
+    void resizeEvent(QResizeEvent *event) override;
+    /// @brief Отрисовка с замером времени
+    void paintEvent(QPaintEvent *event) override;
+    /// @brief Ctrl+Shift+H переключает панель производительности
+    void keyPressEvent(QKeyEvent *event) override;
+
+private:
+    /// Сцена интерфейса
+    MainScene *mainScene;
+    /// Время с предыдущего кадра
+    QElapsedTimer frameTimer;
+    /// Режим отрисовки
+    RenderMode mode = Default;
+    /// Таймер ограничения частоты кадров
+    QTimer *frameCap;
+    /// Наименьший интервал между кадрами в режиме LowPower, мс
+    int frameInterval = 1000 / DEFAULT_MAXFPS;
+    /// Время с последней перерисовки в режиме LowPower
+    QElapsedTimer sinceFlush;
+    /// Накопленная область перерисовки
+    QRect pendingUpdate;
+
+    /// @brief Накопление изменившейся области сцены
+    void onSceneChanged(const QList<QRectF> &rects);
+    /// @brief Перерисовка накопленной области
+    void flushUpdate();
+};
+
+#endif // MAINVIEW_H
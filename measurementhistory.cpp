@@ -0,0 +1,28 @@
+#include "measurementhistory.h"
+#include <limits>
+
+MeasurementHistory::MeasurementHistory()
+    : ring(CAPACITY)
+{
+}
+
+void MeasurementHistory::append(qreal value, qint64 timestamp)
+{
+    qint64 bucket = timestamp / BUCKETMS;
+    if (currentBucket < 0)
+        currentBucket = bucket;
+
+    /// Начался новый интервал: текущий закрывается, пропущенные интервалы заполняются NaN
+    if (bucket > currentBucket) {
+        ring.push(count > 0 ? static_cast<float>(sum / count) : std::numeric_limits<float>::quiet_NaN());
+        qint64 gap = qMin<qint64>(bucket - currentBucket - 1, CAPACITY);
+        for (qint64 i = 0; i < gap; ++i)
+            ring.push(std::numeric_limits<float>::quiet_NaN());
+        currentBucket = bucket;
+        sum = 0;
+        count = 0;
+    }
+    /// Отсчёт с более ранним временем (часы переведены назад) учитывается в текущем интервале
+    sum += value;
+    ++count;
+}
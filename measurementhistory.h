@@ -0,0 +1,50 @@
+/**
+* @file
+* @brief Заголовочный файл истории измерений
+*
+* Отсчёты одной величины усредняются по интервалам фиксированной длины и хранятся в кольцевом буфере.
+* Объём памяти не зависит от частоты датчика: при интервале 5 с и ёмкости 65536 интервалов
+* хранится около 3,8 суток истории (256 КБ на величину).
+*/
+#ifndef MEASUREMENTHISTORY_H
+#define MEASUREMENTHISTORY_H
+
+#include "ringbuffer.h"
+
+/**
+ * @class MeasurementHistory
+ * @brief История одной измеряемой величины
+ *
+ * Значения хранятся в базовых единицах (°C, %, мм рт.ст.), поэтому смена единиц измерения историю не затрагивает.
+ * Интервалы без данных хранятся как NaN.
+ */
+class MeasurementHistory
+{
+public:
+    /// Длина интервала усреднения, мс
+    static constexpr qint64 BUCKETMS = 5000;
+    /// Количество хранимых интервалов
+    static constexpr quint32 CAPACITY = 65536;
+
+    MeasurementHistory();
+    /**
+     * @brief Добавление отсчёта
+     * @param value Значение в базовых единицах
+     * @param timestamp Время отсчёта, мс с начала эпохи
+     */
+    void append(qreal value, qint64 timestamp);
+    /// @brief Завершённые интервалы (среднее значение за интервал)
+    const RingBuffer<float> &buckets() const { return ring; }
+
+private:
+    /// Средние значения завершённых интервалов
+    RingBuffer<float> ring;
+    /// Номер текущего интервала (-1 - отсчётов ещё не было)
+    qint64 currentBucket = -1;
+    /// Сумма отсчётов текущего интервала
+    double sum = 0;
+    /// Количество отсчётов текущего интервала
+    int count = 0;
+};
+
+#endif // MEASUREMENTHISTORY_H
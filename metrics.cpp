@@ -0,0 +1,281 @@
+#include "metrics.h"
+#include <QTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVector>
+#include <QSaveFile>
+#include <QFile>
+#include <QList>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QtAlgorithms>
+#include <QDebug>
+#include <atomic>
+#include <cmath>
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_LINUX)
+#include <unistd.h>
+#endif
+
+namespace Metrics {
+
+namespace {
+/// Имена участков в выгрузке, по порядку Probe
+constexpr const char *PROBENAMES[ProbeCount] = {
+    "plusTargetTemp",
+    "minusTargetTemp",
+    "togglePower",
+    "sliderChanged",
+    "changeTempUnit",
+    "changePressureUnit",
+    "changeResolution",
+    "changeTheme",
+    "toggleSwing",
+    "prefsLoad",
+    "prefsSave",
+    "scenePaint",
+    "applyTheme",
+    "placeAllBlocks",
+    "eventLoopLag",
+    "deviceRoundTrip",
+    "modbusCycle",
+    "driverPoll"
+};
+
+/**
+ * @struct ThreadHistograms
+ * @brief Гистограммы одного потока
+ *
+ * Пишет только поток-владелец, поэтому достаточно загрузки и сохранения без атомарного сложения.
+ * Выгрузка из другого потока читает значения без блокировок и может отстать на последний замер.
+ */
+struct ThreadHistograms {
+    std::atomic<quint64> buckets[ProbeCount][BUCKETS];
+    std::atomic<quint64> count[ProbeCount];
+    std::atomic<quint64> sum[ProbeCount];
+    std::atomic<quint64> max[ProbeCount];
+};
+
+/// Гистограммы всех потоков. Не удаляются, чтобы замеры завершившихся потоков остались в выгрузке.
+struct Registry {
+    QMutex mutex;
+    QVector<ThreadHistograms*> threads;
+};
+
+Registry &registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+/// @brief Гистограммы текущего потока, создаются при первом замере
+ThreadHistograms *local()
+{
+    thread_local ThreadHistograms *histograms = nullptr;
+    if (!histograms) {
+        /// Value-инициализация обнуляет все счётчики
+        histograms = new ThreadHistograms();
+        QMutexLocker lock(&registry().mutex);
+        registry().threads.append(histograms);
+    }
+    return histograms;
+}
+
+/// @brief Прибавление к счётчику, который пишет один поток
+inline void add(std::atomic<quint64> &counter, quint64 value)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+/// @brief Номер корзины для длительности
+int bucketOf(quint64 ns)
+{
+    /// Округление вверх: длительность не должна попасть в корзину, граница которой меньше её
+    quint64 us = (ns + 999) / 1000;
+    if (us <= 1)
+        return 0;
+    return qMin(64 - int(qCountLeadingZeroBits(us - 1)), BUCKETS - 1);
+}
+
+/// @brief Верхняя граница корзины, нс
+quint64 bucketBound(int bucket)
+{
+    return quint64(1000) << bucket;
+}
+
+/// @brief Наносекунды в секундах для выгрузки
+QByteArray seconds(quint64 ns)
+{
+    return QByteArray::number(double(ns) / 1e9, 'g', 9);
+}
+}
+
+const char *probeName(Probe probe)
+{
+    return probe < ProbeCount ? PROBENAMES[probe] : "unknown";
+}
+
+void record(Probe probe, qint64 ns)
+{
+    if (probe >= ProbeCount)
+        return;
+    quint64 value = quint64(qMax<qint64>(0, ns));
+    ThreadHistograms *h = local();
+    add(h->buckets[probe][bucketOf(value)], 1);
+    add(h->count[probe], 1);
+    add(h->sum[probe], value);
+    if (value > h->max[probe].load(std::memory_order_relaxed))
+        h->max[probe].store(value, std::memory_order_relaxed);
+}
+
+quint64 Summary::quantile(double q) const
+{
+    if (!count)
+        return 0;
+    quint64 target = quint64(std::ceil(q * double(count)));
+    quint64 seen = 0;
+    for (int i = 0; i < BUCKETS - 1; ++i) {
+        seen += buckets[i];
+        if (seen >= target)
+            return qMin(bucketBound(i), max);
+    }
+    return max;
+}
+
+Summary summary(Probe probe)
+{
+    Summary result;
+    if (probe >= ProbeCount)
+        return result;
+    QMutexLocker lock(&registry().mutex);
+    for (const ThreadHistograms *h : qAsConst(registry().threads)) {
+        for (int i = 0; i < BUCKETS; ++i)
+            result.buckets[i] += h->buckets[probe][i].load(std::memory_order_relaxed);
+        result.count += h->count[probe].load(std::memory_order_relaxed);
+        result.sum += h->sum[probe].load(std::memory_order_relaxed);
+        result.max = qMax(result.max, h->max[probe].load(std::memory_order_relaxed));
+    }
+    return result;
+}
+
+QByteArray exportText()
+{
+    QByteArray out;
+    out += "# HELP ac_latency_seconds Duration of hot paths and event loop lag.\n"
+           "# TYPE ac_latency_seconds histogram\n";
+    QByteArray maxLines = "# HELP ac_latency_max_seconds Longest recorded duration.\n"
+                          "# TYPE ac_latency_max_seconds gauge\n";
+    for (int p = 0; p < ProbeCount; ++p) {
+        Summary s = summary(Probe(p));
+        QByteArray label = QByteArray("{probe=\"") + PROBENAMES[p] + '"';
+        /// Корзины в Prometheus накопительные
+        quint64 cumulative = 0;
+        for (int i = 0; i < BUCKETS - 1; ++i) {
+            cumulative += s.buckets[i];
+            out += "ac_latency_seconds_bucket" + label + ",le=\"" + seconds(bucketBound(i)) + "\"} "
+                   + QByteArray::number(cumulative) + '\n';
+        }
+        out += "ac_latency_seconds_bucket" + label + ",le=\"+Inf\"} " + QByteArray::number(s.count) + '\n';
+        out += "ac_latency_seconds_sum" + label + "} " + seconds(s.sum) + '\n';
+        out += "ac_latency_seconds_count" + label + "} " + QByteArray::number(s.count) + '\n';
+        maxLines += "ac_latency_max_seconds" + label + "} " + seconds(s.max) + '\n';
+    }
+    out += maxLines;
+    qint64 rss = residentMemory();
+    if (rss >= 0)
+        out += "# HELP ac_resident_memory_bytes Resident set size of the process.\n"
+               "# TYPE ac_resident_memory_bytes gauge\n"
+               "ac_resident_memory_bytes " + QByteArray::number(rss) + '\n';
+    return out;
+}
+
+bool exportToFile(const QString &filename)
+{
+    QSaveFile file(filename);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    QByteArray text = exportText();
+    if (file.write(text) != text.size()) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+qint64 residentMemory()
+{
+#if defined(Q_OS_LINUX)
+    /// Второе поле /proc/self/statm - количество резидентных страниц
+    QFile statm("/proc/self/statm");
+    if (!statm.open(QIODevice::ReadOnly))
+        return -1;
+    QList<QByteArray> fields = statm.readAll().split(' ');
+    return fields.size() > 1 ? fields[1].toLongLong() * sysconf(_SC_PAGESIZE) : -1;
+#elif defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return -1;
+    return qint64(counters.WorkingSetSize);
+#else
+    return -1;
+#endif
+}
+
+LagMonitor::LagMonitor(QObject *parent)
+    : QObject(parent),
+    timer(new QTimer(this))
+{
+    timer->setTimerType(Qt::PreciseTimer);
+    timer->setInterval(INTERVAL);
+    connect(timer, &QTimer::timeout, this, &LagMonitor::onTimeout);
+}
+
+void LagMonitor::start()
+{
+    elapsed.start();
+    timer->start();
+}
+
+void LagMonitor::stop()
+{
+    timer->stop();
+}
+
+void LagMonitor::onTimeout()
+{
+    /// Всё, что сверх интервала, - время, на которое цикл событий был занят
+    qint64 ns = elapsed.nsecsElapsed();
+    elapsed.restart();
+    record(EventLoopLag, ns - qint64(INTERVAL) * 1000000);
+}
+
+Exporter::Exporter(QObject *parent)
+    : QObject(parent),
+    server(new QLocalServer(this))
+{
+    connect(server, &QLocalServer::newConnection, this, &Exporter::onNewConnection);
+}
+
+bool Exporter::listen(const QString &name)
+{
+    QLocalServer::removeServer(name);
+    if (!server->listen(name)) {
+        qWarning() << "Metrics exporter failed to listen on" << name << ":" << server->errorString();
+        return false;
+    }
+    return true;
+}
+
+void Exporter::onNewConnection()
+{
+    while (QLocalSocket *socket = server->nextPendingConnection()) {
+        connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+        socket->write(exportText());
+        /// Отключение дожидается отправки всех данных
+        socket->disconnectFromServer();
+    }
+}
+
+}
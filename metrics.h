@@ -0,0 +1,191 @@
+/**
+* @file
+* @brief Заголовочный файл замеров времени выполнения
+*
+* Время горячих участков (обработчики интерфейса, загрузка и сохранение настроек, отрисовка сцены)
+* и задержка цикла событий записываются в гистограммы. У каждого потока свои гистограммы: запись -
+* несколько атомарных сохранений без блокировок, блокировка берётся только при первом замере в потоке.
+* Гистограммы выгружаются по запросу в текстовом формате Prometheus - в файл или в локальный сокет.
+*
+* Замеры отключаются при сборке с DEFINES += AC_NO_METRICS, макрос METRICS_SCOPE тогда пуст.
+*/
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QByteArray>
+#include <QString>
+
+class QTimer;
+class QLocalServer;
+
+namespace Metrics {
+
+/// Замеряемые участки
+enum Probe : quint8 {
+    PlusTargetTemp,
+    MinusTargetTemp,
+    TogglePower,
+    SliderChanged,
+    ChangeTempUnit,
+    ChangePressureUnit,
+    ChangeResolution,
+    ChangeTheme,
+    ToggleSwing,
+    /// Загрузка настроек (XML и снимок)
+    PrefsLoad,
+    /// Сохранение настроек (XML и снимок)
+    PrefsSave,
+    /// Отрисовка сцены
+    ScenePaint,
+    /// Применение темы к элементам сцены
+    ApplyTheme,
+    /// Полное размещение элементов сцены
+    PlaceAllBlocks,
+    /// Задержка цикла событий основного потока
+    EventLoopLag,
+    /// Время от отправки команды кондиционеру до подтверждения
+    DeviceRoundTrip,
+    /// Цикл опроса кондиционеров по Modbus: от первого запроса до последнего ответа
+    ModbusCycle,
+    /// Один опрос драйвера датчиков в пуле потоков
+    DriverPoll,
+    ProbeCount
+};
+
+/// Количество корзин гистограммы. Корзина i - длительности до 2^i мкс, последняя - всё остальное.
+constexpr int BUCKETS = 24;
+
+/// @brief Имя участка в выгрузке
+const char *probeName(Probe probe);
+
+/**
+ * @brief Запись замера в гистограмму текущего потока
+ * @param probe Участок
+ * @param ns Длительность в наносекундах
+ */
+void record(Probe probe, qint64 ns);
+
+/**
+ * @struct Summary
+ * @brief Сводка гистограмм участка по всем потокам
+ */
+struct Summary {
+    /// Количество замеров в корзинах
+    quint64 buckets[BUCKETS] = {};
+    /// Количество замеров
+    quint64 count = 0;
+    /// Сумма длительностей, нс
+    quint64 sum = 0;
+    /// Наибольшая длительность, нс
+    quint64 max = 0;
+    /// @brief Верхняя граница квантиля q (0..1), нс
+    quint64 quantile(double q) const;
+};
+
+/// @brief Сводка участка по всем потокам
+Summary summary(Probe probe);
+/// @brief Выгрузка всех гистограмм в текстовом формате Prometheus
+QByteArray exportText();
+/// @brief Выгрузка в файл (запись во временный файл и атомарная замена)
+bool exportToFile(const QString &filename);
+/// @brief Резидентная память процесса в байтах, -1 если неизвестна
+qint64 residentMemory();
+
+/**
+ * @class ScopedTimer
+ * @brief Замер времени от создания до выхода из области видимости
+ */
+class ScopedTimer
+{
+public:
+    /**
+     * @param probe Участок
+     * @param last Куда дополнительно записать длительность последнего замера, нс
+     */
+    explicit ScopedTimer(Probe probe, qint64 *last = nullptr) : probe(probe), last(last) { timer.start(); }
+    ~ScopedTimer()
+    {
+        qint64 ns = timer.nsecsElapsed();
+        if (last)
+            *last = ns;
+        record(probe, ns);
+    }
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+    Probe probe;
+    qint64 *last;
+    QElapsedTimer timer;
+};
+
+/**
+ * @class LagMonitor
+ * @brief Замер задержки цикла событий
+ *
+ * Таймер с известным интервалом: на сколько позже интервала он сработал, настолько цикл событий был занят.
+ */
+class LagMonitor : public QObject
+{
+    Q_OBJECT
+public:
+    /// Интервал проверки, мс
+    static constexpr int INTERVAL = 100;
+
+    explicit LagMonitor(QObject *parent = nullptr);
+    /// @brief Запуск замеров в потоке объекта
+    void start();
+    /// @brief Остановка замеров
+    void stop();
+
+private:
+    /// Таймер проверки
+    QTimer *timer;
+    /// Время с прошлого срабатывания
+    QElapsedTimer elapsed;
+
+    /// @brief Срабатывание таймера
+    void onTimeout();
+};
+
+/**
+ * @class Exporter
+ * @brief Выгрузка гистограмм в локальный сокет
+ *
+ * Каждому подключившемуся клиенту отправляется текущая выгрузка, после чего подключение закрывается.
+ */
+class Exporter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Exporter(QObject *parent = nullptr);
+    /**
+     * @brief Запуск сервера
+     * @param name Имя локального сокета
+     * @return true если сервер запущен
+     */
+    bool listen(const QString &name);
+
+private:
+    /// Сервер
+    QLocalServer *server;
+
+    /// @brief Новое подключение
+    void onNewConnection();
+};
+
+}
+
+#define METRICS_CONCAT_(a, b) a##b
+#define METRICS_CONCAT(a, b) METRICS_CONCAT_(a, b)
+
+#ifdef AC_NO_METRICS
+#define METRICS_SCOPE(probe) do {} while (false)
+#else
+/// Замер времени до конца текущей области видимости
+#define METRICS_SCOPE(probe) Metrics::ScopedTimer METRICS_CONCAT(metricsScope, __LINE__)(Metrics::probe)
+#endif
+
+#endif // METRICS_H
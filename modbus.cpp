@@ -0,0 +1,682 @@
+#include "modbus.h"
+#include "metrics.h"
+#include <QTcpSocket>
+#include <QTcpServer>
+#include <QHostAddress>
+#include <QTimer>
+#include <QDateTime>
+#include <QRandomGenerator>
+#include <QDebug>
+#include <memory>
+
+using namespace Modbus;
+
+namespace {
+/**
+ * @brief Заголовок MBAP
+ * @param pduSize Размер PDU, в длину кадра входит ещё номер устройства
+ */
+void writeHeader(uchar *dst, quint16 transaction, quint8 unit, int pduSize)
+{
+    qToBigEndian<quint16>(transaction, dst);
+    qToBigEndian<quint16>(0, dst + 2);
+    qToBigEndian<quint16>(quint16(pduSize + 1), dst + 4);
+    dst[6] = unit;
+}
+
+/// @brief Бит блока регистров в ModbusPoller::Unit::pending и valid
+quint8 blockBit(quint8 function)
+{
+    return function == ReadInputRegisters ? 1 : 2;
+}
+
+/// @brief Количество регистров блока
+int blockSize(quint8 function)
+{
+    return function == ReadInputRegisters ? int(Map::InputCount) : int(Map::HoldingCount);
+}
+}
+
+int Modbus::parseFrame(const uchar *data, int size, Frame *frame)
+{
+    if (size < HEADERSIZE)
+        return 0;
+    quint16 length = qFromBigEndian<quint16>(data + 4);
+    /// Идентификатор протокола всегда 0, в длину входят номер устройства и хотя бы код функции
+    if (qFromBigEndian<quint16>(data + 2) != 0 || length < 2 || length > MAXFRAME - 6)
+        return -1;
+    int total = 6 + length;
+    if (size < total)
+        return 0;
+    frame->transaction = qFromBigEndian<quint16>(data);
+    frame->unit = data[6];
+    frame->pdu = data + HEADERSIZE;
+    frame->pduSize = length - 1;
+    frame->function = frame->pdu[0];
+    return total;
+}
+
+int Modbus::encodeRead(uchar *dst, quint16 transaction, quint8 unit, quint8 function, quint16 start, quint16 count)
+{
+    writeHeader(dst, transaction, unit, 5);
+    uchar *pdu = dst + HEADERSIZE;
+    pdu[0] = function;
+    qToBigEndian<quint16>(start, pdu + 1);
+    qToBigEndian<quint16>(count, pdu + 3);
+    return HEADERSIZE + 5;
+}
+
+int Modbus::encodeWrite(uchar *dst, quint16 transaction, quint8 unit, quint16 start, const quint16 *values, int count)
+{
+    int pduSize = 6 + 2 * count;
+    writeHeader(dst, transaction, unit, pduSize);
+    uchar *pdu = dst + HEADERSIZE;
+    pdu[0] = WriteMultipleRegisters;
+    qToBigEndian<quint16>(start, pdu + 1);
+    qToBigEndian<quint16>(quint16(count), pdu + 3);
+    pdu[5] = uchar(2 * count);
+    for (int i = 0; i < count; ++i)
+        qToBigEndian<quint16>(values[i], pdu + 6 + 2 * i);
+    return HEADERSIZE + pduSize;
+}
+
+int Modbus::encodeReadReply(uchar *dst, quint16 transaction, quint8 unit, quint8 function, const quint16 *values, int count)
+{
+    int pduSize = 2 + 2 * count;
+    writeHeader(dst, transaction, unit, pduSize);
+    uchar *pdu = dst + HEADERSIZE;
+    pdu[0] = function;
+    pdu[1] = uchar(2 * count);
+    for (int i = 0; i < count; ++i)
+        qToBigEndian<quint16>(values[i], pdu + 2 + 2 * i);
+    return HEADERSIZE + pduSize;
+}
+
+int Modbus::encodeWriteReply(uchar *dst, quint16 transaction, quint8 unit, quint16 start, quint16 count)
+{
+    writeHeader(dst, transaction, unit, 5);
+    uchar *pdu = dst + HEADERSIZE;
+    pdu[0] = WriteMultipleRegisters;
+    qToBigEndian<quint16>(start, pdu + 1);
+    qToBigEndian<quint16>(count, pdu + 3);
+    return HEADERSIZE + 5;
+}
+
+int Modbus::encodeException(uchar *dst, quint16 transaction, quint8 unit, quint8 function, quint8 code)
+{
+    writeHeader(dst, transaction, unit, 2);
+    dst[HEADERSIZE] = function | EXCEPTIONFLAG;
+    dst[HEADERSIZE + 1] = code;
+    return HEADERSIZE + 2;
+}
+
+bool Modbus::parseEndpoint(const QString &spec, QString *host, quint16 *port, quint8 *unit)
+{
+    QString address = spec.section('/', 0, 0);
+    QString unitPart = spec.section('/', 1);
+    bool ok = true;
+    int id = unitPart.isEmpty() ? 1 : unitPart.toInt(&ok);
+    if (!ok || id < 1 || id > MAXUNITS)
+        return false;
+    int portValue = PORT;
+    int colon = address.lastIndexOf(':');
+    if (colon >= 0) {
+        portValue = address.mid(colon + 1).toInt(&ok);
+        address.truncate(colon);
+        if (!ok || portValue < 1 || portValue > 65535)
+            return false;
+    }
+    if (address.isEmpty())
+        return false;
+    *host = address;
+    *port = quint16(portValue);
+    *unit = quint8(id);
+    return true;
+}
+
+ModbusClient::ModbusClient(const QString &host, quint16 port, QObject *parent)
+    : QObject(parent),
+    host(host),
+    port(port),
+    socket(new QTcpSocket(this)),
+    reconnect(new QTimer(this)),
+    timeoutCheck(new QTimer(this))
+{
+    clock.start();
+    reconnect->setSingleShot(true);
+    reconnect->setInterval(RECONNECT);
+    timeoutCheck->setInterval(TIMEOUT / 4);
+    connect(reconnect, &QTimer::timeout, this, &ModbusClient::open);
+    connect(timeoutCheck, &QTimer::timeout, this, &ModbusClient::checkTimeouts);
+    connect(socket, &QTcpSocket::connected, this, [this]() {
+        /// Запросы маленькие и уходят пачками, задержка Нейгла только растянула бы цикл опроса
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        emit connected();
+    });
+    connect(socket, &QTcpSocket::readyRead, this, &ModbusClient::onReadyRead);
+    connect(socket, &QTcpSocket::disconnected, this, [this]() {
+        failAll();
+        reconnect->start();
+    });
+    connect(socket, &QTcpSocket::errorOccurred, this, [this]() {
+        failAll();
+        reconnect->start();
+    });
+}
+
+void ModbusClient::open()
+{
+    socket->abort();
+    failAll();
+    reader.reset();
+    /// abort() мог запустить переподключение, а подключение уже начинается
+    reconnect->stop();
+    socket->connectToHost(host, port);
+}
+
+bool ModbusClient::isConnected() const
+{
+    return socket->state() == QAbstractSocket::ConnectedState;
+}
+
+quint16 ModbusClient::read(quint8 unit, Modbus::Function function, quint16 start, quint16 count)
+{
+    if (!isConnected() || count < 1 || count > MAXREAD)
+        return 0;
+    Request request;
+    request.slot.transaction = nextTransaction;
+    request.slot.unit = unit;
+    request.slot.function = function;
+    request.size = quint8(encodeRead(request.frame, nextTransaction, unit, function, start, count));
+    return submit(request);
+}
+
+quint16 ModbusClient::write(quint8 unit, quint16 start, const quint16 *values, int count)
+{
+    if (!isConnected() || count < 1 || count > MAXWRITE)
+        return 0;
+    Request request;
+    request.slot.transaction = nextTransaction;
+    request.slot.unit = unit;
+    request.slot.function = WriteMultipleRegisters;
+    request.size = quint8(encodeWrite(request.frame, nextTransaction, unit, start, values, count));
+    return submit(request);
+}
+
+quint16 ModbusClient::submit(const Request &request)
+{
+    /// Номер 0 означает свободный слот
+    if (!++nextTransaction)
+        nextTransaction = 1;
+    /// Порядок отправки сохраняется: пока очередь не пуста, новые запросы встают за ней
+    if (inFlight < MAXINFLIGHT && queueHead == queue.size())
+        send(request);
+    else
+        queue.append(request);
+    return request.slot.transaction;
+}
+
+void ModbusClient::send(const Request &request)
+{
+    for (Slot &slot : window) {
+        if (slot.transaction)
+            continue;
+        slot = request.slot;
+        slot.sent = clock.elapsed();
+        break;
+    }
+    ++inFlight;
+    socket->write(reinterpret_cast<const char*>(request.frame), request.size);
+    if (!timeoutCheck->isActive())
+        timeoutCheck->start();
+}
+
+void ModbusClient::pump()
+{
+    while (inFlight < MAXINFLIGHT && queueHead < queue.size())
+        send(queue[queueHead++]);
+    /// clear() сохраняет выделенную память, очередь не перевыделяется каждый цикл
+    if (queueHead == queue.size()) {
+        queue.clear();
+        queueHead = 0;
+    }
+    if (!inFlight)
+        timeoutCheck->stop();
+}
+
+void ModbusClient::onReadyRead()
+{
+    bool synced = reader.read(socket, [this](const Modbus::Frame &frame) {
+        for (Slot &slot : window) {
+            if (slot.transaction != frame.transaction)
+                continue;
+            /// Ответ должен прийти от того же устройства на ту же функцию
+            if (slot.unit != frame.unit || slot.function != (frame.function & ~EXCEPTIONFLAG))
+                return;
+            slot.transaction = 0;
+            --inFlight;
+            emit replied(frame);
+            return;
+        }
+        /// Ответ пришёл после истечения времени ожидания, запрос уже завершён
+    });
+    if (!synced) {
+        qWarning() << "Modbus: malformed frame from" << description();
+        /// Обрыв завершит ожидающие запросы и запустит переподключение
+        socket->abort();
+        return;
+    }
+    pump();
+}
+
+void ModbusClient::checkTimeouts()
+{
+    qint64 now = clock.elapsed();
+    for (Slot &slot : window) {
+        if (!slot.transaction || now - slot.sent < TIMEOUT)
+            continue;
+        Slot expired = slot;
+        slot.transaction = 0;
+        --inFlight;
+        emit timedOut(expired.transaction, expired.unit, expired.function);
+    }
+    pump();
+}
+
+void ModbusClient::failAll()
+{
+    timeoutCheck->stop();
+    /// Обработчики могут отправить новые запросы, поэтому очередь забирается целиком заранее
+    QVector<Request> queued;
+    queued.swap(queue);
+    int head = queueHead;
+    queueHead = 0;
+    for (Slot &slot : window) {
+        if (!slot.transaction)
+            continue;
+        Slot expired = slot;
+        slot.transaction = 0;
+        --inFlight;
+        emit timedOut(expired.transaction, expired.unit, expired.function);
+    }
+    for (int i = head; i < queued.size(); ++i)
+        emit timedOut(queued[i].slot.transaction, queued[i].slot.unit, queued[i].slot.function);
+}
+
+QString ModbusClient::description() const
+{
+    return QString("%1:%2").arg(host).arg(port);
+}
+
+ModbusPoller::ModbusPoller(QObject *parent)
+    : QObject(parent),
+    timer(new QTimer(this))
+{
+    timer->setInterval(INTERVAL);
+    connect(timer, &QTimer::timeout, this, &ModbusPoller::poll);
+}
+
+int ModbusPoller::addUnit(const QString &host, quint16 port, quint8 id)
+{
+    QString key = QString("%1:%2").arg(host).arg(port);
+    int e = endpointIndex.value(key, -1);
+    if (e < 0) {
+        e = endpoints.size();
+        Endpoint endpoint;
+        endpoint.client = new ModbusClient(host, port, this);
+        endpoint.units.fill(-1, 256);
+        endpoints.append(endpoint);
+        endpointIndex.insert(key, e);
+        /// Кадр ответа указывает в приёмный буфер соединения, поэтому соединения прямые
+        connect(endpoint.client, &ModbusClient::replied, this, [this, e](const Modbus::Frame &frame) {
+            onReplied(e, frame);
+        }, Qt::DirectConnection);
+        connect(endpoint.client, &ModbusClient::timedOut, this, [this, e](quint16, quint8 id, quint8 function) {
+            onTimedOut(e, id, function);
+        }, Qt::DirectConnection);
+    }
+    Unit unit;
+    unit.id = id;
+    unit.endpoint = e;
+    endpoints[e].units[id] = units.size();
+    units.append(unit);
+    return units.size() - 1;
+}
+
+void ModbusPoller::setInterval(int ms)
+{
+    timer->setInterval(ms);
+}
+
+void ModbusPoller::start()
+{
+    for (const Endpoint &endpoint : qAsConst(endpoints))
+        endpoint.client->open();
+    timer->start();
+}
+
+void ModbusPoller::stop()
+{
+    timer->stop();
+}
+
+bool ModbusPoller::isConnected() const
+{
+    for (const Endpoint &endpoint : endpoints) {
+        if (!endpoint.client->isConnected())
+            return false;
+    }
+    return true;
+}
+
+void ModbusPoller::poll()
+{
+    ++counters.cycles;
+    cycleClock.start();
+    /// Запросы ко всем кондиционерам уходят сразу, ответы обрабатываются по мере прихода
+    for (Unit &unit : units) {
+        request(unit, ReadInputRegisters);
+        request(unit, ReadHoldingRegisters);
+    }
+    if (!outstanding)
+        emit cycleFinished();
+}
+
+void ModbusPoller::request(Unit &unit, quint8 function)
+{
+    quint8 bit = blockBit(function);
+    /// Кондиционер ещё не ответил на предыдущий цикл: второй запрос того же блока не нужен
+    if (unit.pending & bit) {
+        ++counters.skipped;
+        return;
+    }
+    ModbusClient *client = endpoints[unit.endpoint].client;
+    if (!client->read(unit.id, Modbus::Function(function), 0, quint16(blockSize(function)))) {
+        ++counters.skipped;
+        ++unit.misses;
+        return;
+    }
+    unit.pending |= bit;
+    ++outstanding;
+    ++counters.requests;
+}
+
+void ModbusPoller::onReplied(int endpoint, const Modbus::Frame &frame)
+{
+    int index = endpoints[endpoint].units[frame.unit];
+    if (index < 0)
+        return;
+    Unit &unit = units[index];
+    quint8 function = frame.function & ~EXCEPTIONFLAG;
+    quint8 bit = blockBit(function);
+    if (!(unit.pending & bit))
+        return;
+    unit.pending &= ~bit;
+
+    int count = blockSize(function);
+    if (frame.isException() || frame.registerCount() < count) {
+        ++counters.exceptions;
+        ++unit.misses;
+    } else {
+        /// Регистры читаются прямо из приёмного буфера
+        quint16 *dst = function == ReadInputRegisters ? unit.input : unit.holding;
+        for (int i = 0; i < count; ++i)
+            dst[i] = frame.registerAt(i);
+        unit.valid |= bit;
+        unit.misses = 0;
+        ++counters.replies;
+        emit unitUpdated(index, function);
+    }
+    finishRequest();
+}
+
+void ModbusPoller::onTimedOut(int endpoint, quint8 id, quint8 function)
+{
+    int index = endpoints[endpoint].units[id];
+    if (index < 0)
+        return;
+    Unit &unit = units[index];
+    quint8 bit = blockBit(function);
+    if (!(unit.pending & bit))
+        return;
+    unit.pending &= ~bit;
+    ++unit.misses;
+    ++counters.timeouts;
+    finishRequest();
+}
+
+void ModbusPoller::finishRequest()
+{
+    if (--outstanding)
+        return;
+    Metrics::record(Metrics::ModbusCycle, cycleClock.nsecsElapsed());
+    emit cycleFinished();
+}
+
+ModbusServer::ModbusServer(int units, QObject *parent)
+    : QObject(parent),
+    units(qBound(1, units, MAXUNITS)),
+    server(new QTcpServer(this)),
+    inputs(this->units * Map::InputCount),
+    holdings(this->units * Map::HoldingCount)
+{
+    /// Температура у устройств немного разная, чтобы их можно было различить в обзоре парка
+    QRandomGenerator *rnd = QRandomGenerator::global();
+    for (int u = 1; u <= this->units; ++u) {
+        setInput(quint8(u), Map::Temperature, Map::encode(20 + rnd->bounded(60) / 10.0));
+        setInput(quint8(u), Map::Humidity, Map::encode(45));
+        setInput(quint8(u), Map::Pressure, Map::encode(760));
+        holdings[(u - 1) * Map::HoldingCount + Map::TargetTemp] = Map::encode(22);
+    }
+    connect(server, &QTcpServer::newConnection, this, &ModbusServer::acceptConnections);
+    QTimer *timer = new QTimer(this);
+    connect(timer, &QTimer::timeout, this, &ModbusServer::drift);
+    timer->start(DRIFTINTERVAL);
+}
+
+bool ModbusServer::listen(quint16 port)
+{
+    if (!server->listen(QHostAddress::LocalHost, port)) {
+        qWarning() << "Modbus simulator failed to listen:" << server->errorString();
+        return false;
+    }
+    return true;
+}
+
+quint16 ModbusServer::port() const
+{
+    return server->serverPort();
+}
+
+void ModbusServer::acceptConnections()
+{
+    while (QTcpSocket *socket = server->nextPendingConnection()) {
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        /// Приёмный буфер у каждого подключения свой
+        auto reader = std::make_shared<FrameReader>();
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket, reader]() {
+            uchar out[MAXFRAME];
+            bool synced = reader->read(socket, [&](const Modbus::Frame &frame) {
+                socket->write(reinterpret_cast<const char*>(out), reply(frame, out));
+            });
+            if (!synced)
+                socket->abort();
+        });
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+    }
+}
+
+int ModbusServer::reply(const Modbus::Frame &frame, uchar *out)
+{
+    ++requests;
+    quint8 function = frame.function;
+    auto fail = [&](quint8 code) { return encodeException(out, frame.transaction, frame.unit, function, code); };
+    if (frame.unit < 1 || frame.unit > units)
+        return fail(TargetFailed);
+    int u = frame.unit - 1;
+
+    switch (function) {
+    case ReadInputRegisters:
+    case ReadHoldingRegisters: {
+        if (frame.pduSize != 5)
+            return fail(IllegalValue);
+        quint16 start = frame.word(1);
+        quint16 count = frame.word(3);
+        if (count < 1 || count > MAXREAD)
+            return fail(IllegalValue);
+        if (start + count > blockSize(function))
+            return fail(IllegalAddress);
+        const quint16 *bank = function == ReadInputRegisters ? inputs.constData() + u * Map::InputCount
+                                                             : holdings.constData() + u * Map::HoldingCount;
+        return encodeReadReply(out, frame.transaction, frame.unit, function, bank + start, count);
+    }
+    case WriteMultipleRegisters: {
+        if (frame.pduSize < 6)
+            return fail(IllegalValue);
+        quint16 start = frame.word(1);
+        quint16 count = frame.word(3);
+        if (count < 1 || frame.pdu[5] != 2 * count || frame.pduSize != 6 + 2 * count)
+            return fail(IllegalValue);
+        if (start + count > Map::HoldingCount)
+            return fail(IllegalAddress);
+        quint16 *bank = holdings.data() + u * Map::HoldingCount;
+        for (int i = 0; i < count; ++i)
+            bank[start + i] = frame.word(6 + 2 * i);
+        return encodeWriteReply(out, frame.transaction, frame.unit, start, count);
+    }
+    default:
+        return fail(IllegalFunction);
+    }
+}
+
+void ModbusServer::drift()
+{
+    QRandomGenerator *rnd = QRandomGenerator::global();
+    for (int u = 1; u <= units; ++u) {
+        quint8 id = quint8(u);
+        /// Включенный кондиционер ведёт температуру к желаемой, выключенный - нет
+        qreal temp = Map::decode(input(id, Map::Temperature));
+        if (holding(id, Map::Power))
+            temp += qBound(-0.1, Map::decode(holding(id, Map::TargetTemp)) - temp, 0.1);
+        else
+            temp += (int(rnd->bounded(3)) - 1) * 0.1;
+        setInput(id, Map::Temperature, Map::encode(qBound(-20.0, temp, 50.0)));
+        qreal humidity = Map::decode(input(id, Map::Humidity)) + (int(rnd->bounded(3)) - 1) * 0.5;
+        setInput(id, Map::Humidity, Map::encode(qBound(20.0, humidity, 80.0)));
+    }
+}
+
+ModbusSensorSource::ModbusSensorSource(const QString &host, quint16 port, quint8 unit)
+    : host(host),
+    port(port),
+    unitId(unit)
+{
+}
+
+bool ModbusSensorSource::start()
+{
+    poller = new ModbusPoller(this);
+    poller->addUnit(host, port, unitId);
+    connect(poller, &ModbusPoller::unitUpdated, this, &ModbusSensorSource::onUnitUpdated);
+    poller->start();
+    return true;
+}
+
+QString ModbusSensorSource::description() const
+{
+    return QString("modbus %1:%2/%3").arg(host).arg(port).arg(unitId);
+}
+
+void ModbusSensorSource::onUnitUpdated(int index, quint8 function)
+{
+    /// Регистры хранения повторяют команды этого же контроллера, в настройки идут только показания
+    if (function != ReadInputRegisters)
+        return;
+    const ModbusPoller::Unit &unit = poller->unit(index);
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    emit sampleReady({SensorSample::Temperature, Map::decode(unit.input[Map::Temperature]), now});
+    emit sampleReady({SensorSample::Humidity, Map::decode(unit.input[Map::Humidity]), now});
+    emit sampleReady({SensorSample::Pressure, Map::decode(unit.input[Map::Pressure]), now});
+}
+
+ModbusDeviceTransport::ModbusDeviceTransport(const QString &host, quint16 port, quint8 unit, QObject *parent)
+    : DeviceTransport(parent),
+    client(new ModbusClient(host, port, this)),
+    unitId(unit)
+{
+    connect(client, &ModbusClient::replied, this, [this](const Modbus::Frame &frame) {
+        quint32 seq = commands.take(frame.transaction);
+        auto it = parts.find(seq);
+        /// Ответ на запись команды, которая уже потеряна
+        if (it == parts.end())
+            return;
+        if (frame.isException())
+            it->rejected = true;
+        /// Команда подтверждается, когда ответили на запись всех её отрезков
+        if (--it->remaining > 0)
+            return;
+        bool rejected = it->rejected;
+        parts.erase(it);
+        emit received(DeviceProtocol::encodeAck(seq, rejected ? DeviceProtocol::Rejected : DeviceProtocol::Ok));
+    }, Qt::DirectConnection);
+    /// Команда без ответа хотя бы на один отрезок будет повторена DeviceLink
+    connect(client, &ModbusClient::timedOut, this, [this](quint16 transaction) {
+        parts.remove(commands.take(transaction));
+    });
+}
+
+bool ModbusDeviceTransport::open()
+{
+    client->open();
+    return true;
+}
+
+void ModbusDeviceTransport::send(const QByteArray &data)
+{
+    /// Поля команды по порядку регистров хранения
+    static constexpr quint8 FIELDS[Map::HoldingCount] = {
+        DeviceProtocol::TargetTemp, DeviceProtocol::AcAngle, DeviceProtocol::Power, DeviceProtocol::Swing
+    };
+    pending.append(data);
+    bool synced = DeviceProtocol::takeFrames(pending, DeviceProtocol::COMMANDSIZE, [this](const uchar *frame) {
+        DeviceCommand command;
+        DeviceCommand::decode(frame, DeviceProtocol::COMMANDSIZE, &command);
+        if (!command.fields || (command.fields & ~DeviceProtocol::AllFields)) {
+            /// Подтверждение не должно прийти внутри DeviceLink::flush(), поэтому через цикл событий
+            QByteArray ack = DeviceProtocol::encodeAck(command.seq, DeviceProtocol::Rejected);
+            QTimer::singleShot(0, this, [this, ack]() { emit received(ack); });
+            return;
+        }
+        quint16 values[Map::HoldingCount] = {
+            Map::encode(command.targetTemp), Map::encode(command.acAngle), quint16(command.power), quint16(command.swing)
+        };
+        /// Пишутся только регистры полей команды: значения остальных полей в команде могут быть устаревшими.
+        /// Каждый отрезок подряд идущих полей - один запрос
+        Parts &part = parts[command.seq];
+        part = Parts();
+        for (int i = 0; i < Map::HoldingCount;) {
+            if (!(command.fields & FIELDS[i])) {
+                ++i;
+                continue;
+            }
+            int first = i;
+            while (i < Map::HoldingCount && (command.fields & FIELDS[i]))
+                ++i;
+            quint16 transaction = client->write(unitId, quint16(first), values + first, i - first);
+            /// Без связи команда теряется, DeviceLink повторит её
+            if (!transaction) {
+                parts.remove(command.seq);
+                return;
+            }
+            commands.insert(transaction, command.seq);
+            ++part.remaining;
+        }
+    });
+    if (!synced)
+        qWarning() << "Modbus device transport: malformed command frame";
+}
+
+QString ModbusDeviceTransport::description() const
+{
+    return "modbus " + client->description() + "/" + QString::number(unitId);
+}
@@ -0,0 +1,574 @@
+/**
+* @file
+* @brief Заголовочный файл обмена с кондиционерами по Modbus TCP
+*
+* Кадры разбираются прямо в приёмном буфере: байты читаются из сокета в заранее выделенный буфер,
+* Modbus::Frame указывает на данные внутри него, регистры читаются из буфера по месту. Запросы
+* собираются на стеке и пишутся в сокет без промежуточных QByteArray.
+*
+* Запросы отправляются конвейером: по одному соединению ожидают ответа до ModbusClient::MAXINFLIGHT
+* транзакций, ответы сопоставляются по номеру транзакции. Всё происходит в цикле событий без ожиданий,
+* поэтому один поток опрашивает сотни кондиционеров.
+*
+* Карта регистров кондиционера (Modbus::Map), значения со знаком умножены на SCALE:
+*
+*     входные регистры:  0 температура (°C), 1 влажность (%), 2 давление (мм рт.ст.)
+*     регистры хранения: 0 желаемая температура (°C), 1 угол заслонки (градусы), 2 питание, 3 качание
+*/
+#ifndef MODBUS_H
+#define MODBUS_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QIODevice>
+#include <QString>
+#include <QVector>
+#include <QtEndian>
+#include <cstring>
+#include "sensorsource.h"
+#include "devicelink.h"
+
+class QTcpSocket;
+class QTcpServer;
+class QTimer;
+
+/// @brief Протокол Modbus TCP
+namespace Modbus {
+/// Стандартный порт
+constexpr quint16 PORT = 502;
+/// Размер заголовка MBAP вместе с номером устройства
+constexpr int HEADERSIZE = 7;
+/// Наибольший размер кадра
+constexpr int MAXFRAME = 260;
+/// Наибольшее количество регистров в одном чтении
+constexpr int MAXREAD = 125;
+/// Наибольшее количество регистров в одной записи (запросы хранятся в очереди без выделений памяти)
+constexpr int MAXWRITE = 16;
+/// Наибольший номер устройства за одним шлюзом
+constexpr int MAXUNITS = 247;
+/// Признак ответа с ошибкой в коде функции
+constexpr quint8 EXCEPTIONFLAG = 0x80;
+
+/// Коды функций
+enum Function : quint8 {
+    ReadHoldingRegisters = 0x03,
+    ReadInputRegisters = 0x04,
+    WriteMultipleRegisters = 0x10
+};
+
+/// Коды ошибок
+enum Exception : quint8 {
+    IllegalFunction = 0x01,
+    IllegalAddress = 0x02,
+    IllegalValue = 0x03,
+    /// Устройство за шлюзом не отвечает
+    TargetFailed = 0x0B
+};
+
+/// @brief Карта регистров кондиционера
+namespace Map {
+/// Множитель значений в регистрах
+constexpr qreal SCALE = 10;
+/// Входные регистры
+enum Input : quint16 {
+    Temperature,
+    Humidity,
+    Pressure,
+    InputCount
+};
+/// Регистры хранения
+enum Holding : quint16 {
+    TargetTemp,
+    AcAngle,
+    Power,
+    Swing,
+    HoldingCount
+};
+/// @brief Значение регистра в базовых единицах
+inline qreal decode(quint16 reg) { return qint16(reg) / SCALE; }
+/// @brief Регистр для значения в базовых единицах
+inline quint16 encode(qreal value) { return quint16(qint16(qBound(-32768, qRound(value * SCALE), 32767))); }
+}
+
+/**
+ * @struct Frame
+ * @brief Разобранный кадр
+ *
+ * Не владеет данными: pdu указывает в приёмный буфер и действителен только в обработчике кадра.
+ */
+struct Frame {
+    /// Номер транзакции
+    quint16 transaction;
+    /// Номер устройства
+    quint8 unit;
+    /// Код функции, у ответа с ошибкой установлен EXCEPTIONFLAG
+    quint8 function;
+    /// PDU: код функции и данные
+    const uchar *pdu;
+    /// Размер PDU
+    int pduSize;
+
+    /// @brief Ответ с ошибкой
+    bool isException() const { return function & EXCEPTIONFLAG; }
+    /// @brief Код ошибки
+    quint8 exceptionCode() const { return pduSize > 1 ? pdu[1] : 0; }
+    /// @brief 16-битное слово PDU по смещению offset
+    quint16 word(int offset) const { return qFromBigEndian<quint16>(pdu + offset); }
+    /// @brief Количество регистров в ответе на чтение
+    int registerCount() const { return pduSize > 1 && pdu[1] == pduSize - 2 ? pdu[1] / 2 : 0; }
+    /// @brief Регистр ответа на чтение
+    quint16 registerAt(int i) const { return word(2 + 2 * i); }
+};
+
+/**
+ * @brief Разбор кадра в начале данных
+ * @param data Данные
+ * @param size Размер данных
+ * @param frame Результат, указывает в data
+ * @return Размер кадра, 0 если кадр ещё не пришёл целиком, -1 если данные не являются кадром Modbus TCP
+ */
+int parseFrame(const uchar *data, int size, Frame *frame);
+
+/// @brief Запрос чтения регистров, возвращает размер кадра (dst не меньше MAXFRAME)
+int encodeRead(uchar *dst, quint16 transaction, quint8 unit, quint8 function, quint16 start, quint16 count);
+/// @brief Запрос записи регистров
+int encodeWrite(uchar *dst, quint16 transaction, quint8 unit, quint16 start, const quint16 *values, int count);
+/// @brief Ответ на чтение регистров
+int encodeReadReply(uchar *dst, quint16 transaction, quint8 unit, quint8 function, const quint16 *values, int count);
+/// @brief Ответ на запись регистров
+int encodeWriteReply(uchar *dst, quint16 transaction, quint8 unit, quint16 start, quint16 count);
+/// @brief Ответ с ошибкой
+int encodeException(uchar *dst, quint16 transaction, quint8 unit, quint8 function, quint8 code);
+
+/**
+ * @brief Разбор адреса кондиционера
+ * @param spec host[:port][/unit], по умолчанию порт PORT и устройство 1
+ * @return false если адрес не распознан
+ */
+bool parseEndpoint(const QString &spec, QString *host, quint16 *port, quint8 *unit);
+
+/**
+ * @class FrameReader
+ * @brief Приёмный буфер с разбором кадров на месте
+ *
+ * Буфер выделяется один раз. После разбора в начало переносится только недошедший хвост
+ * (меньше MAXFRAME байт), поэтому место для чтения есть всегда.
+ */
+class FrameReader
+{
+public:
+    /// Размер буфера
+    static constexpr int BUFFERSIZE = 64 * 1024;
+
+    FrameReader() : buffer(BUFFERSIZE, Qt::Uninitialized) {}
+    /// @brief Сброс недоразобранных данных (при переподключении)
+    void reset() { filled = 0; }
+    /**
+     * @brief Чтение всех доступных байтов и разбор кадров
+     * @param device Источник
+     * @param handle Обработчик кадра void(const Frame&)
+     * @return false если поток рассинхронизирован (данные отброшены)
+     */
+    template<typename Handler>
+    bool read(QIODevice *device, Handler handle)
+    {
+        for (;;) {
+            qint64 n = device->read(buffer.data() + filled, BUFFERSIZE - filled);
+            if (n <= 0)
+                return true;
+            filled += int(n);
+            const uchar *data = reinterpret_cast<const uchar*>(buffer.constData());
+            int offset = 0;
+            Frame frame;
+            int used;
+            while ((used = parseFrame(data + offset, filled - offset, &frame)) > 0) {
+                handle(frame);
+                offset += used;
+            }
+            if (used < 0) {
+                filled = 0;
+                return false;
+            }
+            filled -= offset;
+            if (offset && filled)
+                std::memmove(buffer.data(), buffer.constData() + offset, size_t(filled));
+        }
+    }
+
+private:
+    /// Буфер
+    QByteArray buffer;
+    /// Заполненная часть буфера
+    int filled = 0;
+};
+}
+
+/**
+ * @class ModbusClient
+ * @brief Соединение с кондиционером или шлюзом Modbus TCP
+ *
+ * Запросы сверх MAXINFLIGHT ждут в очереди. Без связи запросы не принимаются, при обрыве все
+ * ожидающие запросы завершаются сигналом timedOut(), соединение восстанавливается раз в RECONNECT мс.
+ */
+class ModbusClient : public QObject
+{
+    Q_OBJECT
+public:
+    /// Наибольшее количество транзакций, ожидающих ответа
+    static constexpr int MAXINFLIGHT = 32;
+    /// Время ожидания ответа, мс
+    static constexpr int TIMEOUT = 1000;
+    /// Интервал переподключения, мс
+    static constexpr int RECONNECT = 1000;
+
+    /**
+     * @param host Адрес
+     * @param port Порт
+     * @param parent Родительский объект
+     */
+    ModbusClient(const QString &host, quint16 port, QObject *parent = nullptr);
+    /// @brief Подключение, асинхронное
+    void open();
+    /// @brief Соединение установлено
+    bool isConnected() const;
+    /**
+     * @brief Чтение регистров
+     * @param unit Номер устройства
+     * @param function ReadHoldingRegisters или ReadInputRegisters
+     * @param start Первый регистр
+     * @param count Количество регистров, не больше MAXREAD
+     * @return Номер транзакции, 0 если нет связи
+     */
+    quint16 read(quint8 unit, Modbus::Function function, quint16 start, quint16 count);
+    /**
+     * @brief Запись регистров
+     * @param count Количество регистров, не больше MAXWRITE
+     * @return Номер транзакции, 0 если нет связи
+     */
+    quint16 write(quint8 unit, quint16 start, const quint16 *values, int count);
+    /// @brief Количество запросов, ожидающих ответа или отправки
+    int pendingCount() const { return inFlight + queue.size() - queueHead; }
+    /// @brief Описание соединения для сообщений в журнал
+    QString description() const;
+
+signals:
+    /// @brief Подключение установлено
+    void connected();
+    /**
+     * @brief Получен ответ
+     *
+     * Кадр указывает в приёмный буфер, поэтому соединение должно быть прямым
+     */
+    void replied(const Modbus::Frame &frame);
+    /// @brief Ответ не получен за TIMEOUT или соединение оборвалось
+    void timedOut(quint16 transaction, quint8 unit, quint8 function);
+
+private:
+    /// @brief Транзакция, ожидающая ответа
+    struct Slot {
+        quint16 transaction = 0;
+        quint8 unit = 0;
+        quint8 function = 0;
+        /// Время отправки, мс по clock
+        qint64 sent = 0;
+    };
+    /// @brief Запрос в очереди
+    struct Request {
+        Slot slot;
+        quint8 size;
+        uchar frame[Modbus::HEADERSIZE + 6 + 2 * Modbus::MAXWRITE];
+    };
+
+    /// Адрес
+    QString host;
+    /// Порт
+    quint16 port;
+    /// Сокет
+    QTcpSocket *socket;
+    /// Таймер переподключения
+    QTimer *reconnect;
+    /// Таймер проверки ответов
+    QTimer *timeoutCheck;
+    /// Часы отправки
+    QElapsedTimer clock;
+    /// Приёмный буфер
+    Modbus::FrameReader reader;
+    /// Транзакции, ожидающие ответа
+    Slot window[MAXINFLIGHT];
+    /// Количество занятых слотов
+    int inFlight = 0;
+    /// Очередь запросов сверх MAXINFLIGHT
+    QVector<Request> queue;
+    /// Начало очереди
+    int queueHead = 0;
+    /// Номер следующей транзакции
+    quint16 nextTransaction = 1;
+
+    /// @brief Отправка запроса или постановка в очередь
+    quint16 submit(const Request &request);
+    /// @brief Отправка запроса в свободный слот
+    void send(const Request &request);
+    /// @brief Отправка запросов из очереди в освободившиеся слоты
+    void pump();
+    /// @brief Разбор пришедших ответов
+    void onReadyRead();
+    /// @brief Проверка транзакций без ответа
+    void checkTimeouts();
+    /// @brief Завершение всех ожидающих запросов при обрыве
+    void failAll();
+};
+
+/**
+ * @struct ModbusPollStats
+ * @brief Счётчики опроса
+ */
+struct ModbusPollStats {
+    /// Начатые циклы опроса
+    quint64 cycles = 0;
+    /// Отправленные запросы
+    quint64 requests = 0;
+    /// Ответы с данными
+    quint64 replies = 0;
+    /// Ответы с ошибкой
+    quint64 exceptions = 0;
+    /// Запросы без ответа
+    quint64 timeouts = 0;
+    /// Блоки, пропущенные в цикле, так как предыдущий запрос ещё ждёт ответа или нет связи
+    quint64 skipped = 0;
+};
+
+/**
+ * @class ModbusPoller
+ * @brief Периодический опрос кондиционеров
+ *
+ * Каждый цикл у каждого кондиционера читаются блок входных регистров и блок регистров хранения.
+ * Запросы ко всем кондиционерам уходят сразу, ответы приходят в любом порядке. Кондиционеры за одним
+ * адресом используют общее соединение.
+ */
+class ModbusPoller : public QObject
+{
+    Q_OBJECT
+public:
+    /// Интервал опроса по умолчанию, мс
+    static constexpr int INTERVAL = 1000;
+    /// Запросов без ответа подряд, после которых кондиционер считается недоступным
+    static constexpr int MAXMISSES = 3;
+
+    /**
+     * @struct Unit
+     * @brief Последние прочитанные регистры кондиционера
+     */
+    struct Unit {
+        /// Номер устройства
+        quint8 id = 0;
+        /// Индекс соединения
+        int endpoint = 0;
+        /// Входные регистры
+        quint16 input[Modbus::Map::InputCount] = {};
+        /// Регистры хранения
+        quint16 holding[Modbus::Map::HoldingCount] = {};
+        /// Блоки, ожидающие ответа (1 - входные, 2 - хранения)
+        quint8 pending = 0;
+        /// Блоки, прочитанные хотя бы раз
+        quint8 valid = 0;
+        /// Запросы без ответа подряд
+        int misses = 0;
+
+        /// @brief Кондиционер на связи
+        bool online() const { return valid && misses < MAXMISSES; }
+    };
+
+    explicit ModbusPoller(QObject *parent = nullptr);
+    /**
+     * @brief Добавление кондиционера
+     * @return Индекс кондиционера
+     */
+    int addUnit(const QString &host, quint16 port, quint8 id);
+    /// @brief Интервал опроса, мс
+    void setInterval(int ms);
+    /// @brief Подключение и запуск периодического опроса
+    void start();
+    /// @brief Остановка опроса
+    void stop();
+    /// @brief Один цикл опроса
+    void poll();
+    /// @brief Все соединения установлены
+    bool isConnected() const;
+    /// @brief Количество кондиционеров
+    int unitCount() const { return units.size(); }
+    /// @brief Регистры кондиционера
+    const Unit &unit(int index) const { return units[index]; }
+    /// @brief Количество запросов, ожидающих ответа
+    int outstandingCount() const { return outstanding; }
+    /// @brief Счётчики
+    const ModbusPollStats &stats() const { return counters; }
+
+signals:
+    /**
+     * @brief Прочитан блок регистров кондиционера
+     * @param index Индекс кондиционера
+     * @param function ReadInputRegisters или ReadHoldingRegisters
+     */
+    void unitUpdated(int index, quint8 function);
+    /// @brief На все запросы цикла пришли ответы или истекло время ожидания
+    void cycleFinished();
+
+private:
+    /// @brief Соединение и кондиционеры за ним
+    struct Endpoint {
+        ModbusClient *client;
+        /// Индекс кондиционера по номеру устройства, -1 если нет
+        QVector<int> units;
+    };
+
+    /// Соединения
+    QVector<Endpoint> endpoints;
+    /// Индекс соединения по адресу host:port
+    QHash<QString, int> endpointIndex;
+    /// Кондиционеры
+    QVector<Unit> units;
+    /// Таймер опроса
+    QTimer *timer;
+    /// Время с начала цикла
+    QElapsedTimer cycleClock;
+    /// Запросы, ожидающие ответа
+    int outstanding = 0;
+    /// Счётчики
+    ModbusPollStats counters;
+
+    /// @brief Запрос блока регистров кондиционера
+    void request(Unit &unit, quint8 function);
+    /// @brief Ответ от соединения
+    void onReplied(int endpoint, const Modbus::Frame &frame);
+    /// @brief Запрос без ответа
+    void onTimedOut(int endpoint, quint8 id, quint8 function);
+    /// @brief Завершение запроса, конец цикла после последнего
+    void finishRequest();
+};
+
+/**
+ * @class ModbusServer
+ * @brief Встроенный имитатор кондиционеров Modbus TCP
+ *
+ * Отвечает за устройства 1..units на 127.0.0.1, как шлюз. Температура, влажность и давление медленно
+ * меняются, регистры хранения запоминают записанные значения. Используется для проверки без
+ * настоящих кондиционеров и в бенчмарке.
+ */
+class ModbusServer : public QObject
+{
+    Q_OBJECT
+public:
+    /// Интервал изменения показаний, мс
+    static constexpr int DRIFTINTERVAL = 1000;
+
+    /**
+     * @param units Количество устройств, не больше MAXUNITS
+     * @param parent Родительский объект
+     */
+    explicit ModbusServer(int units = 1, QObject *parent = nullptr);
+    /**
+     * @brief Запуск сервера
+     * @param port Порт, 0 - любой свободный
+     */
+    bool listen(quint16 port = 0);
+    /// @brief Порт сервера
+    quint16 port() const;
+    /// @brief Количество устройств
+    int unitCount() const { return units; }
+    /// @brief Входной регистр устройства
+    quint16 input(quint8 unit, int reg) const { return inputs[(unit - 1) * Modbus::Map::InputCount + reg]; }
+    /// @brief Установка входного регистра устройства
+    void setInput(quint8 unit, int reg, quint16 value) { inputs[(unit - 1) * Modbus::Map::InputCount + reg] = value; }
+    /// @brief Регистр хранения устройства
+    quint16 holding(quint8 unit, int reg) const { return holdings[(unit - 1) * Modbus::Map::HoldingCount + reg]; }
+    /// @brief Количество обработанных запросов
+    quint64 requestCount() const { return requests; }
+
+private:
+    /// Количество устройств
+    int units;
+    /// Сервер
+    QTcpServer *server;
+    /// Входные регистры всех устройств подряд
+    QVector<quint16> inputs;
+    /// Регистры хранения всех устройств подряд
+    QVector<quint16> holdings;
+    /// Количество обработанных запросов
+    quint64 requests = 0;
+
+    /// @brief Приём новых подключений
+    void acceptConnections();
+    /// @brief Ответ на запрос
+    int reply(const Modbus::Frame &frame, uchar *out);
+    /// @brief Изменение показаний
+    void drift();
+};
+
+/**
+ * @class ModbusSensorSource
+ * @brief Температура, влажность и давление из входных регистров кондиционера
+ */
+class ModbusSensorSource : public SensorSource
+{
+    Q_OBJECT
+public:
+    /// @param host Адрес, port Порт, unit Номер устройства
+    ModbusSensorSource(const QString &host, quint16 port, quint8 unit);
+    bool start() override;
+    QString description() const override;
+
+private:
+    /// Адрес
+    QString host;
+    /// Порт
+    quint16 port;
+    /// Номер устройства
+    quint8 unitId;
+    /// Опрос, создаётся в рабочем потоке
+    ModbusPoller *poller = nullptr;
+    /// @brief Выдача отсчётов из прочитанных регистров
+    void onUnitUpdated(int index, quint8 function);
+};
+
+/**
+ * @class ModbusDeviceTransport
+ * @brief Команды DeviceLink как запись регистров хранения
+ *
+ * Записываются только регистры полей команды: каждый отрезок подряд идущих полей - один запрос
+ * WriteMultipleRegisters. Ответы на все запросы команды превращаются в подтверждение DeviceLink,
+ * ответ с ошибкой хотя бы на один - в отказ.
+ */
+class ModbusDeviceTransport : public DeviceTransport
+{
+    Q_OBJECT
+public:
+    /// @param host Адрес, port Порт, unit Номер устройства
+    ModbusDeviceTransport(const QString &host, quint16 port, quint8 unit, QObject *parent = nullptr);
+    bool open() override;
+    void send(const QByteArray &data) override;
+    QString description() const override;
+
+private:
+    /// @brief Запись команды, ожидающая ответов
+    struct Parts {
+        /// Отрезки без ответа
+        int remaining = 0;
+        /// На запись отрезка пришёл ответ с ошибкой
+        bool rejected = false;
+    };
+
+    /// Соединение
+    ModbusClient *client;
+    /// Номер устройства
+    quint8 unitId;
+    /// Номер команды по номеру транзакции
+    QHash<quint16, quint32> commands;
+    /// Записи команд по номеру команды
+    QHash<quint32, Parts> parts;
+    /// Недоразобранный хвост команд
+    QByteArray pending;
+};
+
+#endif // MODBUS_H
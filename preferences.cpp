@@ -1,9 +1,258 @@
 #include "preferences.h"
+#include "metrics.h"
 #include <QFile>
+#include <QSaveFile>
+#include <cstring>
+#include <cmath>
+#include <array>
 #include <QXmlStreamReader>
 #include <QXmlStreamWriter>
 
-Preferences::Preferences()
+/**
+ * @struct PrefsField
+ * @brief Описание одного поля настроек
+ *
+ * Поле связывает свойство Preferences, элемент XML и поле бинарного снимка.
+ * Используется только указатель на член, соответствующий типу поля.
+ */
+struct PrefsField {
+    /// Тип значения
+    enum Type : quint8 { Real, Int, Bool, Choice };
+    /// Величина, в которой задано значение и границы
+    enum Unit : quint8 { NoUnit, Temperature, Pressure, Percent, Degrees, Pixels };
+
+    /// Имя элемента XML
+    const char *name;
+    /// Тип значения
+    Type type;
+    /// Величина
+    Unit unit;
+    /// Значение по умолчанию (для Choice - индекс варианта)
+    qreal defaultValue;
+    /// Есть ли у поля границы
+    bool limited;
+    /// Минимальное значение в базовых единицах
+    qreal min;
+    /// Максимальное значение в базовых единицах
+    qreal max;
+    /// Свойство типа Real
+    qreal Preferences::*real;
+    /// Свойство типа Int
+    int Preferences::*integer;
+    /// Свойство типа Bool
+    bool Preferences::*flag;
+    /// Чтение индекса варианта для Choice
+    int (*getChoice)(const Preferences &);
+    /// Запись индекса варианта для Choice
+    void (*setChoice)(Preferences &, int);
+    /// Поле снимка для Real
+    double PrefsSnapshot::*snapReal;
+    /// Поле снимка для Int
+    qint32 PrefsSnapshot::*snapInt;
+    /// Поле снимка для Bool и Choice
+    quint8 PrefsSnapshot::*snapByte;
+    /// Свойство, в которое setLimits() записывает минимум в текущих единицах
+    qreal Preferences::*minMember;
+    /// Свойство, в которое setLimits() записывает максимум в текущих единицах
+    qreal Preferences::*maxMember;
+    /// Обозначения вариантов для Choice, индекс - код варианта в снимке
+    const char *const *choices;
+    /// Количество вариантов
+    int choiceCount;
+};
+
+namespace {
+/// @brief Поле с вещественным значением
+constexpr PrefsField realField(const char *name, PrefsField::Unit unit, qreal def, qreal Preferences::*member, double PrefsSnapshot::*snap,
+                               bool limited = false, qreal min = 0, qreal max = 0,
+                               qreal Preferences::*minMember = nullptr, qreal Preferences::*maxMember = nullptr)
+{
+    return { name, PrefsField::Real, unit, def, limited, min, max, member, nullptr, nullptr, nullptr, nullptr,
+             snap, nullptr, nullptr, minMember, maxMember, nullptr, 0 };
+}
+/// @brief Поле с целым значением
+constexpr PrefsField intField(const char *name, PrefsField::Unit unit, int def, int Preferences::*member, qint32 PrefsSnapshot::*snap)
+{
+    return { name, PrefsField::Int, unit, qreal(def), false, 0, 0, nullptr, member, nullptr, nullptr, nullptr,
+             nullptr, snap, nullptr, nullptr, nullptr, nullptr, 0 };
+}
+/// @brief Поле с логическим значением
+constexpr PrefsField boolField(const char *name, bool def, bool Preferences::*member, quint8 PrefsSnapshot::*snap)
+{
+    return { name, PrefsField::Bool, PrefsField::NoUnit, def ? 1.0 : 0.0, false, 0, 0, nullptr, nullptr, member, nullptr, nullptr,
+             nullptr, nullptr, snap, nullptr, nullptr, nullptr, 0 };
+}
+/// @brief Чтение единицы измерения как индекса варианта
+template<typename Unit, Unit Preferences::*member>
+int getUnit(const Preferences &prefs) { return int(prefs.*member); }
+/// @brief Запись единицы измерения по индексу варианта
+template<typename Unit, Unit Preferences::*member>
+void setUnit(Preferences &prefs, int index) { prefs.*member = Unit(index); }
+/// @brief Поле с выбором единицы измерения, варианты - обозначения единиц
+template<typename Unit, Unit Preferences::*member>
+constexpr PrefsField unitField(const char *name, Unit def, quint8 PrefsSnapshot::*snap)
+{
+    return { name, PrefsField::Choice, PrefsField::NoUnit, qreal(int(def)), false, 0, 0, nullptr, nullptr, nullptr,
+             &getUnit<Unit, member>, &setUnit<Unit, member>,
+             nullptr, nullptr, snap, nullptr, nullptr, Units::UnitTraits<Unit>::SYMBOLS, Units::UnitTraits<Unit>::COUNT };
+}
+
+/// @brief FNV-1a с затравкой
+constexpr quint32 fnv1a(const char *name, quint32 seed)
+{
+    quint32 h = 2166136261u ^ seed;
+    for (; *name; ++name) {
+        h ^= quint8(*name);
+        h *= 16777619u;
+    }
+    return h;
+}
+/// @brief FNV-1a с затравкой для имени из XML, имена полей содержат только ASCII
+quint32 fnv1a(const QStringRef &name, quint32 seed)
+{
+    quint32 h = 2166136261u ^ seed;
+    for (QChar c : name) {
+        h ^= quint8(c.unicode());
+        h *= 16777619u;
+    }
+    return h;
+}
+}
+
+/**
+ * @struct PrefsSchema
+ * @brief Реестр полей настроек
+ *
+ * Каждое поле описывается один раз. По реестру строятся значения по умолчанию, границы,
+ * загрузка и сохранение XML и бинарного снимка.
+ */
+struct PrefsSchema {
+    /// Поля настроек в порядке записи в XML
+    static constexpr PrefsField fields[] = {
+        realField("TempVal", PrefsField::Temperature, 20.0, &Preferences::tempVal, &PrefsSnapshot::tempVal,
+                  true, Preferences::TEMPMIN_C, Preferences::TEMPMAX_C, &Preferences::tempMin, &Preferences::tempMax),
+        realField("HumidityVal", PrefsField::Percent, 45.0, &Preferences::humidityVal, &PrefsSnapshot::humidityVal,
+                  true, Preferences::HUMIDITYMIN, Preferences::HUMIDITYMAX, &Preferences::humidityMin, &Preferences::humidityMax),
+        realField("PressureVal", PrefsField::Pressure, 760.0, &Preferences::pressureVal, &PrefsSnapshot::pressureVal,
+                  true, Preferences::PRESSUREMIN_MM, Preferences::PRESSUREMAX_MM, &Preferences::pressureMin, &Preferences::pressureMax),
+        unitField<Units::TempUnit, &Preferences::tempUnit>("TempUnit", Units::TempUnit::Celsius, &PrefsSnapshot::tempUnit),
+        unitField<Units::PressureUnit, &Preferences::pressureUnit>("PressureUnit", Units::PressureUnit::Pascal, &PrefsSnapshot::pressureUnit),
+        realField("TargetTemp", PrefsField::Temperature, 20.0, &Preferences::targetTemp, &PrefsSnapshot::targetTemp,
+                  true, Preferences::TEMPMIN_C, Preferences::TEMPMAX_C),
+        realField("AcAngle", PrefsField::Degrees, 0.0, &Preferences::acAngle, &PrefsSnapshot::acAngle,
+                  true, Preferences::ACANGLEMIN, Preferences::ACANGLEMAX),
+        intField("ResolutionW", PrefsField::Pixels, 800, &Preferences::resolutionW, &PrefsSnapshot::resolutionW),
+        intField("ResolutionH", PrefsField::Pixels, 600, &Preferences::resolutionH, &PrefsSnapshot::resolutionH),
+        boolField("DarkTheme", true, &Preferences::darkTheme, &PrefsSnapshot::darkTheme),
+        boolField("Power", true, &Preferences::power, &PrefsSnapshot::power),
+        boolField("Swing", false, &Preferences::swing, &PrefsSnapshot::swing),
+    };
+
+    /**
+     * @brief Перевод значения из базовых единиц в текущие единицы настроек
+     * @param prefs Пользовательские настройки
+     * @param unit Величина
+     * @param val Значение в базовых единицах (°C, мм рт.ст.)
+     */
+    static qreal fromBase(const Preferences &prefs, PrefsField::Unit unit, qreal val)
+    {
+        if (unit == PrefsField::Temperature)
+            return Units::fromBase(prefs.tempUnit).apply(val);
+        if (unit == PrefsField::Pressure)
+            return Units::fromBase(prefs.pressureUnit).apply(val);
+        return val;
+    }
+    /// @brief Установка значения по умолчанию
+    static void setDefault(Preferences &prefs, const PrefsField &field)
+    {
+        switch (field.type) {
+        case PrefsField::Real: prefs.*field.real = field.defaultValue; break;
+        case PrefsField::Int: prefs.*field.integer = int(field.defaultValue); break;
+        case PrefsField::Bool: prefs.*field.flag = field.defaultValue != 0; break;
+        case PrefsField::Choice: field.setChoice(prefs, int(field.defaultValue)); break;
+        }
+    }
+    /**
+     * @brief Ограничение загруженных значений границами полей
+     *
+     * Вызывается после загрузки всех полей, когда единицы измерения уже известны.
+     * Испорченное (не конечное) значение заменяется значением по умолчанию.
+     */
+    static void clampLoaded(Preferences &prefs)
+    {
+        for (const PrefsField &field : fields) {
+            if (field.type != PrefsField::Real || !field.limited)
+                continue;
+            qreal &val = prefs.*field.real;
+            if (!std::isfinite(val))
+                val = fromBase(prefs, field.unit, field.defaultValue);
+            val = qBound(fromBase(prefs, field.unit, field.min), val, fromBase(prefs, field.unit, field.max));
+        }
+    }
+};
+
+namespace {
+/// Количество полей
+constexpr int FIELDCOUNT = int(sizeof(PrefsSchema::fields) / sizeof(PrefsSchema::fields[0]));
+/// Размер хеш-таблицы имён, степень двойки
+constexpr int HASHSIZE = 32;
+static_assert(FIELDCOUNT <= HASHSIZE / 2, "Too many preference fields for the name table, increase HASHSIZE");
+
+/// @brief Подбор затравки, при которой имена всех полей попадают в разные ячейки
+constexpr quint32 findSeed()
+{
+    for (quint32 seed = 0; seed < 4096; ++seed) {
+        bool used[HASHSIZE] = {};
+        bool ok = true;
+        for (int i = 0; i < FIELDCOUNT && ok; ++i) {
+            quint32 slot = fnv1a(PrefsSchema::fields[i].name, seed) & (HASHSIZE - 1);
+            ok = !used[slot];
+            used[slot] = true;
+        }
+        if (ok)
+            return seed;
+    }
+    return ~0u;
+}
+/// Затравка совершенного хеша имён полей
+constexpr quint32 SEED = findSeed();
+static_assert(SEED != ~0u, "No collision-free seed for preference field names");
+
+/// @brief Построение таблицы: ячейка -> индекс поля или -1
+constexpr std::array<qint8, HASHSIZE> makeTable()
+{
+    std::array<qint8, HASHSIZE> table{};
+    for (int i = 0; i < HASHSIZE; ++i)
+        table[i] = -1;
+    for (int i = 0; i < FIELDCOUNT; ++i)
+        table[fnv1a(PrefsSchema::fields[i].name, SEED) & (HASHSIZE - 1)] = qint8(i);
+    return table;
+}
+/// Совершенная хеш-таблица имён полей, строится при компиляции
+constexpr std::array<qint8, HASHSIZE> fieldTable = makeTable();
+
+/// @brief Поиск поля по имени элемента XML за постоянное время, nullptr если такого поля нет
+const PrefsField *findField(const QStringRef &name)
+{
+    int index = fieldTable[fnv1a(name, SEED) & (HASHSIZE - 1)];
+    /// В ячейку может попасть и неизвестное имя, поэтому имя сверяется
+    if (index < 0 || name != QLatin1String(PrefsSchema::fields[index].name))
+        return nullptr;
+    return &PrefsSchema::fields[index];
+}
+
+/// @brief Индекс варианта по его обозначению, -1 если такого варианта нет
+int choiceIndex(const PrefsField &field, const QString &text)
+{
+    for (int i = 0; i < field.choiceCount; ++i)
+        if (text == QString::fromUtf8(field.choices[i]))
+            return i;
+    return -1;
+}
+}
+
+Preferences::Preferences(QObject *parent)
+    : QObject(parent)
 {
     /// В конструкторе происходит только инициализация значений
     initValues();
@@ -11,148 +260,288 @@ Preferences::Preferences()
 /// Устанавливаются значения по умолчанию, которые потом поменяются при загрузке данных из .xml (кроме первого запуска)
 void Preferences::initValues()
 {
-    tempVal = 20.0;
-    humidityVal = 45.0;
-    pressureVal = 760.0;
-    tempUnit = "°C";
-    pressureUnit = "Pa";
-    targetTemp = 20.0;
-    acAngle = 0.0;
-    resolution = QSize(800,600);
-    darkTheme = true;
-    power = true;
-    tempMin = -40;
-    tempMax = 60;
-    humidityMin = 0;
-    humidityMax = 100;
-    pressureMin = 500;
-    pressureMax = 900;
+    for (const PrefsField &field : PrefsSchema::fields)
+        PrefsSchema::setDefault(*this, field);
+    setLimits();
 }
 
 void Preferences::setLimits()
 {
-    /// Минимальная температура в цельсиях
-    tempMin = -40;
-    tempMax = 60;
-
-    /// Затем температура меняется в зависимости от единиц измерения
-    if (tempUnit == "°F") {
-        tempMin = (tempMin * 9 / 5) + 32;
-        tempMax = (tempMax * 9 / 5) + 32;
-    } else if (tempUnit == "°K") {
-        tempMin += 273.15;
-        tempMax += 273.15;
+    /// Границы хранятся в базовых единицах и переводятся в текущие единицы измерения
+    bool updated = false;
+    for (const PrefsField &field : PrefsSchema::fields) {
+        if (field.minMember) {
+            qreal min = PrefsSchema::fromBase(*this, field.unit, field.min);
+            updated |= (this->*field.minMember != min);
+            this->*field.minMember = min;
+        }
+        if (field.maxMember) {
+            qreal max = PrefsSchema::fromBase(*this, field.unit, field.max);
+            updated |= (this->*field.maxMember != max);
+            this->*field.maxMember = max;
+        }
     }
+    if (updated)
+        markChanged(LimitsField);
+}
 
-    /// Минимальное давление в мм рт.ст.
-    pressureMin = 500;
-    pressureMax = 900;
-    /// Затем давление меняется в зависимости от единиц измерения
-    if (pressureUnit == "Pa") {
-        pressureMin *= 133.322;
-        pressureMax *= 133.322;
+void Preferences::markChanged(quint32 fields)
+{
+    dirty |= fields;
+    /// Вне транзакции изменение применяется сразу, как транзакция из одного поля
+    if (depth == 0) {
+        ++depth;
+        commit();
     }
 }
 
+void Preferences::commit()
+{
+    if (--depth > 0 || dirty == 0)
+        return;
+    quint32 fields = dirty;
+    dirty = 0;
+    /// Обработчики могут менять настройки, их изменения соберутся в отдельный пакет
+    Transaction nested(this);
+    if (fields & TempValField)
+        emit tempValChanged(tempVal);
+    if (fields & HumidityValField)
+        emit humidityValChanged(humidityVal);
+    if (fields & PressureValField)
+        emit pressureValChanged(pressureVal);
+    if (fields & TempUnitField)
+        emit tempUnitChanged(tempUnit);
+    if (fields & PressureUnitField)
+        emit pressureUnitChanged(pressureUnit);
+    if (fields & TargetTempField)
+        emit targetTempChanged(targetTemp);
+    if (fields & AcAngleField)
+        emit acAngleChanged(acAngle);
+    if (fields & ResolutionField)
+        emit resolutionChanged(getResolution());
+    if (fields & ThemeField)
+        emit themeChanged(darkTheme);
+    if (fields & PowerField)
+        emit powerChanged(power);
+    if (fields & LimitsField)
+        emit limitsChanged();
+    if (fields & SwingField)
+        emit swingChanged(swing);
+    emit changed(fields);
+}
+
+void Preferences::setTempValCelsius(qreal val)
+{
+    setTempVal(PrefsSchema::fromBase(*this, PrefsField::Temperature, val));
+}
+
+void Preferences::setPressureValMmHg(qreal val)
+{
+    setPressureVal(PrefsSchema::fromBase(*this, PrefsField::Pressure, val));
+}
+
+void Preferences::changeTempUnit(Units::TempUnit to)
+{
+    if (to == tempUnit)
+        return;
+    /// Коэффициенты перевода берутся из таблицы, одно преобразование на оба значения
+    Units::Affine conv = Units::conversion(tempUnit, to);
+    /// Все поля меняются одним пакетом, каждый подписчик получит по одному сигналу
+    Transaction transaction(this);
+    setTempVal(conv.apply(tempVal));
+    setTargetTemp(conv.apply(targetTemp));
+    setTempUnit(to);
+    setLimits();
+}
+
+void Preferences::changePressureUnit(Units::PressureUnit to)
+{
+    if (to == pressureUnit)
+        return;
+    Transaction transaction(this);
+    setPressureVal(Units::convert(pressureVal, pressureUnit, to));
+    setPressureUnit(to);
+    setLimits();
+}
+
 void Preferences::setResolution()
 {
-    /// Переключение между двумя разрешениями окна
-    if (resolution.width() == 800 && resolution.height() == 600) {
-        resolution.setWidth(1024);
-        resolution.setHeight(768);
-    } else {
-        resolution.setWidth(800);
-        resolution.setHeight(600);
+    /// Следующее стандартное разрешение после текущего. Если текущее нестандартное, выбирается первое большее по площади.
+    QSize current = getResolution();
+    int next = 0;
+    for (int i = 0; i < RESOLUTIONCOUNT; ++i) {
+        if (RESOLUTIONS[i] == current) {
+            next = (i + 1) % RESOLUTIONCOUNT;
+            break;
+        }
+        if (RESOLUTIONS[i].width() * RESOLUTIONS[i].height() > current.width() * current.height()) {
+            next = i;
+            break;
+        }
     }
+    setResolution(RESOLUTIONS[next]);
+}
+
+void Preferences::setResolution(const QSize &res)
+{
+    int w = qMax(res.width(), MIN_RESOLUTION.width());
+    int h = qMax(res.height(), MIN_RESOLUTION.height());
+    if (w == resolutionW && h == resolutionH)
+        return;
+    resolutionW = w;
+    resolutionH = h;
+    markChanged(ResolutionField);
+}
+
+PrefsSnapshot Preferences::toSnapshot(quint64 sequence) const
+{
+    PrefsSnapshot snapshot;
+    snapshot.sequence = sequence;
+    for (const PrefsField &field : PrefsSchema::fields) {
+        switch (field.type) {
+        case PrefsField::Real: snapshot.*field.snapReal = this->*field.real; break;
+        case PrefsField::Int: snapshot.*field.snapInt = this->*field.integer; break;
+        case PrefsField::Bool: snapshot.*field.snapByte = this->*field.flag; break;
+        case PrefsField::Choice: snapshot.*field.snapByte = quint8(field.getChoice(*this)); break;
+        }
+    }
+    snapshot.seal();
+    return snapshot;
+}
+
+void Preferences::fromSnapshot(const PrefsSnapshot &snapshot)
+{
+    /// Значения записываются напрямую, подписчики получают по одному сигналу на поле
+    Transaction transaction(this);
+    markChanged(AllFields & ~LimitsField);
+    for (const PrefsField &field : PrefsSchema::fields) {
+        switch (field.type) {
+        case PrefsField::Real: this->*field.real = snapshot.*field.snapReal; break;
+        case PrefsField::Int: this->*field.integer = snapshot.*field.snapInt; break;
+        case PrefsField::Bool: this->*field.flag = snapshot.*field.snapByte != 0; break;
+        case PrefsField::Choice: {
+            /// Неизвестные коды вариантов заменяются значением по умолчанию
+            int index = snapshot.*field.snapByte;
+            if (index >= field.choiceCount)
+                index = int(field.defaultValue);
+            field.setChoice(*this, index);
+            break;
+        }
+        }
+    }
+    PrefsSchema::clampLoaded(*this);
+}
+
+bool Preferences::loadSnapshot(const QString &filename, quint64 *sequence)
+{
+    METRICS_SCOPE(PrefsLoad);
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    /// Файл другого размера не может быть снимком текущей версии
+    if (file.size() != qint64(sizeof(PrefsSnapshot)))
+        return false;
+    const uchar *data = file.map(0, sizeof(PrefsSnapshot));
+    if (!data)
+        return false;
+    /// Отображение может быть не выровнено под double, поэтому снимок копируется целиком
+    PrefsSnapshot snapshot;
+    std::memcpy(&snapshot, data, sizeof(PrefsSnapshot));
+    file.unmap(const_cast<uchar*>(data));
+    if (!snapshot.isValid())
+        return false;
+    fromSnapshot(snapshot);
+    if (sequence)
+        *sequence = snapshot.sequence;
+    return true;
+}
+
+bool Preferences::saveSnapshot(const QString &filename) const
+{
+    return writeSnapshot(filename, toSnapshot());
+}
+
+bool Preferences::writeSnapshot(const QString &filename, const PrefsSnapshot &snapshot)
+{
+    METRICS_SCOPE(PrefsSave);
+    QSaveFile file(filename);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    if (file.write(reinterpret_cast<const char*>(&snapshot), sizeof(PrefsSnapshot)) != qint64(sizeof(PrefsSnapshot))) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
 }
 
 bool Preferences::load(const QString &filename)
 {
+    METRICS_SCOPE(PrefsLoad);
     /// Открытие файла
     QFile file(filename);
     /// Если файл не открылся, загрузка не происходит
     if (!file.open(QIODevice::ReadOnly))
         return false;
     QXmlStreamReader xml(&file);
+    Transaction transaction(this);
+    markChanged(AllFields & ~LimitsField);
     /// Чтение xml файла
     while (!xml.atEnd() && !xml.hasError()) {
         xml.readNext();
-        /// Значения из xml файла записываются в объект класса Preferences
-        if (xml.isStartElement()) {
-            /// Внешняя температура
-            if (xml.name() == "TempVal")
-                setTempVal(xml.readElementText().toDouble());
-            /// Внешняя влажность
-            else if (xml.name() == "HumidityVal")
-                setHumidityVal(xml.readElementText().toDouble());
-            /// Внешнее давление
-            else if (xml.name() == "PressureVal")
-                setPressureVal(xml.readElementText().toDouble());
-            /// Единицы измерения температуры
-            else if (xml.name() == "TempUnit")
-                setTempUnit(xml.readElementText());
-            /// Единицы измерения давления
-            else if (xml.name() == "PressureUnit")
-                setPressureUnit(xml.readElementText());
-            /// Значение желаемой температуры
-            else if (xml.name() == "TargetTemp")
-                setTargetTemp(xml.readElementText().toDouble());
-            /// Угол направления воздуха
-            else if (xml.name() == "AcAngle")
-                setAcAngle(xml.readElementText().toDouble());
-            /// Ширина окна
-            else if (xml.name() == "ResolutionW")
-                resolution.setWidth(xml.readElementText().toInt());
-            /// Высота окна
-            else if (xml.name() == "ResolutionH")
-                resolution.setHeight(xml.readElementText().toInt());
-            /// Тёмная тема
-            else if (xml.name() == "DarkTheme")
-                darkTheme = (xml.readElementText() == "true");
-            /// Значение питания кондиционера
-            else if (xml.name() == "Power")
-                power = (xml.readElementText() == "true");
+        if (!xml.isStartElement())
+            continue;
+        /// Поле находится по хеш-таблице за постоянное время, неизвестные элементы пропускаются
+        const PrefsField *field = findField(xml.name());
+        if (!field)
+            continue;
+        QString text = xml.readElementText();
+        switch (field->type) {
+        case PrefsField::Real: this->*field->real = text.toDouble(); break;
+        case PrefsField::Int: this->*field->integer = text.toInt(); break;
+        case PrefsField::Bool: this->*field->flag = (text == "true"); break;
+        case PrefsField::Choice: {
+            int index = choiceIndex(*field, text);
+            if (index >= 0)
+                field->setChoice(*this, index);
+            break;
+        }
         }
     }
+    /// Файл мог быть отредактирован вручную
+    PrefsSchema::clampLoaded(*this);
     return !xml.hasError();
 }
 
 bool Preferences::save(const QString &filename) const
 {
-    /// Открытие файла
-    QFile file(filename);
-    /// Если файл не открылся, загрузка не происходит
+    METRICS_SCOPE(PrefsSave);
+    /// Запись идёт во временный файл, старый файл заменяется только после успешной записи
+    QSaveFile file(filename);
+    /// Если файл не открылся, сохранение не происходит
     if (!file.open(QIODevice::WriteOnly))
-        return false;    
+        return false;
     QXmlStreamWriter xml(&file);
     xml.setAutoFormatting(true);
     /// Начало записи
     xml.writeStartDocument();
     /// Группа пользовательских настроек
     xml.writeStartElement("Preferences");
-    /// Внешняя температура
-    xml.writeTextElement("TempVal", QString::number(tempVal));
-    /// Внешняя влажность
-    xml.writeTextElement("HumidityVal", QString::number(humidityVal));
-    /// Внешнее давление
-    xml.writeTextElement("PressureVal", QString::number(pressureVal));
-    /// Единицы измерения температуры
-    xml.writeTextElement("TempUnit", QString(tempUnit));
-    /// Единицы измерения давления
-    xml.writeTextElement("PressureUnit", QString(pressureUnit));
-    /// Значение желаемой температуры
-    xml.writeTextElement("TargetTemp", QString::number(targetTemp));
-    /// Угол направления воздуха
-    xml.writeTextElement("AcAngle", QString::number(acAngle));
-    /// Ширина окна
-    xml.writeTextElement("ResolutionW", QString::number(resolution.width()));
-    /// Высота окна
-    xml.writeTextElement("ResolutionH", QString::number(resolution.height()));
-    /// Темная тема
-    xml.writeTextElement("DarkTheme", darkTheme ? "true" : "false");
-    /// Питание
-    xml.writeTextElement("Power", power ? "true" : "false");
+    for (const PrefsField &field : PrefsSchema::fields) {
+        QString text;
+        switch (field.type) {
+        case PrefsField::Real: text = QString::number(this->*field.real); break;
+        case PrefsField::Int: text = QString::number(this->*field.integer); break;
+        case PrefsField::Bool: text = (this->*field.flag) ? "true" : "false"; break;
+        case PrefsField::Choice: text = QString::fromUtf8(field.choices[field.getChoice(*this)]); break;
+        }
+        xml.writeTextElement(QLatin1String(field.name), text);
+    }
     xml.writeEndElement();
     xml.writeEndDocument();
-    return true;
+    /// При ошибке записи старый файл остаётся нетронутым
+    if (xml.hasError()) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
 }
@@ -15,18 +15,84 @@
 #ifndef PREFERENCES_H
 #define PREFERENCES_H
 
+#include <QObject>
 #include <QString>
 #include <QSize>
 #include <utility>
+#include "prefssnapshot.h"
+#include "units.h"
 
 /**
  * @class Preferences
  * @brief Класс пользовательских настроек
+ *
+ * Каждое поле при изменении испускает свой сигнал. Изменения внутри Transaction копятся
+ * и испускаются один раз при завершении транзакции, после них испускается changed().
  */
-class Preferences
+class Preferences : public QObject
 {
+    Q_OBJECT
 public:
-    Preferences();
+    /// Флаги полей для сигнала changed()
+    enum Field : quint32 {
+        TempValField = 1u << 0,
+        HumidityValField = 1u << 1,
+        PressureValField = 1u << 2,
+        TempUnitField = 1u << 3,
+        PressureUnitField = 1u << 4,
+        TargetTempField = 1u << 5,
+        AcAngleField = 1u << 6,
+        ResolutionField = 1u << 7,
+        ThemeField = 1u << 8,
+        PowerField = 1u << 9,
+        LimitsField = 1u << 10,
+        SwingField = 1u << 11,
+        /// Все поля
+        AllFields = (1u << 12) - 1,
+        /// Поля, которые задаёт пользователь (внешние данные приходят от датчиков)
+        UserFields = TempUnitField | PressureUnitField | TargetTempField | AcAngleField | ResolutionField | ThemeField | PowerField
+                     | SwingField
+    };
+
+    /**
+     * @class Transaction
+     * @brief Пакетное изменение настроек
+     *
+     * Пока объект существует, сигналы полей не испускаются. При его уничтожении
+     * каждый изменившийся сигнал испускается один раз. Транзакции могут быть вложенными.
+     */
+    class Transaction
+    {
+    public:
+        explicit Transaction(Preferences *prefs) : prefs(prefs) { ++prefs->depth; }
+        ~Transaction() { prefs->commit(); }
+        Transaction(const Transaction &) = delete;
+        Transaction &operator=(const Transaction &) = delete;
+    private:
+        Preferences *prefs;
+    };
+
+    /// @defgroup baseLimits Границы значений в базовых единицах (°C, %, мм рт.ст.)
+    /// @{
+    static constexpr qreal TEMPMIN_C = -40;
+    static constexpr qreal TEMPMAX_C = 60;
+    static constexpr qreal HUMIDITYMIN = 0;
+    static constexpr qreal HUMIDITYMAX = 100;
+    static constexpr qreal PRESSUREMIN_MM = 500;
+    static constexpr qreal PRESSUREMAX_MM = 900;
+    static constexpr qreal ACANGLEMIN = -15;
+    static constexpr qreal ACANGLEMAX = 15;
+    /// @}
+
+    /// Стандартные разрешения панелей, между которыми переключает setResolution()
+    static constexpr QSize RESOLUTIONS[] = {
+        QSize(800, 600), QSize(1024, 600), QSize(1024, 768), QSize(1280, 800), QSize(1280, 1024), QSize(1920, 1080)
+    };
+    static constexpr int RESOLUTIONCOUNT = int(sizeof(RESOLUTIONS) / sizeof(RESOLUTIONS[0]));
+    /// Наименьшее разрешение, при котором элементы интерфейса ещё не перекрываются
+    static constexpr QSize MIN_RESOLUTION = QSize(640, 480);
+
+    explicit Preferences(QObject *parent = nullptr);
     /**
      * @brief Загрузка параметров из XML-файла
      *
@@ -39,54 +105,110 @@ public:
     /**
      * @brief Сохранение параметров в XML-файл
      *
-     * Сохранение происходит при закрытии программы
+     * Используется для экспорта. Файл записывается во временный и атомарно заменяет старый.
      * @param filename Путь к файлу
-     * @return true если загрузка прошла успешно
+     * @return true если сохранение прошло успешно
      */
     bool save(const QString &filename) const;
+    /**
+     * @brief Загрузка параметров из бинарного снимка
+     *
+     * Файл отображается в память, после проверки заголовка и контрольной суммы
+     * значения копируются в свойства. Время загрузки не зависит от содержимого файла.
+     * @param filename Путь к файлу
+     * @param sequence Порядковый номер загруженного снимка, не меняется, если снимок не загружен
+     * @return true если снимок прошёл проверку и был загружен
+     */
+    bool loadSnapshot(const QString &filename, quint64 *sequence = nullptr);
+    /**
+     * @brief Сохранение параметров в бинарный снимок
+     *
+     * Снимок записывается во временный файл, который затем атомарно заменяет старый
+     * @param filename Путь к файлу
+     * @return true если сохранение прошло успешно
+     */
+    bool saveSnapshot(const QString &filename) const;
+    /**
+     * @brief Атомарная запись готового снимка в файл
+     * @param filename Путь к файлу
+     * @param snapshot Снимок с заполненным заголовком
+     * @return true если запись прошла успешно
+     */
+    static bool writeSnapshot(const QString &filename, const PrefsSnapshot &snapshot);
+    /**
+     * @brief Заполнение бинарного снимка текущими значениями
+     * @param sequence Порядковый номер снимка
+     */
+    PrefsSnapshot toSnapshot(quint64 sequence = 0) const;
+    /// @brief Применение значений из проверенного бинарного снимка
+    void fromSnapshot(const PrefsSnapshot &snapshot);
     /// @brief Обновление максимальных/минимальных значений в зависимости от текущих единиц измерения
     void setLimits();
 
     /// @brief Геттер значения темы
     bool getTheme() const { return darkTheme; }
     /// @brief Сеттер значения темы
-    void setTheme() {darkTheme = !darkTheme; }
+    void setTheme() { assign(darkTheme, !darkTheme, ThemeField); }
+    /// @brief Установка темы
+    void setTheme(bool dark) { assign(darkTheme, dark, ThemeField); }
     /// @brief Геттер значения питания кондиционера
     bool getPower() const { return power; }
     /// @brief Сеттер значения питания кондиционера
-    void setPower() { power = !power; }
+    void setPower() { assign(power, !power, PowerField); }
+    /// @brief Установка питания кондиционера
+    void setPower(bool on) { assign(power, on, PowerField); }
     /// @brief Геттер единицы измерения температуры
-    QString getTempUnit() const { return tempUnit; }
+    Units::TempUnit getTempUnit() const { return tempUnit; }
     /// @brief Сеттер единицы измерения температуры
-    void setTempUnit(QString val) { tempUnit = val; }
+    void setTempUnit(Units::TempUnit val) { assign(tempUnit, val, TempUnitField); }
+    /**
+     * @brief Смена единицы измерения температуры
+     *
+     * В отличие от setTempUnit() переводит значения температур и границы в новую единицу одной транзакцией
+     */
+    void changeTempUnit(Units::TempUnit to);
     /// @brief Геттер единицы измерения давления
-    QString getPressureUnit() const { return pressureUnit; }
+    Units::PressureUnit getPressureUnit() const { return pressureUnit; }
     /// @brief Сеттер единицы измерения давления
-    void setPressureUnit(QString val) { pressureUnit = val; }
+    void setPressureUnit(Units::PressureUnit val) { assign(pressureUnit, val, PressureUnitField); }
+    /// @brief Смена единицы измерения давления с переводом значения и границ
+    void changePressureUnit(Units::PressureUnit to);
     /// @brief Геттер значения желаемой температуры
     qreal getTargetTemp() const { return targetTemp; }
     /// @brief Сеттер значения желаемой температуры
-    void setTargetTemp(qreal val) { targetTemp = val; }
+    void setTargetTemp(qreal val) { assign(targetTemp, val, TargetTempField); }
     /// @brief Геттер значения разрешения
-    QSize getResolution() const { return resolution; }
-    /// @brief Сеттер значения разрешения. Переключается между двумя режимами.
+    QSize getResolution() const { return QSize(resolutionW, resolutionH); }
+    /// @brief Переключение на следующее стандартное разрешение из RESOLUTIONS (по кругу)
     void setResolution();
+    /// @brief Сеттер значения разрешения. Значение ограничивается снизу MIN_RESOLUTION.
+    void setResolution(const QSize &res);
     /// @brief Геттер значения внешней температуры
     qreal getTempVal() const { return tempVal; }
     /// @brief Сеттер значения внешней температуры
-    void setTempVal(qreal val) { tempVal = val; }
+    void setTempVal(qreal val) { assign(tempVal, val, TempValField); }
+    /// @brief Сеттер значения внешней температуры в °C. Значение переводится в текущие единицы измерения.
+    void setTempValCelsius(qreal val);
     /// @brief Геттер значения внешней влажности
     qreal getHumidityVal() const { return humidityVal; }
     /// @brief Сеттер значения внешней влажности
-    void setHumidityVal(qreal val) { humidityVal = val; }
+    void setHumidityVal(qreal val) { assign(humidityVal, val, HumidityValField); }
     /// @brief Геттер значения внешнего давления
     qreal getPressureVal() const { return pressureVal; }
     /// @brief Сеттер значения внешнего давления
-    void setPressureVal(qreal val) { pressureVal = val; }
+    void setPressureVal(qreal val) { assign(pressureVal, val, PressureValField); }
+    /// @brief Сеттер значения внешнего давления в мм рт.ст. Значение переводится в текущие единицы измерения.
+    void setPressureValMmHg(qreal val);
     /// @brief Геттер значения угла направления воздуха
     qreal getAcAngle() const { return acAngle; }
     /// @brief Сеттер значения угла направления воздуха
-    void setAcAngle(qreal val) { acAngle = val; }
+    void setAcAngle(qreal val) { assign(acAngle, val, AcAngleField); }
+    /// @brief Геттер режима качания заслонки
+    bool getSwing() const { return swing; }
+    /// @brief Переключение режима качания заслонки
+    void setSwing() { assign(swing, !swing, SwingField); }
+    /// @brief Сеттер режима качания заслонки
+    void setSwing(bool on) { assign(swing, on, SwingField); }
     /// @brief Геттер минимального значения температуры
     qreal getTempMin() const { return tempMin; }
     /// @brief Геттер максимального значения температуры
@@ -100,6 +222,39 @@ public:
     /// @brief Геттер максимального значения давления
     qreal getPressureMax() const { return pressureMax; }
 
+signals:
+    /// @brief Изменилась внешняя температура
+    void tempValChanged(qreal value);
+    /// @brief Изменилась внешняя влажность
+    void humidityValChanged(qreal value);
+    /// @brief Изменилось внешнее давление
+    void pressureValChanged(qreal value);
+    /// @brief Изменилась единица измерения температуры
+    void tempUnitChanged(Units::TempUnit unit);
+    /// @brief Изменилась единица измерения давления
+    void pressureUnitChanged(Units::PressureUnit unit);
+    /// @brief Изменилась желаемая температура
+    void targetTempChanged(qreal value);
+    /// @brief Изменился угол направления воздуха
+    void acAngleChanged(qreal value);
+    /// @brief Изменилось разрешение окна
+    void resolutionChanged(const QSize &resolution);
+    /// @brief Переключена тема
+    void themeChanged(bool dark);
+    /// @brief Переключено питание кондиционера
+    void powerChanged(bool on);
+    /// @brief Изменились границы значений
+    void limitsChanged();
+    /// @brief Переключен режим качания заслонки
+    void swingChanged(bool on);
+    /**
+     * @brief Завершено изменение настроек (одиночное или транзакция)
+     *
+     * Испускается после сигналов отдельных полей
+     * @param fields Флаги изменившихся полей (Field)
+     */
+    void changed(quint32 fields);
+
 private:
     /// Значение внешней температуры
     qreal tempVal;
@@ -120,21 +275,49 @@ private:
     /// Максимальное значение давления
     qreal pressureMax;
     /// Единица измерения температуры
-    QString tempUnit;
+    Units::TempUnit tempUnit;
     /// Единицы измерения давления
-    QString pressureUnit;
+    Units::PressureUnit pressureUnit;
     /// Значение желаемой температуры
     qreal targetTemp;
-    /// Разрешение главного окна
-    QSize resolution;
+    /// Ширина главного окна
+    int resolutionW;
+    /// Высота главного окна
+    int resolutionH;
     /// Угол направления воздуха
     qreal acAngle;
     /// Включена ли тёмная тема
     bool darkTheme;
     /// Включен ли кондиционер
     bool power;
+    /// Заслонка качается по всему диапазону углов
+    bool swing;
+    /// Изменившиеся поля, сигналы которых ещё не испущены
+    quint32 dirty = 0;
+    /// Глубина вложенности транзакций
+    int depth = 0;
     /// Инициализация всех значений этого класса
     void initValues();
+    /**
+     * @brief Присваивание значения поля с уведомлением
+     *
+     * Одинаковое значение не вызывает сигналов
+     */
+    template<typename T>
+    void assign(T &member, const T &value, Field field)
+    {
+        if (member == value)
+            return;
+        member = value;
+        markChanged(field);
+    }
+    /// @brief Отметка изменения поля: сигнал испускается сразу или в конце транзакции
+    void markChanged(quint32 fields);
+    /// @brief Завершение транзакции
+    void commit();
+
+    /// Описание полей настроек, по которому строятся загрузка, сохранение и значения по умолчанию
+    friend struct PrefsSchema;
 };
 
 #endif // PREFERENCES_H
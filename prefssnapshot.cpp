@@ -0,0 +1,60 @@
+#include "prefssnapshot.h"
+#include <array>
+#include <cstddef>
+#include <cstring>
+
+namespace {
+/// @brief Таблица CRC-32, вычисляется при компиляции
+constexpr std::array<quint32, 256> makeCrcTable()
+{
+    std::array<quint32, 256> table{};
+    for (quint32 i = 0; i < 256; ++i) {
+        quint32 c = i;
+        for (int k = 0; k < 8; ++k)
+            c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+        table[i] = c;
+    }
+    return table;
+}
+constexpr std::array<quint32, 256> crcTable = makeCrcTable();
+}
+
+quint32 crc32(const void *data, size_t size)
+{
+    const quint8 *bytes = static_cast<const quint8*>(data);
+    quint32 crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i)
+        crc = crcTable[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+quint32 PrefsSnapshot::computeChecksum() const
+{
+    return crc32(reinterpret_cast<const char*>(this) + HEADERSIZE, sizeof(PrefsSnapshot) - HEADERSIZE);
+}
+
+void PrefsSnapshot::seal()
+{
+    magic = MAGIC;
+    version = VERSION;
+    size = sizeof(PrefsSnapshot);
+    reserved = 0;
+    for (quint8 &b : padding)
+        b = 0;
+    checksum = computeChecksum();
+}
+
+bool PrefsSnapshot::isValid() const
+{
+    return magic == MAGIC
+        && version == VERSION
+        && size == sizeof(PrefsSnapshot)
+        && checksum == computeChecksum();
+}
+
+bool PrefsSnapshot::sameValues(const PrefsSnapshot &other) const
+{
+    constexpr size_t offset = offsetof(PrefsSnapshot, tempVal);
+    return std::memcmp(reinterpret_cast<const char*>(this) + offset, reinterpret_cast<const char*>(&other) + offset,
+                       sizeof(PrefsSnapshot) - offset) == 0;
+}
@@ -0,0 +1,94 @@
+/**
+* @file
+* @brief Заголовочный файл бинарного снимка пользовательских настроек
+*
+* Снимок - структура фиксированного размера, которая записывается в файл как есть.
+* При запуске файл отображается в память, проверяются заголовок и контрольная сумма,
+* после чего значения копируются в Preferences. Время чтения не зависит от содержимого.
+*
+* Порядок байтов - порядок байтов платформы. Снимок с другой платформы не пройдёт проверку
+* сигнатуры и будет проигнорирован, в этом случае настройки загружаются из XML.
+*/
+#ifndef PREFSSNAPSHOT_H
+#define PREFSSNAPSHOT_H
+
+#include <QtGlobal>
+#include <type_traits>
+
+/**
+ * @struct PrefsSnapshot
+ * @brief Бинарный снимок пользовательских настроек
+ */
+struct PrefsSnapshot {
+    /// Сигнатура файла
+    static constexpr quint32 MAGIC = 0x53504341; // "ACPS"
+    /// Версия формата
+    static constexpr quint16 VERSION = 2;
+
+    /// @defgroup snapshotHeader Заголовок
+    /// @{
+    /// Сигнатура
+    quint32 magic;
+    /// Версия формата
+    quint16 version;
+    /// Размер снимка в байтах
+    quint16 size;
+    /// CRC-32 всех байтов после заголовка
+    quint32 checksum;
+    /// Зарезервировано
+    quint32 reserved;
+    /// @}
+
+    /// Порядковый номер: растёт с каждым сохранением, по нему отбрасываются записи журнала старше снимка
+    quint64 sequence;
+    /// Значение внешней температуры
+    double tempVal;
+    /// Значение внешней влажности
+    double humidityVal;
+    /// Значение внешнего давления
+    double pressureVal;
+    /// Значение желаемой температуры
+    double targetTemp;
+    /// Угол направления воздуха
+    double acAngle;
+    /// Ширина окна
+    qint32 resolutionW;
+    /// Высота окна
+    qint32 resolutionH;
+    /// Единица измерения температуры: 0 - °C, 1 - °F, 2 - °K
+    quint8 tempUnit;
+    /// Единица измерения давления: 0 - Pa, 1 - мм
+    quint8 pressureUnit;
+    /// Включена ли тёмная тема
+    quint8 darkTheme;
+    /// Включен ли кондиционер
+    quint8 power;
+    /// Включено ли качание заслонки (в снимках до его появления здесь был ноль выравнивания)
+    quint8 swing;
+    /// Выравнивание до 8 байт
+    quint8 padding[3];
+
+    /// Размер заголовка (не входит в контрольную сумму)
+    static constexpr int HEADERSIZE = 16;
+
+    /// @brief Заполнение заголовка и подсчёт контрольной суммы
+    void seal();
+    /// @brief Проверка заголовка и контрольной суммы
+    bool isValid() const;
+    /// @brief Контрольная сумма данных после заголовка
+    quint32 computeChecksum() const;
+    /// @brief Совпадают ли значения настроек (заголовок и порядковый номер не сравниваются)
+    bool sameValues(const PrefsSnapshot &other) const;
+};
+
+static_assert(std::is_trivially_copyable<PrefsSnapshot>::value, "PrefsSnapshot must be trivially copyable");
+static_assert(sizeof(PrefsSnapshot) == 80, "PrefsSnapshot layout changed, bump PrefsSnapshot::VERSION");
+
+/**
+ * @brief CRC-32 (полином 0xEDB88320)
+ * @param data Данные
+ * @param size Размер данных в байтах
+ */
+quint32 crc32(const void *data, size_t size);
+
+#endif // PREFSSNAPSHOT_H
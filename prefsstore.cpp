@@ -0,0 +1,192 @@
+#include "prefsstore.h"
+#include <QFile>
+#include <QTimer>
+#include <QMutexLocker>
+#include <QDebug>
+#include <cstring>
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+/// @brief Сброс буферов файла на носитель
+bool syncToDisk(QFile *file)
+{
+    if (!file->flush())
+        return false;
+#ifdef Q_OS_WIN
+    return _commit(file->handle()) == 0;
+#else
+    return ::fsync(file->handle()) == 0;
+#endif
+}
+}
+
+PrefsStore::PrefsStore(const Preferences *prefs, const QString &snapshotFile, const QString &journalFile, quint64 sequence,
+                       QObject *parent)
+    : QObject(parent),
+    prefs(prefs),
+    snapshotFile(snapshotFile),
+    sequence(sequence),
+    worker(new QObject),
+    compactTimer(new QTimer(worker)),
+    journal(new QFile(journalFile, worker))
+{
+    thread.setObjectName("PrefsStore");
+    compactTimer->setSingleShot(true);
+    compactTimer->setInterval(COMPACTDELAY);
+    connect(compactTimer, &QTimer::timeout, worker, [this]() { compact(); });
+    /// Таймер и журнал - дочерние объекты и переезжают в поток вместе с worker
+    worker->moveToThread(&thread);
+}
+
+PrefsStore::~PrefsStore()
+{
+    stop();
+    delete worker;
+}
+
+bool PrefsStore::recover(Preferences *prefs, const QString &snapshotFile, const QString &journalFile, quint64 *sequence)
+{
+    quint64 snapshotSequence = 0;
+    bool loaded = prefs->loadSnapshot(snapshotFile, &snapshotSequence);
+    if (sequence)
+        *sequence = snapshotSequence;
+
+    QFile file(journalFile);
+    if (!file.open(QIODevice::ReadOnly))
+        return loaded;
+    qint64 count = file.size() / qint64(sizeof(PrefsSnapshot));
+    if (count == 0)
+        return loaded;
+    const uchar *data = file.map(0, count * qint64(sizeof(PrefsSnapshot)));
+    if (!data)
+        return loaded;
+    /// Журнал просматривается с конца: последняя запись, прошедшая проверку, - самая новая в журнале
+    PrefsSnapshot record;
+    for (qint64 i = count - 1; i >= 0; --i) {
+        std::memcpy(&record, data + i * qint64(sizeof(PrefsSnapshot)), sizeof(PrefsSnapshot));
+        if (!record.isValid())
+            continue;
+        /// Запись не новее снимка осталась от неудачной очистки журнала и не должна его перекрывать
+        if (record.sequence > snapshotSequence) {
+            prefs->fromSnapshot(record);
+            loaded = true;
+            if (sequence)
+                *sequence = record.sequence;
+        }
+        break;
+    }
+    file.unmap(const_cast<uchar*>(data));
+    return loaded;
+}
+
+void PrefsStore::start()
+{
+    if (!thread.isRunning())
+        thread.start();
+}
+
+void PrefsStore::submit()
+{
+    /// Снимок настроек делается в GUI-потоке, рабочий поток к Preferences не обращается
+    PrefsSnapshot snapshot = prefs->toSnapshot(++sequence);
+    QMutexLocker lock(&mutex);
+    pending = snapshot;
+    /// Запись планируется один раз, пока рабочий поток её не выполнил
+    if (!hasPending) {
+        hasPending = true;
+        QMetaObject::invokeMethod(worker, [this]() { writePending(); }, Qt::QueuedConnection);
+    }
+}
+
+void PrefsStore::flush()
+{
+    if (!thread.isRunning())
+        return;
+    submit();
+    QMetaObject::invokeMethod(worker, [this]() {
+        writePending();
+        if (journalRecords > 0 || hasUnsaved)
+            compact();
+    }, Qt::BlockingQueuedConnection);
+}
+
+void PrefsStore::stop()
+{
+    if (!thread.isRunning())
+        return;
+    flush();
+    thread.quit();
+    thread.wait();
+}
+
+void PrefsStore::writePending()
+{
+    PrefsSnapshot snapshot;
+    {
+        QMutexLocker lock(&mutex);
+        if (!hasPending)
+            return;
+        snapshot = pending;
+        hasPending = false;
+    }
+    /// Неизменившиеся настройки не пишутся повторно; после неудачной записи сохранённым считается только written
+    if (!hasUnsaved && hasWritten && snapshot.sameValues(written))
+        return;
+
+    bool ok = journal->isOpen() || journal->open(QIODevice::WriteOnly | QIODevice::Append);
+    if (ok) {
+        /// Если при прошлом запуске хвост журнала был недописан, новые записи выравниваются по границе записи
+        qint64 aligned = journal->size() - journal->size() % qint64(sizeof(PrefsSnapshot));
+        if (aligned != journal->size())
+            journal->resize(aligned);
+        ok = journal->write(reinterpret_cast<const char*>(&snapshot), sizeof(PrefsSnapshot)) == qint64(sizeof(PrefsSnapshot))
+                && syncToDisk(journal);
+    }
+    if (!ok) {
+        qWarning() << "Cannot write preferences journal:" << journal->errorString();
+        /// Изменение не теряется: его запишет сворачивание
+        unsaved = snapshot;
+        hasUnsaved = true;
+        compactTimer->start();
+        return;
+    }
+    written = snapshot;
+    hasWritten = true;
+    hasUnsaved = false;
+    /// Сворачивание откладывается, пока изменения продолжаются, но журнал не растёт бесконечно
+    if (++journalRecords >= JOURNALLIMIT)
+        compact();
+    else
+        compactTimer->start();
+}
+
+void PrefsStore::compact()
+{
+    compactTimer->stop();
+    if (!hasWritten && !hasUnsaved)
+        return;
+    /// Несохранённый снимок новее всего, что есть в журнале
+    PrefsSnapshot latest = hasUnsaved ? unsaved : written;
+    /// Снимок заменяется атомарно, журнал очищается только после успешной замены
+    if (!Preferences::writeSnapshot(snapshotFile, latest)) {
+        qWarning() << "Cannot write preferences snapshot" << snapshotFile;
+        /// Изменение, которого нет ни в журнале, ни в снимке, сохраняется повторной попыткой
+        if (hasUnsaved)
+            compactTimer->start();
+        return;
+    }
+    written = latest;
+    hasWritten = true;
+    hasUnsaved = false;
+    bool truncated = journal->isOpen() ? journal->resize(0) : QFile::resize(journal->fileName(), 0);
+    if (!truncated) {
+        /// Оставшиеся записи не новее снимка и при запуске пропускаются, очистка повторится при следующем сворачивании
+        qWarning() << "Cannot truncate preferences journal" << journal->fileName();
+        return;
+    }
+    journalRecords = 0;
+}
@@ -0,0 +1,119 @@
+/**
+* @file
+* @brief Заголовочный файл фонового сохранения пользовательских настроек
+*
+* Каждое изменение настроек дописывается в журнал - файл из записей PrefsSnapshot, каждая со своей
+* контрольной суммой. Через COMPACTDELAY мс без изменений журнал сворачивается: последний снимок
+* записывается во временный файл, который атомарно заменяет preferences.bin, и журнал очищается.
+* Все операции с файлами выполняются в отдельном потоке. Если запись в журнал не удалась, снимок
+* сохраняется сворачиванием, которое повторяется каждые COMPACTDELAY мс до успеха.
+*
+* При запуске загружается снимок, поверх него применяется последняя целая запись журнала, если её
+* порядковый номер больше номера снимка. Недописанная при отключении питания запись не проходит
+* проверку и пропускается; записи, оставшиеся после неудачной очистки журнала, старше снимка и
+* тоже пропускаются.
+*/
+#ifndef PREFSSTORE_H
+#define PREFSSTORE_H
+
+#include <QObject>
+#include <QThread>
+#include <QMutex>
+#include "preferences.h"
+
+class QFile;
+class QTimer;
+
+/**
+ * @class PrefsStore
+ * @brief Журналируемое сохранение пользовательских настроек в рабочем потоке
+ */
+class PrefsStore : public QObject
+{
+    Q_OBJECT
+public:
+    /// Задержка сворачивания журнала после последнего изменения, мс
+    static constexpr int COMPACTDELAY = 2000;
+    /// Количество записей журнала, после которого он сворачивается без ожидания
+    static constexpr int JOURNALLIMIT = 64;
+
+    /**
+     * @param prefs Пользовательские настройки
+     * @param snapshotFile Путь к бинарному снимку
+     * @param journalFile Путь к журналу изменений
+     * @param sequence Наибольший порядковый номер, найденный recover(): новые снимки нумеруются после него
+     * @param parent Родительский объект
+     */
+    PrefsStore(const Preferences *prefs, const QString &snapshotFile, const QString &journalFile, quint64 sequence,
+               QObject *parent = nullptr);
+    ~PrefsStore() override;
+    /**
+     * @brief Восстановление настроек при запуске
+     *
+     * Загружается снимок, затем последняя целая запись журнала, если она новее снимка
+     * @param prefs Пользовательские настройки
+     * @param snapshotFile Путь к бинарному снимку
+     * @param journalFile Путь к журналу изменений
+     * @param sequence Наибольший порядковый номер в снимке и журнале
+     * @return true если настройки загружены хотя бы из одного файла
+     */
+    static bool recover(Preferences *prefs, const QString &snapshotFile, const QString &journalFile, quint64 *sequence = nullptr);
+    /// @brief Запуск рабочего потока
+    void start();
+    /**
+     * @brief Сохранение текущих настроек
+     *
+     * Не блокирует: снимок настроек передаётся в рабочий поток. Несколько вызовов подряд,
+     * пока поток занят записью, дают одну запись журнала с последними значениями.
+     */
+    void submit();
+    /**
+     * @brief Сохранение текущих настроек и сворачивание журнала
+     *
+     * Блокирует до окончания записи. Вызывается при выходе из программы.
+     */
+    void flush();
+    /// @brief Сохранение настроек и остановка рабочего потока
+    void stop();
+
+private:
+    /// Пользовательские настройки
+    const Preferences *prefs;
+    /// Путь к бинарному снимку
+    QString snapshotFile;
+    /// Порядковый номер последнего снимка, переданного на запись (GUI-поток)
+    quint64 sequence;
+    /// Рабочий поток
+    QThread thread;
+    /// Объект рабочего потока, в его контексте выполняется запись
+    QObject *worker;
+    /// Таймер сворачивания журнала (рабочий поток)
+    QTimer *compactTimer;
+    /// Журнал изменений (рабочий поток)
+    QFile *journal;
+
+    /// Защищает pending и hasPending
+    QMutex mutex;
+    /// Снимок, ожидающий записи
+    PrefsSnapshot pending;
+    /// Запись уже запланирована
+    bool hasPending = false;
+
+    /// Последний записанный снимок (рабочий поток)
+    PrefsSnapshot written;
+    /// Есть ли записанный снимок
+    bool hasWritten = false;
+    /// Снимок, который не удалось дописать в журнал: его сохранит сворачивание (рабочий поток)
+    PrefsSnapshot unsaved;
+    /// Есть ли несохранённый снимок
+    bool hasUnsaved = false;
+    /// Журнал содержит записи, ещё не свёрнутые в снимок (рабочий поток)
+    int journalRecords = 0;
+
+    /// @brief Дописывание ожидающего снимка в журнал (рабочий поток)
+    void writePending();
+    /// @brief Запись снимка и очистка журнала (рабочий поток)
+    void compact();
+};
+
+#endif // PREFSSTORE_H
@@ -0,0 +1,144 @@
+#include "readoutitem.h"
+#include <QPainter>
+#include <QFontMetricsF>
+#include <QHash>
+#include <cmath>
+
+/// Индекс глифа минуса
+static constexpr quint8 GLYPH_MINUS = 10;
+/// Индекс глифа точки
+static constexpr quint8 GLYPH_DOT = 11;
+
+ReadoutItem::ReadoutItem(const QFont &font, QGraphicsItem *parent)
+    : QGraphicsItem(parent),
+    font(font),
+    glyphs(glyphsFor(font))
+{
+}
+
+QSharedPointer<const ReadoutItem::Glyphs> ReadoutItem::glyphsFor(const QFont &font)
+{
+    /// Кэш общий для всех элементов, элементы создаются и рисуются только в GUI-потоке
+    static QHash<QString, QSharedPointer<const Glyphs>> cache;
+    const QString key = font.key();
+    auto it = cache.constFind(key);
+    if (it != cache.constEnd())
+        return it.value();
+
+    static const char symbols[GLYPHCOUNT + 1] = "0123456789-.";
+    QSharedPointer<Glyphs> result = QSharedPointer<Glyphs>::create();
+    QFontMetricsF metrics(font);
+    for (int i = 0; i < GLYPHCOUNT; ++i) {
+        QString symbol(QLatin1Char(symbols[i]));
+        result->glyph[i].setTextFormat(Qt::PlainText);
+        result->glyph[i].setPerformanceHint(QStaticText::AggressiveCaching);
+        result->glyph[i].setText(symbol);
+        result->glyph[i].prepare(QTransform(), font);
+        result->advance[i] = metrics.horizontalAdvance(symbol);
+    }
+    result->height = metrics.height();
+    cache.insert(key, result);
+    return result;
+}
+
+bool ReadoutItem::setValue(qreal value, int precision)
+{
+    precision = qBound(0, precision, 6);
+    quint64 scale = 1;
+    for (int i = 0; i < precision; ++i)
+        scale *= 10;
+    /// Значение переводится в целое число с нужным количеством знаков после запятой
+    qreal scaled = std::round(std::fabs(value) * scale);
+    quint64 digits = static_cast<quint64>(qMin(scaled, 1e17));
+
+    /// Символы записываются с конца, без выделения памяти
+    quint8 reversed[MAXDIGITS];
+    int count = 0;
+    quint64 fraction = digits % scale;
+    quint64 integer = digits / scale;
+    for (int i = 0; i < precision; ++i) {
+        reversed[count++] = static_cast<quint8>(fraction % 10);
+        fraction /= 10;
+    }
+    if (precision > 0)
+        reversed[count++] = GLYPH_DOT;
+    do {
+        reversed[count++] = static_cast<quint8>(integer % 10);
+        integer /= 10;
+    } while (integer != 0 && count < MAXDIGITS - 1);
+    /// Округлённый до нуля результат показывается без минуса
+    if (value < 0 && digits != 0)
+        reversed[count++] = GLYPH_MINUS;
+
+    /// Если символы не изменились, элемент не трогается
+    bool same = numeric && count == charCount;
+    for (int i = 0; same && i < count; ++i)
+        same = chars[i] == reversed[count - 1 - i];
+    if (same)
+        return false;
+
+    qreal newWidth = 0;
+    for (int i = 0; i < count; ++i) {
+        chars[i] = reversed[count - 1 - i];
+        newWidth += glyphs->advance[chars[i]];
+    }
+    charCount = count;
+    numeric = true;
+    setWidth(newWidth);
+    update();
+    return true;
+}
+
+bool ReadoutItem::setText(const QString &text)
+{
+    if (!numeric && this->text == text)
+        return false;
+    this->text = text;
+    staticText.setTextFormat(Qt::PlainText);
+    staticText.setText(text);
+    staticText.prepare(QTransform(), font);
+    numeric = false;
+    setWidth(staticText.size().width());
+    update();
+    return true;
+}
+
+void ReadoutItem::setColor(const QColor &color)
+{
+    if (this->color == color)
+        return;
+    this->color = color;
+    update();
+}
+
+void ReadoutItem::setWidth(qreal newWidth)
+{
+    if (qFuzzyCompare(width + 1, newWidth + 1))
+        return;
+    /// Сцена должна узнать о новой геометрии до её изменения
+    prepareGeometryChange();
+    width = newWidth;
+}
+
+QRectF ReadoutItem::boundingRect() const
+{
+    return QRectF(0, 0, width, glyphs->height);
+}
+
+void ReadoutItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(option);
+    Q_UNUSED(widget);
+    painter->setFont(font);
+    painter->setPen(color);
+    if (!numeric) {
+        painter->drawStaticText(QPointF(0, 0), staticText);
+        return;
+    }
+    /// Число рисуется из готовых глифов символ за символом
+    qreal x = 0;
+    for (int i = 0; i < charCount; ++i) {
+        painter->drawStaticText(QPointF(x, 0), glyphs->glyph[chars[i]]);
+        x += glyphs->advance[chars[i]];
+    }
+}
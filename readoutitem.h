@@ -0,0 +1,106 @@
+/**
+* @file
+* @brief Заголовочный файл элемента для отображения значений
+*
+* Лёгкая замена QGraphicsTextItem для показаний и единиц измерения.
+* Глифы цифр заранее подготавливаются в QStaticText и общие для всех элементов с одним шрифтом,
+* поэтому обновление значения не выделяет память и не пересчитывает раскладку текста.
+*/
+#ifndef READOUTITEM_H
+#define READOUTITEM_H
+
+#include <QGraphicsItem>
+#include <QStaticText>
+#include <QSharedPointer>
+#include <QFont>
+#include <QColor>
+
+/**
+ * @class ReadoutItem
+ * @brief Элемент сцены для числового показания или короткой подписи
+ */
+class ReadoutItem : public QGraphicsItem
+{
+public:
+    /// Тип элемента для qgraphicsitem_cast
+    enum { Type = UserType + 1 };
+
+    /**
+     * @param font Шрифт элемента
+     * @param parent Родительский элемент
+     */
+    explicit ReadoutItem(const QFont &font, QGraphicsItem *parent = nullptr);
+    /**
+     * @brief Установка числового значения
+     *
+     * Число форматируется во внутренний буфер без выделения памяти.
+     * @param value Значение
+     * @param precision Количество знаков после запятой
+     * @return true если отображаемый текст изменился
+     */
+    bool setValue(qreal value, int precision = 2);
+    /**
+     * @brief Установка текста (например единицы измерения)
+     * @param text Текст
+     * @return true если отображаемый текст изменился
+     */
+    bool setText(const QString &text);
+    /// @brief Установка цвета текста
+    void setColor(const QColor &color);
+
+    QRectF boundingRect() const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+    int type() const override { return Type; }
+
+private:
+    /// Набор символов, для которых готовятся глифы: цифры, минус и точка
+    static constexpr int GLYPHCOUNT = 12;
+    /// Максимальная длина числа
+    static constexpr int MAXDIGITS = 24;
+
+    /// @brief Готовые глифы одного шрифта
+    struct Glyphs {
+        /// Глифы символов
+        QStaticText glyph[GLYPHCOUNT];
+        /// Ширина каждого символа
+        qreal advance[GLYPHCOUNT];
+        /// Высота строки
+        qreal height;
+    };
+    /**
+     * @brief Глифы для шрифта
+     *
+     * Глифы готовятся один раз для каждого шрифта и используются всеми элементами
+     * @param font Шрифт
+     */
+    static QSharedPointer<const Glyphs> glyphsFor(const QFont &font);
+
+    /// Шрифт элемента
+    QFont font;
+    /// Готовые глифы шрифта
+    QSharedPointer<const Glyphs> glyphs;
+    /// Цвет текста
+    QColor color;
+    /// Элемент показывает число (иначе - текст)
+    bool numeric = true;
+    /// Индексы глифов отображаемого числа
+    quint8 chars[MAXDIGITS];
+    /// Количество символов отображаемого числа
+    int charCount = 0;
+    /// Отображаемый текст
+    QString text;
+    /// Подготовленный отображаемый текст
+    QStaticText staticText;
+    /// Ширина элемента
+    qreal width = 0;
+
+    /**
+     * @brief Смена ширины элемента
+     *
+     * Сообщает сцене об изменении геометрии, только если ширина действительно изменилась
+     * @param newWidth Новая ширина
+     */
+    void setWidth(qreal newWidth);
+};
+
+#endif // READOUTITEM_H
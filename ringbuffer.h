@@ -0,0 +1,72 @@
+/**
+* @file
+* @brief Заголовочный файл кольцевого буфера
+*
+* Буфер фиксированной ёмкости, память выделяется один раз при создании.
+* При заполнении новые значения затирают самые старые.
+*/
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <QtGlobal>
+#include <memory>
+
+/**
+ * @class RingBuffer
+ * @brief Кольцевой буфер фиксированной ёмкости
+ * @tparam T Тип элемента
+ */
+template <typename T>
+class RingBuffer
+{
+public:
+    /// @param capacity Ёмкость, округляется вверх до степени двойки
+    explicit RingBuffer(quint32 capacity)
+        : cap(roundUp(capacity)),
+        data(new T[cap]())
+    {
+    }
+    RingBuffer(const RingBuffer &) = delete;
+    RingBuffer &operator=(const RingBuffer &) = delete;
+
+    /// @brief Добавление значения, при заполнении затирается самое старое
+    void push(const T &value)
+    {
+        data[appended & (cap - 1)] = value;
+        ++appended;
+    }
+    /// @brief Количество хранимых значений
+    quint32 size() const { return appended < cap ? static_cast<quint32>(appended) : cap; }
+    /// @brief Ёмкость
+    quint32 capacity() const { return cap; }
+    /// @brief Количество значений, добавленных за всё время (монотонно растёт)
+    quint64 total() const { return appended; }
+    /// @brief Значение по порядковому номеру от самого старого хранимого (0) до самого нового (size() - 1)
+    const T &operator[](quint32 i) const { return data[(appended - size() + i) & (cap - 1)]; }
+    /**
+     * @brief Хранится ли значение с абсолютным номером
+     * @param index Номер значения в порядке добавления, от 0 до total() - 1
+     */
+    bool contains(quint64 index) const { return index < appended && index + size() >= appended; }
+    /// @brief Значение по абсолютному номеру (проверяется через contains())
+    const T &at(quint64 index) const { return data[index & (cap - 1)]; }
+
+private:
+    /// Ёмкость (степень двойки)
+    quint32 cap;
+    /// Количество добавленных значений
+    quint64 appended = 0;
+    /// Значения
+    std::unique_ptr<T[]> data;
+
+    /// @brief Округление вверх до степени двойки
+    static quint32 roundUp(quint32 value)
+    {
+        quint32 result = 1;
+        while (result < value)
+            result <<= 1;
+        return result;
+    }
+};
+
+#endif // RINGBUFFER_H
@@ -0,0 +1,248 @@
+#include "scenecontrols.h"
+#include <QPainter>
+#include <QTouchEvent>
+#include <QGraphicsSceneMouseEvent>
+
+SceneControl::SceneControl(QGraphicsItem *parent)
+    : QGraphicsObject(parent)
+{
+    setAcceptedMouseButtons(Qt::LeftButton);
+    setAcceptTouchEvents(true);
+}
+
+void SceneControl::setSize(const QSizeF &size)
+{
+    if (size == controlSize)
+        return;
+    prepareGeometryChange();
+    controlSize = size;
+}
+
+bool SceneControl::sceneEvent(QEvent *event)
+{
+    /// Касание обрабатывается сразу, без ожидания синтезированных событий мыши
+    switch (event->type()) {
+    case QEvent::TouchBegin:
+    case QEvent::TouchUpdate:
+    case QEvent::TouchEnd: {
+        QTouchEvent *touch = static_cast<QTouchEvent*>(event);
+        if (touch->touchPoints().isEmpty())
+            return false;
+        /// Учитывается только первое касание
+        QPointF pos = touch->touchPoints().first().pos();
+        if (event->type() == QEvent::TouchBegin)
+            pointerPressed(pos);
+        else if (event->type() == QEvent::TouchUpdate)
+            pointerMoved(pos);
+        else
+            pointerReleased(pos);
+        event->accept();
+        return true;
+    }
+    case QEvent::TouchCancel:
+        pointerCanceled();
+        event->accept();
+        return true;
+    default:
+        return QGraphicsObject::sceneEvent(event);
+    }
+}
+
+void SceneControl::mousePressEvent(QGraphicsSceneMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton) {
+        event->ignore();
+        return;
+    }
+    pointerPressed(event->pos());
+    event->accept();
+}
+
+void SceneControl::mouseMoveEvent(QGraphicsSceneMouseEvent *event)
+{
+    pointerMoved(event->pos());
+    event->accept();
+}
+
+void SceneControl::mouseReleaseEvent(QGraphicsSceneMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton) {
+        event->ignore();
+        return;
+    }
+    pointerReleased(event->pos());
+    event->accept();
+}
+
+QVariant SceneControl::itemChange(GraphicsItemChange change, const QVariant &value)
+{
+    if ((change == ItemEnabledHasChanged || change == ItemVisibleHasChanged) && !value.toBool())
+        pointerCanceled();
+    return QGraphicsObject::itemChange(change, value);
+}
+
+CustomButton::CustomButton(const QString &text, const QFont &font, QGraphicsItem *parent)
+    : SceneControl(parent),
+    text(text),
+    font(font)
+{
+}
+
+void CustomButton::applyButtonTheme(const ButtonStyle *theme)
+{
+    /// Стиль кнопки определяются двумя факторами: включен ли кондиционер и какая тема активна.
+    /// Готовый стиль выбирает MainScene, кнопке остаётся только перерисоваться
+    if (this->theme == theme)
+        return;
+    this->theme = theme;
+    update();
+}
+
+void CustomButton::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(option);
+    Q_UNUSED(widget);
+    if (!theme)
+        return;
+    QRectF rect = boundingRect();
+    /// Нажатие - флаг отрисовки: кисть уже готова в палитре, стиль не пересчитывается
+    painter->fillRect(rect, down ? theme->pressed : theme->background);
+    /// Рамка рисуется внутри кнопки, поэтому прямоугольник уменьшается на половину толщины пера
+    qreal half = theme->border.widthF() / 2;
+    painter->setPen(theme->border);
+    painter->setBrush(Qt::NoBrush);
+    painter->drawRect(rect.adjusted(half, half, -half, -half));
+    painter->setPen(theme->text);
+    painter->setFont(font);
+    painter->drawText(rect, Qt::AlignCenter, text);
+}
+
+void CustomButton::setDown(bool value)
+{
+    if (down == value)
+        return;
+    down = value;
+    update();
+}
+
+void CustomButton::pointerPressed(const QPointF &pos)
+{
+    Q_UNUSED(pos);
+    tracking = true;
+    setDown(true);
+    emit pressed();
+}
+
+void CustomButton::pointerMoved(const QPointF &pos)
+{
+    /// Как у QPushButton: если увести палец с кнопки, она отжимается, а отпускание не считается нажатием
+    if (tracking)
+        setDown(boundingRect().contains(pos));
+}
+
+void CustomButton::pointerReleased(const QPointF &pos)
+{
+    if (!tracking)
+        return;
+    bool click = boundingRect().contains(pos);
+    tracking = false;
+    setDown(false);
+    emit released();
+    if (click)
+        emit clicked();
+}
+
+void CustomButton::pointerCanceled()
+{
+    if (!tracking)
+        return;
+    tracking = false;
+    setDown(false);
+    emit released();
+}
+
+CustomSlider::CustomSlider(QGraphicsItem *parent)
+    : SceneControl(parent)
+{
+}
+
+void CustomSlider::applySliderTheme(const SliderStyle *theme)
+{
+    if (this->theme == theme)
+        return;
+    this->theme = theme;
+    update();
+}
+
+void CustomSlider::setRange(int min, int max)
+{
+    this->min = min;
+    this->max = qMax(min, max);
+    setValue(current);
+}
+
+void CustomSlider::setValue(int value)
+{
+    value = qBound(min, value, max);
+    if (value == current)
+        return;
+    current = value;
+    update();
+    emit valueChanged(current);
+}
+
+void CustomSlider::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(option);
+    Q_UNUSED(widget);
+    if (!theme)
+        return;
+    qreal width = size().width();
+    qreal height = size().height();
+    /// Желоб занимает всю ширину слайдера и треть его высоты
+    QRectF groove(0, height / 3.0, width, height / 3.0);
+    qreal half = theme->grooveBorder.style() == Qt::NoPen ? 0 : theme->grooveBorder.widthF() / 2;
+    painter->setPen(theme->grooveBorder);
+    painter->setBrush(theme->groove);
+    painter->drawRect(groove.adjusted(half, half, -half, -half));
+
+    /// Ручка на всю высоту слайдера, положение пропорционально значению
+    int span = max - min;
+    qreal ratio = span > 0 ? qreal(current - min) / span : 0;
+    QRectF handle(ratio * (width - handleWidth()), 0, handleWidth(), height);
+    painter->fillRect(handle, theme->handle);
+}
+
+int CustomSlider::valueAt(qreal x) const
+{
+    int span = max - min;
+    qreal track = size().width() - handleWidth();
+    if (track <= 0)
+        return current;
+    /// Центр ручки совмещается с точкой нажатия
+    qreal ratio = qBound(0.0, (x - handleWidth() / 2.0) / track, 1.0);
+    return min + qRound(ratio * span);
+}
+
+void CustomSlider::pointerPressed(const QPointF &pos)
+{
+    dragging = true;
+    setValue(valueAt(pos.x()));
+}
+
+void CustomSlider::pointerMoved(const QPointF &pos)
+{
+    if (dragging)
+        setValue(valueAt(pos.x()));
+}
+
+void CustomSlider::pointerReleased(const QPointF &pos)
+{
+    Q_UNUSED(pos);
+    dragging = false;
+}
+
+void CustomSlider::pointerCanceled()
+{
+    dragging = false;
+}
@@ -0,0 +1,182 @@
+/**
+* @file
+* @brief Заголовочный файл элементов управления сцены
+*
+* Кнопки и слайдер - собственные элементы сцены, а не виджеты в QGraphicsProxyWidget.
+* Они рисуются напрямую готовым стилем темы и сами обрабатывают мышь и касания,
+* без перевода событий между сценой и виджетом и без отрисовки виджета во внеэкранный буфер.
+*/
+#ifndef SCENECONTROLS_H
+#define SCENECONTROLS_H
+
+#include <QGraphicsObject>
+#include <QFont>
+#include "themeengine.h"
+
+/**
+ * @class SceneControl
+ * @brief Основа элементов управления
+ *
+ * Размер задаёт раскладка. Мышь и касания сводятся к трём действиям: нажатие, перемещение и отпускание.
+ * Касание обрабатывается напрямую, без синтеза событий мыши.
+ */
+class SceneControl : public QGraphicsObject
+{
+    Q_OBJECT
+public:
+    explicit SceneControl(QGraphicsItem *parent = nullptr);
+    /// @brief Установка размера (вызывается раскладкой)
+    void setSize(const QSizeF &size);
+    /// @brief Размер элемента
+    QSizeF size() const { return controlSize; }
+    QRectF boundingRect() const override { return QRectF(QPointF(0, 0), controlSize); }
+
+protected:
+    /// @brief Нажатие в точке pos (координаты элемента)
+    virtual void pointerPressed(const QPointF &pos) = 0;
+    /// @brief Перемещение нажатого указателя
+    virtual void pointerMoved(const QPointF &pos) = 0;
+    /// @brief Отпускание
+    virtual void pointerReleased(const QPointF &pos) = 0;
+    /// @brief Нажатие прервано (касание отменено или элемент выключен)
+    virtual void pointerCanceled() = 0;
+
+    bool sceneEvent(QEvent *event) override;
+    void mousePressEvent(QGraphicsSceneMouseEvent *event) override;
+    void mouseMoveEvent(QGraphicsSceneMouseEvent *event) override;
+    void mouseReleaseEvent(QGraphicsSceneMouseEvent *event) override;
+    /// @brief Выключение элемента прерывает нажатие
+    QVariant itemChange(GraphicsItemChange change, const QVariant &value) override;
+
+private:
+    /// Размер элемента
+    QSizeF controlSize;
+};
+
+/**
+ * @class CustomButton
+ * @brief Кнопка
+ */
+class CustomButton : public SceneControl
+{
+    Q_OBJECT
+public:
+    /// Тип элемента для qgraphicsitem_cast
+    enum { Type = UserType + 5 };
+
+    /**
+     * @param text Текст на кнопке
+     * @param font Шрифт текста
+     * @param parent Родительский элемент
+     */
+    CustomButton(const QString &text, const QFont &font, QGraphicsItem *parent = nullptr);
+    /**
+     * @brief Применение цвета текущей темы
+     *
+     * Стиль не копируется: кнопка запоминает указатель на готовый стиль и перерисовывается.
+     * @param theme готовый стиль из ThemeEngine
+     */
+    void applyButtonTheme(const ButtonStyle *theme);
+    /// @brief Кнопка нажата
+    bool isDown() const { return down; }
+
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+    int type() const override { return Type; }
+
+signals:
+    /// @brief Кнопка нажата
+    void pressed();
+    /// @brief Кнопка отпущена
+    void released();
+    /// @brief Кнопка нажата и отпущена над собой
+    void clicked();
+
+protected:
+    void pointerPressed(const QPointF &pos) override;
+    void pointerMoved(const QPointF &pos) override;
+    void pointerReleased(const QPointF &pos) override;
+    void pointerCanceled() override;
+
+private:
+    /// Текст на кнопке
+    QString text;
+    /// Шрифт текста
+    QFont font;
+    /// Готовый стиль текущей темы
+    const ButtonStyle *theme = nullptr;
+    /// Кнопка нажата и указатель над ней
+    bool down = false;
+    /// Нажатие началось на кнопке и ещё не закончилось
+    bool tracking = false;
+
+    /// @brief Смена состояния нажатия с перерисовкой
+    void setDown(bool value);
+};
+
+/**
+ * @class CustomSlider
+ * @brief Горизонтальный слайдер
+ *
+ * Ручка перемещается в точку нажатия, что удобнее на сенсорной панели.
+ */
+class CustomSlider : public SceneControl
+{
+    Q_OBJECT
+public:
+    /// Тип элемента для qgraphicsitem_cast
+    enum { Type = UserType + 6 };
+
+    explicit CustomSlider(QGraphicsItem *parent = nullptr);
+    /**
+     * @brief Применение цвета текущей темы
+     * @param theme готовый стиль из ThemeEngine
+     */
+    void applySliderTheme(const SliderStyle *theme);
+    /// @brief Установка диапазона значений
+    void setRange(int min, int max);
+    /// @brief Наименьшее значение
+    int minimum() const { return min; }
+    /// @brief Наибольшее значение
+    int maximum() const { return max; }
+    /// @brief Текущее значение
+    int value() const { return current; }
+    /// @brief Установка значения, сигнал valueChanged() только при изменении
+    void setValue(int value);
+
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+    int type() const override { return Type; }
+
+signals:
+    /// @brief Значение изменилось
+    void valueChanged(int value);
+
+protected:
+    void pointerPressed(const QPointF &pos) override;
+    void pointerMoved(const QPointF &pos) override;
+    void pointerReleased(const QPointF &pos) override;
+    void pointerCanceled() override;
+
+private:
+    /// Ширина ручки, пока стиль не задан
+    static constexpr int DEFAULT_HANDLEWIDTH = 50;
+    /// Готовый стиль текущей темы
+    const SliderStyle *theme = nullptr;
+    /// Наименьшее значение
+    int min = 0;
+    /// Наибольшее значение
+    int max = 99;
+    /// Текущее значение
+    int current = 0;
+    /// Ручка перетаскивается
+    bool dragging = false;
+
+    /// @brief Ширина ручки в текущем стиле
+    int handleWidth() const { return theme ? theme->handleWidth : DEFAULT_HANDLEWIDTH; }
+    /**
+     * @brief Значение слайдера, соответствующее координате
+     * @param x координата по горизонтали
+     */
+    int valueAt(qreal x) const;
+};
+
+#endif // SCENECONTROLS_H
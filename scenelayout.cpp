@@ -0,0 +1,110 @@
+#include "scenelayout.h"
+
+bool SceneLayout::setGrid(const QSize &res, int cols, int rows)
+{
+    if (res == resolution)
+        return false;
+    resolution = res;
+    /// Размер одной колонки определяется делением ширины окна на количество колонок
+    oneColSize = qreal(res.width()) / cols;
+    /// Размер одной строки определяется делением высоты окна на количество строк
+    oneRowSize = qreal(res.height()) / rows;
+
+    /// Таблица разрешения переносится в конец очереди, самая давно использованная вытесняется
+    quint64 key = tableKey(res);
+    tableOrder.removeOne(key);
+    tableOrder.append(key);
+    if (tableOrder.size() > MAX_TABLES)
+        tables.remove(tableOrder.takeFirst());
+
+    gridChanged = true;
+    invalidateAll();
+    return true;
+}
+
+void SceneLayout::addItem(QGraphicsItem *item, qint16 col, qint16 row, qint16 colSpan, qint16 rowSpan)
+{
+    /// Тип элемента определяется один раз, а не при каждом размещении
+    QGraphicsObject *object = item->toGraphicsObject();
+    SceneControl *control = object ? qobject_cast<SceneControl*>(object) : nullptr;
+    index.insert(item, entries.size());
+    dirtyEntries.append(entries.size());
+    entries.append({item, control, col, row, colSpan, rowSpan, QSizeF(), true});
+}
+
+void SceneLayout::invalidate(QGraphicsItem *item)
+{
+    auto it = index.constFind(item);
+    if (it == index.constEnd())
+        return;
+    Entry &entry = entries[it.value()];
+    if (entry.dirty)
+        return;
+    entry.dirty = true;
+    dirtyEntries.append(it.value());
+}
+
+void SceneLayout::invalidateAll()
+{
+    dirtyEntries.clear();
+    for (int i = 0; i < entries.size(); ++i) {
+        entries[i].dirty = true;
+        /// Сброс размера заставляет place() вернуть элемент на место, даже если он не менялся
+        entries[i].placedSize = QSizeF();
+        dirtyEntries.append(i);
+    }
+}
+
+SceneLayout::Table &SceneLayout::currentTable()
+{
+    Table &table = tables[tableKey(resolution)];
+    /// Элементы, добавленные после заполнения таблицы, получают пустую геометрию
+    if (table.size() < entries.size())
+        table.resize(entries.size());
+    return table;
+}
+
+int SceneLayout::apply()
+{
+    if (dirtyEntries.isEmpty()) {
+        gridChanged = false;
+        return 0;
+    }
+    Table &table = currentTable();
+    int placed = 0;
+    for (int i : qAsConst(dirtyEntries)) {
+        Entry &entry = entries[i];
+        entry.dirty = false;
+        if (place(entry, table[i]))
+            ++placed;
+    }
+    dirtyEntries.clear();
+    gridChanged = false;
+    return placed;
+}
+
+bool SceneLayout::place(Entry &entry, Placement &cached)
+{
+    /// Если размещается кнопка или слайдер, то у них устанавливается размер
+    if (entry.control && entry.colSpan > 0)
+        entry.control->setSize(QSizeF(qRound(oneColSize * entry.colSpan), qRound(oneRowSize * entry.rowSpan)));
+
+    /// Область, занимаемая элементом
+    QRectF rect = entry.item->boundingRect();
+    /// Если ни сетка, ни размер элемента не изменились, позиция остаётся прежней
+    if (!gridChanged && rect.size() == entry.placedSize)
+        return false;
+    entry.placedSize = rect.size();
+
+    /// Позиция для этого разрешения и этого размера элемента уже вычислялась
+    if (cached.itemSize != rect.size()) {
+        /// Центр элемента совпадает с точкой (колонка,строка), округляется только итоговая позиция
+        cached.itemSize = rect.size();
+        cached.pos = QPointF(qRound(oneColSize * entry.col - rect.width() / 2),
+                             qRound(oneRowSize * entry.row - rect.height() / 2));
+    }
+    if (entry.item->pos() == cached.pos)
+        return false;
+    entry.item->setPos(cached.pos);
+    return true;
+}
@@ -0,0 +1,140 @@
+/**
+* @file
+* @brief Заголовочный файл раскладки элементов сцены
+*
+* Раскладка делит окно на условные колонки и строки и размещает элементы по координатам (колонка,строка).
+* Элемент переразмещается только если он помечен как изменённый и его размер действительно изменился,
+* либо изменилась сама сетка (разрешение окна).
+*
+* Размер ячейки дробный, округляются только итоговые позиции и размеры, поэтому ошибка округления
+* не накапливается к правому и нижнему краю окна. Вычисленная геометрия запоминается в таблице
+* для каждого разрешения: при возврате к уже встречавшемуся разрешению (изменение размера окна туда
+* и обратно, переключение стандартных разрешений) позиции берутся из таблицы.
+*/
+#ifndef SCENELAYOUT_H
+#define SCENELAYOUT_H
+
+#include <QGraphicsItem>
+#include "scenecontrols.h"
+#include <QHash>
+#include <QSize>
+#include <QVector>
+
+/**
+ * @class SceneLayout
+ * @brief Раскладка элементов с отслеживанием изменений
+ */
+class SceneLayout
+{
+public:
+    SceneLayout() = default;
+    /**
+     * @brief Установка сетки
+     * @param res Разрешение окна
+     * @param cols Общее количество колонок
+     * @param rows Общее количество строк
+     * @return true если разрешение изменилось. В этом случае все элементы помечаются как изменённые.
+     */
+    bool setGrid(const QSize &res, int cols, int rows);
+    /// @brief Ширина одной колонки
+    qreal colSize() const { return oneColSize; }
+    /// @brief Высота одной строки
+    qreal rowSize() const { return oneRowSize; }
+    /**
+     * @brief Добавление элемента в раскладку
+     * @param item Размещаемый элемент
+     * @param col Условная колонка центра элемента
+     * @param row Условная строка центра элемента
+     * @param colSpan Ширина элемента управления в колонках (0 - размер определяет сам элемент, например текст)
+     * @param rowSpan Высота элемента в строках
+     */
+    void addItem(QGraphicsItem *item, qint16 col, qint16 row, qint16 colSpan = 0, qint16 rowSpan = 0);
+    /**
+     * @brief Пометка элемента как изменённого
+     *
+     * Вызывается после изменения содержимого элемента (например текста), которое может изменить его размер.
+     * @param item Элемент
+     */
+    void invalidate(QGraphicsItem *item);
+    /**
+     * @brief Пометка всех элементов как изменённых
+     *
+     * При следующем apply() каждый элемент размещается заново, в том числе сдвинутый другим кодом
+     */
+    void invalidateAll();
+    /**
+     * @brief Размещение изменённых элементов
+     * @return Количество элементов, которым была задана новая позиция
+     */
+    int apply();
+
+    /// @brief Количество разрешений, для которых запомнена геометрия
+    int cachedResolutions() const { return tables.size(); }
+
+private:
+    /// Наибольшее количество запоминаемых разрешений
+    static constexpr int MAX_TABLES = 8;
+
+    /// @brief Геометрия элемента, вычисленная для одного разрешения
+    struct Placement {
+        /// Размер элемента, для которого вычислена позиция (недействителен, пока позиция не вычислена)
+        QSizeF itemSize;
+        /// Позиция элемента
+        QPointF pos;
+    };
+    /// @brief Геометрия всех элементов для одного разрешения, индекс - номер записи в entries
+    using Table = QVector<Placement>;
+
+    /// @brief Запись об одном элементе раскладки
+    struct Entry {
+        /// Размещаемый элемент
+        QGraphicsItem *item;
+        /// Тот же элемент, если это элемент управления (размер задаётся раскладкой)
+        SceneControl *control;
+        /// Условная колонка
+        qint16 col;
+        /// Условная строка
+        qint16 row;
+        /// Ширина в колонках
+        qint16 colSpan;
+        /// Высота в строках
+        qint16 rowSpan;
+        /// Размер элемента при последнем размещении
+        QSizeF placedSize;
+        /// Элемент помечен как изменённый
+        bool dirty;
+    };
+
+    /// Ширина одной колонки
+    qreal oneColSize = 0;
+    /// Высота одной строки
+    qreal oneRowSize = 0;
+    /// Текущее разрешение
+    QSize resolution;
+    /// Сетка изменилась с последнего размещения
+    bool gridChanged = true;
+    /// Все элементы раскладки
+    QVector<Entry> entries;
+    /// Индекс записи по элементу
+    QHash<QGraphicsItem*, int> index;
+    /// Индексы изменённых записей
+    QVector<int> dirtyEntries;
+    /// Геометрия по разрешениям
+    QHash<quint64, Table> tables;
+    /// Ключи таблиц в порядке использования, последний - текущее разрешение
+    QVector<quint64> tableOrder;
+
+    /// @brief Ключ таблицы для разрешения
+    static quint64 tableKey(const QSize &res) { return (quint64(quint32(res.width())) << 32) | quint32(res.height()); }
+    /// @brief Таблица текущего разрешения, дополненная до количества записей
+    Table &currentTable();
+    /**
+     * @brief Размещение одного элемента
+     * @param entry Запись об элементе
+     * @param cached Геометрия элемента для текущего разрешения
+     * @return true если позиция элемента была изменена
+     */
+    bool place(Entry &entry, Placement &cached);
+};
+
+#endif // SCENELAYOUT_H
@@ -0,0 +1,80 @@
+/**
+* @file
+* @brief Заголовочный файл интерфейса драйвера датчиков
+*
+* Драйвер - разделяемая библиотека (плагин Qt) с опросом датчиков одного производителя. Опрос
+* блокирующий: драйвер может ждать ответа от шины или прибора. Поэтому драйверы опрашиваются не
+* в GUI-потоке, а в общем пуле потоков DriverPool, каждый со своим интервалом.
+*
+* Плагин экспортирует объект, реализующий SensorDriverFactory:
+*
+*     class VendorFactory : public QObject, public SensorDriverFactory
+*     {
+*         Q_OBJECT
+*         Q_PLUGIN_METADATA(IID SensorDriverFactory_iid)
+*         Q_INTERFACES(SensorDriverFactory)
+*     public:
+*         QString vendor() const override { return "Vendor"; }
+*         SensorDriver *create(const QString &config) override { return new VendorDriver(config); }
+*     };
+*/
+#ifndef SENSORDRIVER_H
+#define SENSORDRIVER_H
+
+#include <QtPlugin>
+#include <QString>
+#include "sensorsource.h"
+
+/**
+ * @class SensorDriver
+ * @brief Драйвер датчиков
+ *
+ * Методы вызываются в потоках пула, но никогда одновременно для одного драйвера.
+ * Разные драйверы опрашиваются параллельно.
+ */
+class SensorDriver
+{
+public:
+    virtual ~SensorDriver() = default;
+    /**
+     * @brief Подготовка к опросу (открытие порта, инициализация прибора)
+     *
+     * Вызывается перед первым опросом в потоке пула
+     * @return false если драйвер не может работать, он больше не опрашивается
+     */
+    virtual bool open() = 0;
+    /**
+     * @brief Опрос датчиков
+     * @param out Отсчёты в базовых единицах (°C, %, мм рт.ст.); нулевое время заменяется временем опроса
+     * @param capacity Наибольшее количество отсчётов
+     * @return Количество записанных отсчётов
+     */
+    virtual int poll(SensorSample *out, int capacity) = 0;
+    /// @brief Интервал опроса, мс
+    virtual int interval() const = 0;
+    /// @brief Описание драйвера для сообщений в журнал
+    virtual QString description() const = 0;
+};
+
+/**
+ * @class SensorDriverFactory
+ * @brief Интерфейс плагина драйвера
+ */
+class SensorDriverFactory
+{
+public:
+    virtual ~SensorDriverFactory() = default;
+    /// @brief Производитель датчиков
+    virtual QString vendor() const = 0;
+    /**
+     * @brief Создание драйвера
+     * @param config Параметры драйвера из командной строки, формат определяет плагин
+     * @return nullptr если параметры не подходят
+     */
+    virtual SensorDriver *create(const QString &config) = 0;
+};
+
+#define SensorDriverFactory_iid "ru.eds.ac.SensorDriverFactory/1.0"
+Q_DECLARE_INTERFACE(SensorDriverFactory, SensorDriverFactory_iid)
+
+#endif // SENSORDRIVER_H
@@ -0,0 +1,99 @@
+#include "sensorhub.h"
+#include <QTimer>
+#include <QDebug>
+
+SensorHub::SensorHub(Preferences *prefs, QObject *parent)
+    : QObject(parent),
+    prefs(prefs)
+{
+    thread.setObjectName("SensorHub");
+    frameClock.start();
+}
+
+SensorHub::~SensorHub()
+{
+    stop();
+}
+
+void SensorHub::addSource(SensorSource *source)
+{
+    sources.append(source);
+    /// Источник и очередь находятся в одном рабочем потоке, поэтому соединение прямое
+    connect(source, &SensorSource::sampleReady, source, [this](const SensorSample &sample) {
+        push(sample);
+    }, Qt::DirectConnection);
+}
+
+void SensorHub::start()
+{
+    if (thread.isRunning() || sources.isEmpty())
+        return;
+    for (SensorSource *source : qAsConst(sources)) {
+        source->moveToThread(&thread);
+        /// Источники удаляются в своём потоке после его остановки
+        connect(&thread, &QThread::finished, source, &QObject::deleteLater);
+    }
+    thread.start();
+    /// Сокеты и таймеры источников создаются уже в рабочем потоке
+    for (SensorSource *source : qAsConst(sources)) {
+        QMetaObject::invokeMethod(source, [source]() {
+            if (!source->start())
+                qWarning() << "Sensor source failed to start:" << source->description();
+        }, Qt::QueuedConnection);
+    }
+}
+
+void SensorHub::stop()
+{
+    if (!thread.isRunning())
+        return;
+    thread.quit();
+    thread.wait();
+    sources.clear();
+}
+
+void SensorHub::push(const SensorSample &sample)
+{
+    if (!queue.push(sample)) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    /// Разбор очереди планируется один раз, пока GUI-поток его не выполнил
+    if (!drainPending.exchange(true, std::memory_order_acq_rel))
+        QMetaObject::invokeMethod(this, &SensorHub::drain, Qt::QueuedConnection);
+}
+
+void SensorHub::drain()
+{
+    /// Значения применяются не чаще одного раза за кадр, остальное время отсчёты копятся в очереди
+    qint64 sinceLast = frameClock.elapsed();
+    if (sinceLast < FRAMEINTERVAL) {
+        QTimer::singleShot(static_cast<int>(FRAMEINTERVAL - sinceLast), this, &SensorHub::drain);
+        return;
+    }
+    /// Флаг сбрасывается до разбора, чтобы отсчёт, пришедший во время разбора, запланировал новый
+    drainPending.store(false, std::memory_order_release);
+
+    /// В историю попадает каждый отсчёт, в настройки - только последнее значение каждой величины
+    bool has[SensorSample::ChannelCount] = {false, false, false};
+    qreal last[SensorSample::ChannelCount] = {0, 0, 0};
+    SensorSample sample;
+    while (queue.pop(sample)) {
+        has[sample.channel] = true;
+        last[sample.channel] = sample.value;
+        histories[sample.channel].append(sample.value, sample.timestamp);
+    }
+    if (!has[SensorSample::Temperature] && !has[SensorSample::Humidity] && !has[SensorSample::Pressure])
+        return;
+
+    /// Все величины записываются одним пакетом: каждый элемент интерфейса обновится не больше одного раза
+    Preferences::Transaction transaction(prefs);
+    if (has[SensorSample::Temperature])
+        prefs->setTempValCelsius(last[SensorSample::Temperature]);
+    if (has[SensorSample::Humidity])
+        prefs->setHumidityVal(last[SensorSample::Humidity]);
+    if (has[SensorSample::Pressure])
+        prefs->setPressureValMmHg(last[SensorSample::Pressure]);
+    frameClock.restart();
+    emit applied();
+}
@@ -0,0 +1,95 @@
+/**
+* @file
+* @brief Заголовочный файл приёма данных датчиков
+*
+* Источники данных работают в отдельном рабочем потоке и складывают отсчёты в очередь без блокировок.
+* В GUI-потоке отсчёты забираются не чаще одного раза за кадр: все отсчёты попадают в историю величины,
+* последнее значение записывается в Preferences одной транзакцией, после чего испускается сигнал applied().
+*/
+#ifndef SENSORHUB_H
+#define SENSORHUB_H
+
+#include <QObject>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QList>
+#include <atomic>
+#include "sensorsource.h"
+#include "spscqueue.h"
+#include "preferences.h"
+#include "measurementhistory.h"
+
+/**
+ * @class SensorHub
+ * @brief Приём данных от источников и применение их к пользовательским настройкам
+ */
+class SensorHub : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @param prefs Пользовательские настройки, в которые записываются значения
+     * @param parent Родительский объект
+     */
+    explicit SensorHub(Preferences *prefs, QObject *parent = nullptr);
+    ~SensorHub() override;
+    /**
+     * @brief Добавление источника
+     *
+     * Вызывается до start(). Хаб становится владельцем источника.
+     * @param source Источник без родителя
+     */
+    void addSource(SensorSource *source);
+    /// @brief Запуск рабочего потока и всех источников
+    void start();
+    /// @brief Остановка источников и рабочего потока
+    void stop();
+    /// @brief Есть ли хотя бы один источник
+    bool hasSources() const { return !sources.isEmpty(); }
+    /// @brief Количество отсчётов, отброшенных из-за переполнения очереди
+    quint64 droppedSamples() const { return dropped.load(std::memory_order_relaxed); }
+    /**
+     * @brief История величины
+     *
+     * Заполняется в GUI-потоке всеми отсчётами, а не только последними за кадр
+     * @param channel Величина
+     */
+    const MeasurementHistory &history(SensorSample::Channel channel) const { return histories[channel]; }
+
+signals:
+    /// @brief Новые значения записаны в пользовательские настройки и историю
+    void applied();
+
+private:
+    /// Минимальный интервал между применениями, мс (один кадр при 60 Гц)
+    static constexpr int FRAMEINTERVAL = 16;
+    /// Ёмкость очереди отсчётов
+    static constexpr std::size_t QUEUESIZE = 1024;
+
+    /// Пользовательские настройки
+    Preferences *prefs;
+    /// Рабочий поток источников
+    QThread thread;
+    /// Источники данных
+    QList<SensorSource*> sources;
+    /// Очередь отсчётов: пишет рабочий поток, читает GUI-поток
+    SpscQueue<SensorSample, QUEUESIZE> queue;
+    /// Разбор очереди уже запланирован
+    std::atomic<bool> drainPending{false};
+    /// Количество отброшенных отсчётов
+    std::atomic<quint64> dropped{0};
+    /// Время последнего применения значений
+    QElapsedTimer frameClock;
+    /// История каждой величины
+    MeasurementHistory histories[SensorSample::ChannelCount];
+
+    /**
+     * @brief Добавление отсчёта в очередь (рабочий поток)
+     * @param sample Отсчёт
+     */
+    void push(const SensorSample &sample);
+    /// @brief Разбор очереди и применение последних значений (GUI-поток)
+    void drain();
+};
+
+#endif // SENSORHUB_H
@@ -0,0 +1,195 @@
+#include "sensorsource.h"
+#include <QDateTime>
+#include <QFileInfo>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QNetworkDatagram>
+#include <QtNumeric>
+#include <QTimer>
+#include <QUdpSocket>
+#ifndef Q_OS_WIN
+#include <sys/stat.h>
+#endif
+
+namespace {
+/**
+ * @brief Идентификатор файла по пути
+ * @return Устройство и inode, на Windows - время создания; (0, 0), если файла нет
+ */
+QPair<quint64, quint64> fileIdentity(const QString &path)
+{
+#ifdef Q_OS_WIN
+    QFileInfo info(path);
+    if (!info.exists())
+        return {0, 0};
+    return {1, quint64(info.birthTime().toMSecsSinceEpoch())};
+#else
+    struct stat st;
+    if (::stat(QFile::encodeName(path).constData(), &st) != 0)
+        return {0, 0};
+    return {quint64(st.st_dev), quint64(st.st_ino)};
+#endif
+}
+}
+
+SensorSource::SensorSource(QObject *parent)
+    : QObject(parent)
+{
+}
+
+int SensorSource::parseLine(const QByteArray &line)
+{
+    int count = 0;
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    /// Пары "ключ=значение" разделяются пробелами или ';'
+    const QList<QByteArray> tokens = QByteArray(line).replace(';', ' ').simplified().split(' ');
+    for (const QByteArray &token : tokens) {
+        int eq = token.indexOf('=');
+        if (eq <= 0)
+            continue;
+        bool ok = false;
+        qreal value = token.mid(eq + 1).toDouble(&ok);
+        /// toDouble() принимает "nan" и "inf", такие значения не являются показаниями
+        if (!ok || !qIsFinite(value))
+            continue;
+        /// Ключ определяется по первой букве: t, h, p
+        SensorSample sample{SensorSample::Temperature, value, now};
+        switch (token.at(0)) {
+        case 't': case 'T':
+            sample.channel = SensorSample::Temperature;
+            break;
+        case 'h': case 'H':
+            sample.channel = SensorSample::Humidity;
+            break;
+        case 'p': case 'P':
+            sample.channel = SensorSample::Pressure;
+            break;
+        default:
+            continue;
+        }
+        emit sampleReady(sample);
+        ++count;
+    }
+    return count;
+}
+
+UdpSensorSource::UdpSensorSource(quint16 port)
+    : port(port)
+{
+}
+
+bool UdpSensorSource::start()
+{
+    socket = new QUdpSocket(this);
+    /// Принимаются только локальные датаграммы
+    if (!socket->bind(QHostAddress::LocalHost, port))
+        return false;
+    connect(socket, &QUdpSocket::readyRead, this, &UdpSensorSource::readDatagrams);
+    return true;
+}
+
+QString UdpSensorSource::description() const
+{
+    return QString("udp://127.0.0.1:%1").arg(port);
+}
+
+void UdpSensorSource::readDatagrams()
+{
+    while (socket->hasPendingDatagrams()) {
+        const QByteArray data = socket->receiveDatagram().data();
+        for (const QByteArray &line : data.split('\n'))
+            parseLine(line);
+    }
+}
+
+LocalSocketSensorSource::LocalSocketSensorSource(const QString &name)
+    : name(name)
+{
+}
+
+bool LocalSocketSensorSource::start()
+{
+    server = new QLocalServer(this);
+    /// Сокет, оставшийся после аварийного завершения, удаляется
+    QLocalServer::removeServer(name);
+    if (!server->listen(name))
+        return false;
+    connect(server, &QLocalServer::newConnection, this, &LocalSocketSensorSource::acceptConnections);
+    return true;
+}
+
+QString LocalSocketSensorSource::description() const
+{
+    return QString("local://%1").arg(name);
+}
+
+void LocalSocketSensorSource::acceptConnections()
+{
+    while (QLocalSocket *client = server->nextPendingConnection()) {
+        connect(client, &QLocalSocket::readyRead, this, [this, client]() {
+            while (client->canReadLine())
+                parseLine(client->readLine());
+        });
+        connect(client, &QLocalSocket::disconnected, client, &QObject::deleteLater);
+    }
+}
+
+FileSensorSource::FileSensorSource(const QString &path)
+    : path(path)
+{
+}
+
+bool FileSensorSource::start()
+{
+    file.setFileName(path);
+    /// Как и tail -f, из уже существующего файла читаются только новые строки.
+    /// Файла может ещё не быть: poll() откроет его, когда он появится, и прочитает с начала
+    if (file.open(QIODevice::ReadOnly)) {
+        opened = fileIdentity(path);
+        file.seek(file.size());
+    }
+    timer = new QTimer(this);
+    connect(timer, &QTimer::timeout, this, &FileSensorSource::poll);
+    timer->start(POLLINTERVAL);
+    return true;
+}
+
+QString FileSensorSource::description() const
+{
+    return QString("file://%1").arg(path);
+}
+
+void FileSensorSource::poll()
+{
+    QPair<quint64, quint64> identity = fileIdentity(path);
+    /// Путь указывает на другой файл (ротация): строки, дописанные в старый, дочитываются.
+    /// Пока нового файла нет, читается старый
+    bool replaced = identity.first && identity != opened;
+    if (replaced)
+        readLines();
+    /// Файл заменили или усекли - чтение начинается сначала
+    if (replaced || !file.isOpen() || QFile(path).size() < file.pos()) {
+        file.close();
+        pending.clear();
+        if (!file.open(QIODevice::ReadOnly))
+            return;
+        /// Файл мог появиться между проверкой и открытием
+        opened = identity.first ? identity : fileIdentity(path);
+    }
+    readLines();
+}
+
+void FileSensorSource::readLines()
+{
+    if (!file.isOpen() || file.atEnd())
+        return;
+
+    pending += file.readAll();
+    int start = 0;
+    int end;
+    while ((end = pending.indexOf('\n', start)) >= 0) {
+        parseLine(pending.mid(start, end - start));
+        start = end + 1;
+    }
+    pending.remove(0, start);
+}
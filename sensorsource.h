@@ -0,0 +1,168 @@
+/**
+* @file
+* @brief Заголовочный файл источников данных датчиков
+*
+* Источник принимает показания внешней температуры, влажности и давления и выдаёт их в виде отдельных отсчётов.
+* Все источники работают в рабочем потоке SensorHub.
+*
+* Формат данных - текстовые строки из пар "ключ=значение", разделённых пробелами или ';':
+*
+*     t=21.5 h=45 p=760
+*
+* Ключи: t (температура, °C), h (влажность, %), p (давление, мм рт.ст.).
+*/
+#ifndef SENSORSOURCE_H
+#define SENSORSOURCE_H
+
+#include <QObject>
+#include <QFile>
+#include <QString>
+#include <QPair>
+#include <QMetaType>
+
+class QUdpSocket;
+class QLocalServer;
+class QTimer;
+
+/**
+ * @struct SensorSample
+ * @brief Один отсчёт датчика
+ *
+ * Значения передаются в базовых единицах: °C, %, мм рт.ст.
+ */
+struct SensorSample {
+    /// Измеряемые величины
+    enum Channel : quint8 {
+        Temperature,
+        Humidity,
+        Pressure,
+        ChannelCount
+    };
+    /// Измеряемая величина
+    Channel channel;
+    /// Значение в базовых единицах
+    qreal value;
+    /// Время получения, мс с начала эпохи
+    qint64 timestamp;
+};
+Q_DECLARE_METATYPE(SensorSample)
+
+/**
+ * @class SensorSource
+ * @brief Базовый класс источника данных
+ */
+class SensorSource : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SensorSource(QObject *parent = nullptr);
+    /**
+     * @brief Запуск источника
+     *
+     * Вызывается уже в рабочем потоке, поэтому сокеты и таймеры создаются здесь, а не в конструкторе.
+     * @return true если источник запущен
+     */
+    virtual bool start() = 0;
+    /// @brief Описание источника для сообщений в журнал
+    virtual QString description() const = 0;
+
+signals:
+    /// @brief Получен новый отсчёт
+    void sampleReady(const SensorSample &sample);
+
+protected:
+    /**
+     * @brief Разбор одной строки данных
+     * Пары с нечисловыми, бесконечными и NaN значениями пропускаются
+     * @param line Строка формата "t=21.5 h=45 p=760"
+     * @return Количество выданных отсчётов
+     */
+    int parseLine(const QByteArray &line);
+};
+
+/**
+ * @class UdpSensorSource
+ * @brief Приём данных по UDP на локальном интерфейсе
+ *
+ * Каждая датаграмма может содержать одну или несколько строк.
+ */
+class UdpSensorSource : public SensorSource
+{
+    Q_OBJECT
+public:
+    /// @param port UDP-порт на 127.0.0.1
+    explicit UdpSensorSource(quint16 port);
+    bool start() override;
+    QString description() const override;
+
+private:
+    /// Порт
+    quint16 port;
+    /// Сокет, создаётся в рабочем потоке
+    QUdpSocket *socket = nullptr;
+    /// @brief Чтение всех пришедших датаграмм
+    void readDatagrams();
+};
+
+/**
+ * @class LocalSocketSensorSource
+ * @brief Приём данных через локальный сокет (Unix domain socket, на Windows - именованный канал)
+ *
+ * Допускается несколько одновременных подключений.
+ */
+class LocalSocketSensorSource : public SensorSource
+{
+    Q_OBJECT
+public:
+    /// @param name Имя или путь сокета
+    explicit LocalSocketSensorSource(const QString &name);
+    bool start() override;
+    QString description() const override;
+
+private:
+    /// Имя сокета
+    QString name;
+    /// Сервер, создаётся в рабочем потоке
+    QLocalServer *server = nullptr;
+    /// @brief Приём новых подключений
+    void acceptConnections();
+};
+
+/**
+ * @class FileSensorSource
+ * @brief Чтение строк, дописываемых в конец файла (аналог tail -f)
+ *
+ * При усечении файла чтение начинается с начала. Замена файла (ротация журнала) определяется
+ * по устройству и inode (на Windows - по времени создания): старый файл дочитывается, новый
+ * читается с начала. Если при запуске файла ещё нет, он открывается, когда появится, и тоже
+ * читается с начала.
+ */
+class FileSensorSource : public SensorSource
+{
+    Q_OBJECT
+public:
+    /// @param path Путь к файлу
+    explicit FileSensorSource(const QString &path);
+    bool start() override;
+    QString description() const override;
+
+private:
+    /// Интервал проверки файла, мс
+    static constexpr int POLLINTERVAL = 20;
+    /// Путь к файлу
+    QString path;
+    /// Файл
+    QFile file;
+    /// Таймер проверки файла, создаётся в рабочем потоке
+    QTimer *timer = nullptr;
+    /// Недочитанный хвост последней строки
+    QByteArray pending;
+    /// Идентификатор открытого файла
+    QPair<quint64, quint64> opened;
+    /// @brief Проверка замены файла и чтение новых строк
+    void poll();
+    /// @brief Разбор строк, дописанных в открытый файл
+    void readLines();
+};
+
+#endif // SENSORSOURCE_H
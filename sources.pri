@@ -0,0 +1,32 @@
+# Общие исходники приложения (всё, кроме точки входа main.cpp).
+# Подключаются основным проектом и проектом бенчмарков.
+
+include(core.pri)
+
+SOURCES += \
+    $$PWD/fleetscene.cpp \
+    $$PWD/huditem.cpp \
+    $$PWD/inputdialog.cpp \
+    $$PWD/mainscene.cpp \
+    $$PWD/mainview.cpp \
+    $$PWD/readoutitem.cpp \
+    $$PWD/scenecontrols.cpp \
+    $$PWD/scenelayout.cpp \
+    $$PWD/sparklineitem.cpp \
+    $$PWD/staticlayer.cpp \
+    $$PWD/themeengine.cpp \
+    $$PWD/vaneanimator.cpp
+
+HEADERS += \
+    $$PWD/fleetscene.h \
+    $$PWD/huditem.h \
+    $$PWD/inputdialog.h \
+    $$PWD/mainscene.h \
+    $$PWD/mainview.h \
+    $$PWD/readoutitem.h \
+    $$PWD/scenecontrols.h \
+    $$PWD/scenelayout.h \
+    $$PWD/sparklineitem.h \
+    $$PWD/staticlayer.h \
+    $$PWD/themeengine.h \
+    $$PWD/vaneanimator.h
@@ -0,0 +1,123 @@
+#include "sparklineitem.h"
+#include <QPainter>
+#include <cmath>
+
+SparklineItem::SparklineItem(const MeasurementHistory *history, qreal minValue, qreal maxValue, QGraphicsItem *parent)
+    : QGraphicsItem(parent),
+    history(history),
+    minValue(minValue),
+    maxValue(maxValue)
+{
+}
+
+void SparklineItem::setSize(const QSizeF &size)
+{
+    if (this->size == size)
+        return;
+    prepareGeometryChange();
+    this->size = size;
+    redraw();
+}
+
+void SparklineItem::setPen(const QPen &pen)
+{
+    if (this->pen == pen)
+        return;
+    this->pen = pen;
+    redraw();
+}
+
+void SparklineItem::refresh()
+{
+    quint64 total = history->buckets().total();
+    if (total == drawn)
+        return;
+    int width = pixmap.width();
+    quint64 added = total - drawn;
+    /// Если новых интервалов больше, чем помещается на графике, он перерисовывается целиком
+    if (pixmap.isNull() || added * STEP >= quint64(width)) {
+        redraw();
+        return;
+    }
+
+    /// Старая часть графика сдвигается влево, освободившаяся полоса очищается
+    int shift = static_cast<int>(added) * STEP;
+    pixmap.scroll(-shift, 0, pixmap.rect());
+    QPainter painter(&pixmap);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.fillRect(QRect(width - shift, 0, shift, pixmap.height()), Qt::transparent);
+    painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(pen);
+    /// Дорисовываются только новые отрезки, начиная с отрезка от последнего нарисованного интервала
+    quint64 from = drawn;
+    drawn = total;
+    drawSegments(painter, from, total);
+    painter.end();
+    update();
+}
+
+void SparklineItem::redraw()
+{
+    drawn = history->buckets().total();
+    QSize pixSize = size.toSize();
+    if (pixSize.isEmpty()) {
+        pixmap = QPixmap();
+        update();
+        return;
+    }
+    pixmap = QPixmap(pixSize);
+    pixmap.fill(Qt::transparent);
+
+    /// Рисуются только интервалы, которые помещаются на графике
+    quint64 visible = quint64(pixSize.width() / STEP) + 1;
+    quint64 from = drawn > visible ? drawn - visible : 0;
+    QPainter painter(&pixmap);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(pen);
+    drawSegments(painter, from, drawn);
+    painter.end();
+    update();
+}
+
+void SparklineItem::drawSegments(QPainter &painter, quint64 from, quint64 to) const
+{
+    const RingBuffer<float> &buckets = history->buckets();
+    for (quint64 i = qMax<quint64>(from, 1); i < to; ++i) {
+        if (!buckets.contains(i - 1) || !buckets.contains(i))
+            continue;
+        float prev = buckets.at(i - 1);
+        float cur = buckets.at(i);
+        /// Интервалы без данных оставляют разрыв
+        if (std::isnan(prev) || std::isnan(cur))
+            continue;
+        painter.drawLine(QPointF(xFor(i - 1), yFor(prev)), QPointF(xFor(i), yFor(cur)));
+    }
+}
+
+qreal SparklineItem::xFor(quint64 index) const
+{
+    /// Самый новый интервал находится у правого края
+    return pixmap.width() - 1 - qreal(drawn - 1 - index) * STEP;
+}
+
+qreal SparklineItem::yFor(float value) const
+{
+    qreal range = maxValue - minValue;
+    qreal ratio = range > 0 ? qBound(0.0, (value - minValue) / range, 1.0) : 0.5;
+    qreal margin = pen.widthF() / 2;
+    return margin + (1.0 - ratio) * (pixmap.height() - 2 * margin);
+}
+
+QRectF SparklineItem::boundingRect() const
+{
+    return QRectF(QPointF(0, 0), size);
+}
+
+void SparklineItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(option);
+    Q_UNUSED(widget);
+    if (!pixmap.isNull())
+        painter->drawPixmap(0, 0, pixmap);
+}
@@ -0,0 +1,78 @@
+/**
+* @file
+* @brief Заголовочный файл графика истории измерений
+*
+* Маленький график последних значений величины. График хранится в собственном растре:
+* при появлении новых интервалов растр сдвигается влево и дорисовываются только новые отрезки.
+*/
+#ifndef SPARKLINEITEM_H
+#define SPARKLINEITEM_H
+
+#include <QGraphicsItem>
+#include <QPixmap>
+#include <QPen>
+#include "measurementhistory.h"
+
+/**
+ * @class SparklineItem
+ * @brief Элемент сцены с графиком истории одной величины
+ */
+class SparklineItem : public QGraphicsItem
+{
+public:
+    /// Тип элемента для qgraphicsitem_cast
+    enum { Type = UserType + 2 };
+
+    /**
+     * @param history История величины
+     * @param minValue Значение, соответствующее нижней границе графика (в базовых единицах)
+     * @param maxValue Значение, соответствующее верхней границе графика
+     * @param parent Родительский элемент
+     */
+    SparklineItem(const MeasurementHistory *history, qreal minValue, qreal maxValue, QGraphicsItem *parent = nullptr);
+    /// @brief Установка размера, график перерисовывается целиком
+    void setSize(const QSizeF &size);
+    /// @brief Установка пера линии, график перерисовывается целиком
+    void setPen(const QPen &pen);
+    /// @brief Дорисовка интервалов, появившихся с прошлого вызова
+    void refresh();
+
+    QRectF boundingRect() const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+    int type() const override { return Type; }
+
+private:
+    /// Ширина одного интервала на графике, пикселей
+    static constexpr int STEP = 1;
+
+    /// История величины
+    const MeasurementHistory *history;
+    /// Нижняя граница графика
+    qreal minValue;
+    /// Верхняя граница графика
+    qreal maxValue;
+    /// Размер элемента
+    QSizeF size;
+    /// Перо линии
+    QPen pen;
+    /// Растр с графиком
+    QPixmap pixmap;
+    /// Количество интервалов истории, уже нарисованных на растре
+    quint64 drawn = 0;
+
+    /// @brief Полная перерисовка растра
+    void redraw();
+    /**
+     * @brief Рисование отрезков между интервалами
+     * @param painter Рисовальщик растра
+     * @param from Абсолютный номер первого интервала
+     * @param to Абсолютный номер интервала после последнего
+     */
+    void drawSegments(QPainter &painter, quint64 from, quint64 to) const;
+    /// @brief Координата X интервала с абсолютным номером (последний нарисованный интервал - у правого края)
+    qreal xFor(quint64 index) const;
+    /// @brief Координата Y значения
+    qreal yFor(float value) const;
+};
+
+#endif // SPARKLINEITEM_H
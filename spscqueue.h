@@ -0,0 +1,67 @@
+/**
+* @file
+* @brief Заголовочный файл очереди "один писатель - один читатель"
+*
+* Очередь фиксированного размера без блокировок. Один поток только пишет, другой только читает.
+*/
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+/**
+ * @class SpscQueue
+ * @brief Кольцевая очередь без блокировок для одного писателя и одного читателя
+ * @tparam T Тип элемента (рекомендуется простой тип без динамической памяти)
+ * @tparam Capacity Ёмкость очереди, степень двойки
+ */
+template <typename T, std::size_t Capacity>
+class SpscQueue
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    /**
+     * @brief Добавление элемента (только поток-писатель)
+     * @param value Элемент
+     * @return false если очередь заполнена, элемент при этом не добавляется
+     */
+    bool push(const T &value)
+    {
+        std::size_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == Capacity)
+            return false;
+        buffer[h & (Capacity - 1)] = value;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Извлечение элемента (только поток-читатель)
+     * @param value Извлечённый элемент
+     * @return false если очередь пуста
+     */
+    bool pop(T &value)
+    {
+        std::size_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire))
+            return false;
+        value = buffer[t & (Capacity - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// @brief Пуста ли очередь (значение может устареть сразу после вызова)
+    bool isEmpty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+
+private:
+    /// Индекс записи, меняет только писатель. Счётчики разнесены по разным кэш-линиям.
+    alignas(64) std::atomic<std::size_t> head{0};
+    /// Индекс чтения, меняет только читатель
+    alignas(64) std::atomic<std::size_t> tail{0};
+    /// Элементы очереди
+    alignas(64) T buffer[Capacity];
+};
+
+#endif // SPSCQUEUE_H
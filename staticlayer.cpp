@@ -0,0 +1,154 @@
+#include "staticlayer.h"
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QGraphicsTextItem>
+#include <QGraphicsPolygonItem>
+#include <QGuiApplication>
+#include <QPixmapCache>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QBuffer>
+#include <QSaveFile>
+#include <QFile>
+#include <QDir>
+#include <QDateTime>
+#include <QDebug>
+
+StaticLayer::StaticLayer(QGraphicsItem *parent)
+    : QGraphicsItem(parent)
+{
+    /// Слой под всеми элементами и не перехватывает нажатия
+    setZValue(-1);
+    setAcceptedMouseButtons(Qt::NoButton);
+    /// Рисуется только открытая часть изображения
+    setFlag(ItemUsesExtendedStyleOption);
+}
+
+void StaticLayer::setItems(const QList<QGraphicsItem*> &items)
+{
+    for (auto item : qAsConst(this->items))
+        item->setVisible(true);
+    this->items = items;
+    dirty = true;
+}
+
+void StaticLayer::suspend()
+{
+    dirty = true;
+    if (pixmap.isNull())
+        return;
+    pixmap = QPixmap();
+    for (auto item : qAsConst(items))
+        item->setVisible(true);
+    update();
+}
+
+QRectF StaticLayer::boundingRect() const
+{
+    return QRectF(QPointF(0, 0), layerSize);
+}
+
+void StaticLayer::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(widget);
+    if (pixmap.isNull())
+        return;
+    /// Координаты изображения в пикселях устройства
+    qreal dpr = pixmap.devicePixelRatio();
+    QRectF exposed = option->exposedRect & boundingRect();
+    QRectF source(exposed.topLeft() * dpr, exposed.size() * dpr);
+    painter->drawPixmap(exposed, pixmap, source);
+}
+
+bool StaticLayer::rebuild(const QSize &size, const QBrush &background)
+{
+    dirty = false;
+    qreal dpr = qGuiApp ? qGuiApp->devicePixelRatio() : 1.0;
+    QString key = contentKey(size, background, dpr);
+    QString memoryKey = "staticlayer:" + key;
+    bool rendered = false;
+
+    QPixmap image;
+    /// Изображение уже встречалось в этом запуске
+    if (!QPixmapCache::find(memoryKey, &image)) {
+        /// Изображение сохранено одним из предыдущих запусков
+        QString filename = cacheDir.isEmpty() ? QString() : QDir(cacheDir).filePath(key + ".png");
+        if (filename.isEmpty() || !image.load(filename, "PNG") || image.size() != size * dpr) {
+            image = render(size, background, dpr);
+            rendered = true;
+            if (!filename.isEmpty())
+                store(filename, image);
+        } else {
+            image.setDevicePixelRatio(dpr);
+            /// Время изменения файла - время последнего использования, по нему удаляются устаревшие
+            QFile file(filename);
+            if (file.open(QIODevice::ReadWrite))
+                file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+        }
+        QPixmapCache::insert(memoryKey, image);
+    }
+
+    if (layerSize != size)
+        prepareGeometryChange();
+    layerSize = size;
+    pixmap = image;
+    /// Исходные элементы больше не рисуются сами, их вид уже в слое
+    for (auto item : qAsConst(items))
+        item->setVisible(false);
+    update();
+    return rendered;
+}
+
+QString StaticLayer::contentKey(const QSize &size, const QBrush &background, qreal dpr) const
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    QDataStream out(&buffer);
+    out << VERSION << size << dpr << background;
+    for (auto item : qAsConst(items)) {
+        out << item->type() << item->sceneTransform() << item->boundingRect() << item->opacity();
+        if (auto text = qgraphicsitem_cast<QGraphicsTextItem*>(item))
+            out << text->toPlainText() << text->font() << text->defaultTextColor();
+        else if (auto polygon = qgraphicsitem_cast<QGraphicsPolygonItem*>(item))
+            out << polygon->polygon() << polygon->pen() << polygon->brush();
+    }
+    return QString::fromLatin1(QCryptographicHash::hash(buffer.data(), QCryptographicHash::Sha1).toHex());
+}
+
+QPixmap StaticLayer::render(const QSize &size, const QBrush &background, qreal dpr) const
+{
+    QPixmap image(size * dpr);
+    image.setDevicePixelRatio(dpr);
+    QPainter painter(&image);
+    painter.fillRect(QRect(QPoint(0, 0), size), background);
+    /// Элементы рисуются так же, как их нарисовала бы сцена: в своих координатах с учётом положения
+    for (auto item : qAsConst(items)) {
+        QStyleOptionGraphicsItem option;
+        option.exposedRect = item->boundingRect();
+        option.rect = option.exposedRect.toAlignedRect();
+        painter.save();
+        painter.setTransform(item->sceneTransform(), true);
+        painter.setOpacity(item->opacity());
+        item->paint(&painter, &option, nullptr);
+        painter.restore();
+    }
+    return image;
+}
+
+void StaticLayer::store(const QString &filename, const QPixmap &image) const
+{
+    QDir dir(cacheDir);
+    if (!dir.mkpath(".")) {
+        qWarning() << "Static layer cache directory is not writable:" << cacheDir;
+        return;
+    }
+    QSaveFile file(filename);
+    if (!file.open(QIODevice::WriteOnly) || !image.save(&file, "PNG") || !file.commit()) {
+        qWarning() << "Failed to write static layer cache" << filename;
+        return;
+    }
+    /// Изображения устаревших состояний (старые темы, разрешения) удаляются, начиная с самых давних
+    QFileInfoList files = dir.entryInfoList(QStringList("*.png"), QDir::Files, QDir::Time);
+    for (int i = MAX_FILES; i < files.size(); ++i)
+        QFile::remove(files[i].absoluteFilePath());
+}
@@ -0,0 +1,100 @@
+/**
+* @file
+* @brief Заголовочный файл растрового слоя неизменяемых элементов
+*
+* Заголовки блоков, подпись кнопки питания, корпус кондиционера и фон меняются только при смене
+* разрешения, темы или питания. Для каждого такого состояния они один раз рисуются в растровое
+* изображение, которое показывается одним элементом под остальными. Исходные элементы остаются
+* в сцене (их размещает раскладка), но скрываются.
+*
+* Изображение ищется сначала в QPixmapCache, затем на диске по хэшу содержимого (разрешение, тексты,
+* шрифты, цвета, позиции), и только если его нет нигде - рисуется заново и записывается на диск.
+* Поэтому уже при первом кадре после запуска неизменяемая часть интерфейса - одно копирование изображения.
+* Во время изменения размера окна слой приостанавливается (suspend()) и видны исходные элементы,
+* чтобы промежуточные размеры не рисовались и не вытесняли из каталога кэша полезные изображения.
+*/
+#ifndef STATICLAYER_H
+#define STATICLAYER_H
+
+#include <QGraphicsItem>
+#include <QPixmap>
+#include <QBrush>
+#include <QList>
+#include <QString>
+
+/**
+ * @class StaticLayer
+ * @brief Элемент сцены с растровым изображением неизменяемых элементов
+ */
+class StaticLayer : public QGraphicsItem
+{
+public:
+    /// Тип элемента для qgraphicsitem_cast
+    enum { Type = UserType + 7 };
+    /// Каталог кэша по умолчанию (относительно рабочего каталога, как и файлы настроек)
+    inline static const QString CACHEDIR = "staticcache";
+    /// Наибольшее количество изображений в каталоге кэша
+    static constexpr int MAX_FILES = 32;
+
+    explicit StaticLayer(QGraphicsItem *parent = nullptr);
+    /**
+     * @brief Установка элементов, которые рисуются в слой
+     *
+     * Элементы скрываются, пока слой готов
+     * @param items Элементы в порядке отрисовки
+     */
+    void setItems(const QList<QGraphicsItem*> &items);
+    /**
+     * @brief Каталог кэша на диске
+     * @param dir Каталог, пустая строка отключает кэш на диске
+     */
+    void setCacheDir(const QString &dir) { cacheDir = dir; }
+    /// @brief Пометка слоя как устаревшего, изображение будет выбрано заново при rebuild()
+    void invalidate() { dirty = true; }
+    /// @brief Слой устарел
+    bool isDirty() const { return dirty; }
+    /// @brief Размер сцены, для которого выбрано изображение
+    QSize size() const { return layerSize; }
+    /**
+     * @brief Показ исходных элементов вместо изображения
+     *
+     * Пока размер сцены меняется, каждый шаг - новое изображение, которое не пригодится.
+     * Слой помечается устаревшим, изображение выбирается при следующем rebuild().
+     */
+    void suspend();
+    /**
+     * @brief Выбор изображения для текущего состояния
+     * @param size Размер сцены
+     * @param background Фон сцены
+     * @return true если изображение было нарисовано заново (его не было ни в памяти, ни на диске)
+     */
+    bool rebuild(const QSize &size, const QBrush &background);
+
+    QRectF boundingRect() const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+    int type() const override { return Type; }
+
+private:
+    /// Версия формата ключа, увеличивается при изменении отрисовки слоя
+    static constexpr quint32 VERSION = 1;
+
+    /// Элементы слоя
+    QList<QGraphicsItem*> items;
+    /// Каталог кэша на диске
+    QString cacheDir = CACHEDIR;
+    /// Изображение слоя
+    QPixmap pixmap;
+    /// Размер слоя в координатах сцены
+    QSize layerSize;
+    /// Слой устарел
+    bool dirty = true;
+
+    /// @brief Хэш содержимого слоя: всё, от чего зависит изображение
+    QString contentKey(const QSize &size, const QBrush &background, qreal dpr) const;
+    /// @brief Отрисовка слоя
+    QPixmap render(const QSize &size, const QBrush &background, qreal dpr) const;
+    /// @brief Запись изображения в каталог кэша с удалением самых старых файлов
+    void store(const QString &filename, const QPixmap &image) const;
+};
+
+#endif // STATICLAYER_H
@@ -8,16 +8,10 @@ CONFIG += c++17
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
-SOURCES += \
-    inputdialog.cpp \
-    main.cpp \
-    mainscene.cpp \
-    preferences.cpp
+include(sources.pri)
 
-HEADERS += \
-    inputdialog.h \
-    mainscene.h \
-    preferences.h
+SOURCES += \
+    main.cpp
 
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
@@ -0,0 +1,70 @@
+#include "themeengine.h"
+#include "mainscene.h"
+
+/// Ширина рамок кнопок, слайдера и корпуса кондиционера
+static constexpr int BORDERWIDTH = 2;
+/// Ширина линии направления воздуха
+static constexpr int ACLINEWIDTH = 8;
+/// Ширина ручки слайдера
+static constexpr int HANDLEWIDTH = 50;
+/// Ширина линии графиков истории
+static constexpr int SPARKLINEWIDTH = 2;
+
+ThemeEngine::ThemeEngine()
+{
+    /// Палитры собираются один раз, дальше используются только ссылки на них
+    for (int dark = 0; dark < 2; ++dark)
+        for (int power = 0; power < 2; ++power)
+            palettes[dark * 2 + power] = compile(dark, power);
+}
+
+ThemePalette ThemeEngine::compile(bool dark, bool power)
+{
+    using Clr = MainScene::ItemColor;
+    ThemePalette pal;
+
+    /// Фон и текст
+    pal.background = QBrush(dark ? Clr::CLR_bgDark : Clr::CLR_bgLight);
+    pal.text = power ?
+        (dark ? Clr::CLR_textDark_ON : Clr::CLR_textLight_ON) :
+        (dark ? Clr::CLR_textDark_OFF : Clr::CLR_textLight_OFF);
+    pal.textActive = dark ? Clr::CLR_textDark_ON : Clr::CLR_textLight_ON;
+
+    /// Кнопки. Кнопка питания всегда выглядит "включенной".
+    /// Состояние нажатия собирается вместе с палитрой, при нажатии кнопка только выбирает другую кисть
+    QBrush pressed(Clr::CLR_buttonPressed);
+    ButtonStyle buttonOn = dark ?
+        ButtonStyle{QBrush(Clr::CLR_buttonBgDark_ON), pressed, QPen(Clr::CLR_buttonBorderDark_ON, BORDERWIDTH), Clr::CLR_buttonTextDark_ON} :
+        ButtonStyle{QBrush(Clr::CLR_buttonBgLight_ON), pressed, QPen(Clr::CLR_buttonBorderLight_ON, BORDERWIDTH), Clr::CLR_buttonTextLight_ON};
+    ButtonStyle buttonOff = dark ?
+        ButtonStyle{QBrush(Clr::CLR_buttonBgDark_OFF), pressed, QPen(Clr::CLR_buttonBorderDark_OFF, BORDERWIDTH), Clr::CLR_buttonTextDark_OFF} :
+        ButtonStyle{QBrush(Clr::CLR_buttonBgLight_OFF), pressed, QPen(Clr::CLR_buttonBorderLight_OFF, BORDERWIDTH), Clr::CLR_buttonTextLight_OFF};
+    pal.button = power ? buttonOn : buttonOff;
+    pal.powerButton = buttonOn;
+
+    /// Слайдер. В выключенном состоянии рамки у желоба нет.
+    if (power) {
+        pal.slider.groove = QBrush(dark ? Clr::CLR_sliderGrooveDark_ON : Clr::CLR_sliderGrooveLight_ON);
+        pal.slider.grooveBorder = QPen(dark ? Clr::CLR_sliderBorderDark_ON : Clr::CLR_sliderBorderLight_ON, BORDERWIDTH);
+        pal.slider.handle = QBrush(dark ? Clr::CLR_sliderHandleDark_ON : Clr::CLR_sliderHandleLight_ON);
+    } else {
+        pal.slider.groove = QBrush(dark ? Clr::CLR_sliderGrooveDark_OFF : Clr::CLR_sliderGrooveLight_OFF);
+        pal.slider.grooveBorder = QPen(Qt::NoPen);
+        pal.slider.handle = QBrush(dark ? Clr::CLR_sliderHandleDark_OFF : Clr::CLR_sliderHandleLight_OFF);
+    }
+    pal.slider.handleWidth = HANDLEWIDTH;
+
+    /// Корпус кондиционера и линия направления воздуха
+    pal.acBody = QBrush(power ?
+        (dark ? Clr::CLR_acBodyDark_ON : Clr::CLR_acBodyLight_ON) :
+        (dark ? Clr::CLR_acBodyDark_OFF : Clr::CLR_acBodyLight_OFF));
+    pal.acBodyPen = QPen(power ?
+        (dark ? Clr::CLR_borderDark_ON : Clr::CLR_borderLight_ON) :
+        (dark ? Clr::CLR_borderDark_OFF : Clr::CLR_borderLight_OFF), BORDERWIDTH);
+    pal.acLine = QPen(power ?
+        (dark ? Clr::CLR_acLineDark_ON : Clr::CLR_acLineLight_ON) :
+        (dark ? Clr::CLR_acLineDark_OFF : Clr::CLR_acLineLight_OFF), ACLINEWIDTH);
+    /// Графики истории рисуются цветом текста
+    pal.sparkline = QPen(pal.text, SPARKLINEWIDTH);
+    return pal;
+}
@@ -0,0 +1,99 @@
+/**
+* @file
+* @brief Заголовочный файл движка тем
+*
+* Таблицы цветов MainScene::ItemColor один раз собираются в готовые кисти, перья и цвета
+* для каждого состояния (тема, питание). Смена темы или питания сводится к выбору готовой палитры.
+*/
+#ifndef THEMEENGINE_H
+#define THEMEENGINE_H
+
+#include <QBrush>
+#include <QColor>
+#include <QPen>
+
+/**
+ * @struct ButtonStyle
+ * @brief Готовый стиль кнопки
+ */
+struct ButtonStyle {
+    /// Заливка кнопки
+    QBrush background;
+    /// Заливка нажатой кнопки
+    QBrush pressed;
+    /// Рамка кнопки
+    QPen border;
+    /// Цвет текста
+    QColor text;
+};
+
+/**
+ * @struct SliderStyle
+ * @brief Готовый стиль слайдера
+ */
+struct SliderStyle {
+    /// Заливка желоба
+    QBrush groove;
+    /// Рамка желоба (Qt::NoPen, если рамки нет)
+    QPen grooveBorder;
+    /// Заливка ручки
+    QBrush handle;
+    /// Ширина ручки
+    int handleWidth;
+};
+
+/**
+ * @struct ThemePalette
+ * @brief Готовая палитра одного состояния (тема, питание)
+ */
+struct ThemePalette {
+    /// Фон сцены
+    QBrush background;
+    /// Цвет текста
+    QColor text;
+    /// Цвет текста, который всегда отображается как "включенный" (подпись кнопки питания)
+    QColor textActive;
+    /// Стиль обычных кнопок
+    ButtonStyle button;
+    /// Стиль кнопки питания, она всегда доступна
+    ButtonStyle powerButton;
+    /// Стиль слайдера
+    SliderStyle slider;
+    /// Заливка корпуса кондиционера
+    QBrush acBody;
+    /// Рамка корпуса кондиционера
+    QPen acBodyPen;
+    /// Линия направления воздуха
+    QPen acLine;
+    /// Линия графиков истории
+    QPen sparkline;
+};
+
+/**
+ * @class ThemeEngine
+ * @brief Набор заранее собранных палитр
+ */
+class ThemeEngine
+{
+public:
+    /// Все палитры собираются в конструкторе
+    ThemeEngine();
+    /**
+     * @brief Палитра состояния
+     * @param dark тёмная тема
+     * @param power питание
+     */
+    const ThemePalette &palette(bool dark, bool power) const { return palettes[(dark ? 2 : 0) + (power ? 1 : 0)]; }
+
+private:
+    /// Палитры: светлая/выкл, светлая/вкл, тёмная/выкл, тёмная/вкл
+    ThemePalette palettes[4];
+    /**
+     * @brief Сборка палитры одного состояния
+     * @param dark тёмная тема
+     * @param power питание
+     */
+    static ThemePalette compile(bool dark, bool power);
+};
+
+#endif // THEMEENGINE_H
@@ -0,0 +1,75 @@
+#include "units.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define UNITS_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define UNITS_NEON
+#endif
+
+namespace Units {
+
+static_assert(Celsius{100}.to<TempUnit::Fahrenheit>().value == 212, "Celsius to Fahrenheit");
+static_assert(Celsius{0}.to<TempUnit::Kelvin>().value == 273.15, "Celsius to Kelvin");
+static_assert(MmHg{1}.to<PressureUnit::Pascal>().value == 133.322, "MmHg to Pascal");
+
+const QString &symbol(TempUnit unit)
+{
+    static const QString symbols[UnitTraits<TempUnit>::COUNT] = {
+        QString::fromUtf8(symbolUtf8(TempUnit::Celsius)),
+        QString::fromUtf8(symbolUtf8(TempUnit::Fahrenheit)),
+        QString::fromUtf8(symbolUtf8(TempUnit::Kelvin)),
+    };
+    return symbols[int(unit)];
+}
+
+const QString &symbol(PressureUnit unit)
+{
+    static const QString symbols[UnitTraits<PressureUnit>::COUNT] = {
+        QString::fromUtf8(symbolUtf8(PressureUnit::Pascal)),
+        QString::fromUtf8(symbolUtf8(PressureUnit::MmHg)),
+    };
+    return symbols[int(unit)];
+}
+
+void convert(const float *in, float *out, std::size_t n, const Affine &conv)
+{
+    const float scale = float(conv.scale);
+    const float offset = float(conv.offset);
+    std::size_t i = 0;
+#if defined(UNITS_SSE2)
+    const __m128 s = _mm_set1_ps(scale);
+    const __m128 o = _mm_set1_ps(offset);
+    for (; i + 4 <= n; i += 4)
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(in + i), s), o));
+#elif defined(UNITS_NEON)
+    const float32x4_t s = vdupq_n_f32(scale);
+    const float32x4_t o = vdupq_n_f32(offset);
+    for (; i + 4 <= n; i += 4)
+        vst1q_f32(out + i, vmlaq_f32(o, vld1q_f32(in + i), s));
+#endif
+    /// Остаток (или весь массив без SIMD)
+    for (; i < n; ++i)
+        out[i] = in[i] * scale + offset;
+}
+
+void convert(const double *in, double *out, std::size_t n, const Affine &conv)
+{
+    std::size_t i = 0;
+#if defined(UNITS_SSE2)
+    const __m128d s = _mm_set1_pd(conv.scale);
+    const __m128d o = _mm_set1_pd(conv.offset);
+    for (; i + 2 <= n; i += 2)
+        _mm_storeu_pd(out + i, _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(in + i), s), o));
+#elif defined(UNITS_NEON) && defined(__aarch64__)
+    const float64x2_t s = vdupq_n_f64(conv.scale);
+    const float64x2_t o = vdupq_n_f64(conv.offset);
+    for (; i + 2 <= n; i += 2)
+        vst1q_f64(out + i, vfmaq_f64(o, vld1q_f64(in + i), s));
+#endif
+    for (; i < n; ++i)
+        out[i] = conv.apply(in[i]);
+}
+
+}
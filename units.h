@@ -0,0 +1,134 @@
+/**
+* @file
+* @brief Заголовочный файл единиц измерения
+*
+* Единицы измерения - перечисления, а не строки. Перевод между единицами одной величины - линейная
+* функция value * scale + offset, коэффициенты которой хранятся в таблице и комбинируются при компиляции.
+* Для массивов значений есть пакетный перевод, использующий SSE2 или NEON, если они доступны.
+*/
+#ifndef UNITS_H
+#define UNITS_H
+
+#include <QtGlobal>
+#include <QString>
+#include <cstddef>
+
+namespace Units {
+
+/**
+ * @struct Affine
+ * @brief Линейное преобразование value * scale + offset
+ */
+struct Affine {
+    /// Множитель
+    double scale;
+    /// Смещение
+    double offset;
+
+    /// @brief Применение к значению
+    constexpr double apply(double value) const { return value * scale + offset; }
+    /// @brief Обратное преобразование
+    constexpr Affine inverse() const { return { 1.0 / scale, -offset / scale }; }
+    /// @brief Композиция: сначала это преобразование, затем next
+    constexpr Affine then(const Affine &next) const { return { scale * next.scale, offset * next.scale + next.offset }; }
+};
+
+/// Единицы измерения температуры. Базовая единица - °C.
+enum class TempUnit : quint8 { Celsius, Fahrenheit, Kelvin };
+/// Единицы измерения давления. Базовая единица - мм рт.ст.
+enum class PressureUnit : quint8 { Pascal, MmHg };
+
+/**
+ * @struct UnitTraits
+ * @brief Обозначения единиц и перевод из базовой единицы
+ * @tparam Unit Перечисление единиц одной величины
+ */
+template<typename Unit>
+struct UnitTraits;
+
+template<>
+struct UnitTraits<TempUnit> {
+    /// Количество единиц
+    static constexpr int COUNT = 3;
+    /// Обозначения, индекс - значение перечисления
+    static constexpr const char *SYMBOLS[COUNT] = { "°C", "°F", "°K" };
+    /// Перевод из °C
+    static constexpr Affine FROMBASE[COUNT] = { { 1.0, 0.0 }, { 9.0 / 5.0, 32.0 }, { 1.0, 273.15 } };
+};
+
+template<>
+struct UnitTraits<PressureUnit> {
+    /// Количество единиц
+    static constexpr int COUNT = 2;
+    /// Обозначения, индекс - значение перечисления
+    static constexpr const char *SYMBOLS[COUNT] = { "Pa", "мм" };
+    /// Перевод из мм рт.ст.
+    static constexpr Affine FROMBASE[COUNT] = { { 133.322, 0.0 }, { 1.0, 0.0 } };
+};
+
+/// @brief Перевод из базовой единицы
+template<typename Unit>
+constexpr Affine fromBase(Unit unit) { return UnitTraits<Unit>::FROMBASE[int(unit)]; }
+/// @brief Перевод из единицы from в единицу to
+template<typename Unit>
+constexpr Affine conversion(Unit from, Unit to) { return fromBase(from).inverse().then(fromBase(to)); }
+/// @brief Перевод значения из единицы from в единицу to
+template<typename Unit>
+constexpr double convert(double value, Unit from, Unit to) { return conversion(from, to).apply(value); }
+/// @brief Следующая единица по кругу (порядок переключения кнопкой)
+template<typename Unit>
+constexpr Unit next(Unit unit) { return Unit((int(unit) + 1) % UnitTraits<Unit>::COUNT); }
+/// @brief Обозначение единицы в UTF-8
+template<typename Unit>
+constexpr const char *symbolUtf8(Unit unit) { return UnitTraits<Unit>::SYMBOLS[int(unit)]; }
+/// @brief Обозначение единицы. Строки создаются один раз, вызов не выделяет память.
+const QString &symbol(TempUnit unit);
+/// @copydoc symbol(TempUnit)
+const QString &symbol(PressureUnit unit);
+
+/**
+ * @struct Quantity
+ * @brief Значение с единицей измерения, известной при компиляции
+ *
+ * Перевод между единицами при известных единицах вычисляется при компиляции:
+ * @code
+ * constexpr auto boiling = Quantity<TempUnit, TempUnit::Celsius>{100}.to<TempUnit::Fahrenheit>();
+ * static_assert(boiling.value == 212, "");
+ * @endcode
+ */
+template<typename Unit, Unit U>
+struct Quantity {
+    /// Значение
+    double value;
+    /// @brief Перевод в другую единицу той же величины
+    template<Unit V>
+    constexpr Quantity<Unit, V> to() const { return { convert(value, U, V) }; }
+};
+
+/// Температура в °C
+using Celsius = Quantity<TempUnit, TempUnit::Celsius>;
+/// Температура в °F
+using Fahrenheit = Quantity<TempUnit, TempUnit::Fahrenheit>;
+/// Температура в °K
+using Kelvin = Quantity<TempUnit, TempUnit::Kelvin>;
+/// Давление в Па
+using Pascal = Quantity<PressureUnit, PressureUnit::Pascal>;
+/// Давление в мм рт.ст.
+using MmHg = Quantity<PressureUnit, PressureUnit::MmHg>;
+
+/**
+ * @brief Пакетный перевод массива значений
+ *
+ * Использует SSE2 или NEON, если они доступны. in и out могут совпадать.
+ * @param in Исходные значения
+ * @param out Результат
+ * @param n Количество значений
+ * @param conv Преобразование
+ */
+void convert(const float *in, float *out, std::size_t n, const Affine &conv);
+/// @copydoc convert(const float*, float*, std::size_t, const Affine&)
+void convert(const double *in, double *out, std::size_t n, const Affine &conv);
+
+}
+
+#endif // UNITS_H
@@ -0,0 +1,90 @@
+#include "vaneanimator.h"
+#include <QGraphicsItem>
+#include <QTimer>
+#include <QtMath>
+
+VaneAnimator::VaneAnimator(QGraphicsItem *vane, qreal min, qreal max, QObject *parent)
+    : QObject(parent),
+    vane(vane),
+    timer(new QTimer(this)),
+    min(min),
+    max(max)
+{
+    timer->setTimerType(Qt::PreciseTimer);
+    timer->setInterval(FRAME);
+    connect(timer, &QTimer::timeout, this, &VaneAnimator::onFrame);
+}
+
+bool VaneAnimator::isActive() const
+{
+    return timer->isActive();
+}
+
+void VaneAnimator::setTarget(qreal angle)
+{
+    target = qBound(min, angle, max);
+    /// Поворот выполнится в ближайшем кадре; при качании цель понадобится после его выключения
+    if (!swinging && !qFuzzyCompare(target, current))
+        start();
+}
+
+void VaneAnimator::jumpTo(qreal angle)
+{
+    target = qBound(min, angle, max);
+    if (!swinging) {
+        timer->stop();
+        apply(target);
+    }
+}
+
+void VaneAnimator::setSwing(bool on)
+{
+    if (on == swinging)
+        return;
+    swinging = on;
+    if (swinging) {
+        /// Качание начинается с текущего угла, без скачка
+        qreal half = (max - min) / 2;
+        qreal ratio = half > 0 ? qBound(-1.0, (current - (min + half)) / half, 1.0) : 0;
+        phase = qAsin(ratio);
+    }
+    start();
+}
+
+void VaneAnimator::start()
+{
+    if (timer->isActive())
+        return;
+    sinceFrame.start();
+    timer->start();
+}
+
+void VaneAnimator::onFrame()
+{
+    qreal dt = qreal(sinceFrame.nsecsElapsed()) / 1e6;
+    sinceFrame.restart();
+
+    if (swinging) {
+        /// Синусоида: у краёв диапазона линия замедляется, как настоящая заслонка
+        phase = std::fmod(phase + dt * 2 * M_PI / SWING_PERIOD, 2 * M_PI);
+        qreal half = (max - min) / 2;
+        apply(min + half + half * qSin(phase));
+        return;
+    }
+
+    /// Экспоненциальное приближение к цели, не зависящее от частоты кадров
+    qreal diff = target - current;
+    if (qAbs(diff) <= EPSILON) {
+        apply(target);
+        timer->stop();
+        return;
+    }
+    apply(current + diff * (1 - qExp(-dt / EASING)));
+}
+
+void VaneAnimator::apply(qreal angle)
+{
+    current = angle;
+    /// Угол откладывается против часовой стрелки, rotation() - по часовой
+    vane->setRotation(-angle);
+}
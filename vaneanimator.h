@@ -0,0 +1,96 @@
+/**
+* @file
+* @brief Заголовочный файл анимации заслонки
+*
+* Линия направления воздуха не поворачивается на каждое событие слайдера: события только меняют
+* целевой угол, а поворот выполняется один раз за кадр и плавно догоняет цель. При качании угол
+* меняется по синусоиде во всём диапазоне. Поворот меняет только rotation() элемента, поэтому
+* перерисовывается лишь область линии, а не вся сцена.
+*/
+#ifndef VANEANIMATOR_H
+#define VANEANIMATOR_H
+
+#include <QObject>
+#include <QElapsedTimer>
+
+class QTimer;
+class QGraphicsItem;
+
+/**
+ * @class VaneAnimator
+ * @brief Покадровая анимация угла заслонки
+ *
+ * Таймер кадров работает, только пока линия движется. Шаг анимации считается по прошедшему
+ * времени, а не по количеству кадров, поэтому пропущенный кадр не замедляет движение.
+ */
+class VaneAnimator : public QObject
+{
+    Q_OBJECT
+public:
+    /// Интервал кадра, мс (60 кадров в секунду)
+    static constexpr int FRAME = 16;
+    /// Постоянная времени приближения к цели, мс: за это время остаётся треть расстояния
+    static constexpr qreal EASING = 60;
+    /// Период качания, мс
+    static constexpr int SWING_PERIOD = 4000;
+    /// Разница углов, при которой линия считается дошедшей до цели, градусы
+    static constexpr qreal EPSILON = 0.05;
+
+    /**
+     * @param vane Поворачиваемый элемент
+     * @param min Наименьший угол
+     * @param max Наибольший угол
+     * @param parent Родительский объект
+     */
+    VaneAnimator(QGraphicsItem *vane, qreal min, qreal max, QObject *parent = nullptr);
+    /**
+     * @brief Новый целевой угол
+     *
+     * Несколько вызовов между кадрами дают один поворот
+     * @param angle Угол в градусах
+     */
+    void setTarget(qreal angle);
+    /// @brief Поворот сразу на угол, без анимации
+    void jumpTo(qreal angle);
+    /**
+     * @brief Включение и выключение качания
+     *
+     * После выключения линия плавно возвращается к целевому углу
+     */
+    void setSwing(bool on);
+    /// @brief Качание включено
+    bool isSwinging() const { return swinging; }
+    /// @brief Текущий показанный угол
+    qreal angle() const { return current; }
+    /// @brief Анимация идёт (таймер кадров запущен)
+    bool isActive() const;
+
+private:
+    /// Поворачиваемый элемент
+    QGraphicsItem *vane;
+    /// Таймер кадров
+    QTimer *timer;
+    /// Время с предыдущего кадра
+    QElapsedTimer sinceFrame;
+    /// Наименьший угол
+    qreal min;
+    /// Наибольший угол
+    qreal max;
+    /// Целевой угол
+    qreal target = 0;
+    /// Показанный угол
+    qreal current = 0;
+    /// Фаза качания, радианы
+    qreal phase = 0;
+    /// Качание включено
+    bool swinging = false;
+
+    /// @brief Запуск таймера кадров, если он остановлен
+    void start();
+    /// @brief Один кадр анимации
+    void onFrame();
+    /// @brief Поворот элемента
+    void apply(qreal angle);
+};
+
+#endif // VANEANIMATOR_H